@@ -0,0 +1,184 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_ADSTRUCTURE_HPP
+#define LOOPP_BLE_ADSTRUCTURE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+namespace loopp
+{
+  namespace ble
+  {
+    enum class AdType : uint8_t
+    {
+      Flags = 0x01,
+      IncompleteServiceUuid16 = 0x02,
+      CompleteServiceUuid16 = 0x03,
+      ShortLocalName = 0x08,
+      CompleteLocalName = 0x09,
+      TxPowerLevel = 0x0A,
+      ServiceData16 = 0x16,
+      ManufacturerSpecific = 0xFF,
+    };
+
+    // Non-owning view of a single AD (length/type/value) structure. The data
+    // remains owned by the advertisement it was parsed from.
+    struct AdStructure
+    {
+      uint8_t type = 0;
+      const uint8_t *data = nullptr;
+      std::size_t size = 0;
+
+      bool is(AdType t) const
+      {
+        return type == static_cast<uint8_t>(t);
+      }
+
+      // Company identifier of manufacturer specific data, or service UUID of service data.
+      bool get_uint16(std::size_t offset, uint16_t &value) const
+      {
+        if (offset + 2 > size)
+          {
+            return false;
+          }
+        value = static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+        return true;
+      }
+    };
+
+    // Walks the AD structures of an advertisement exactly once. Iteration
+    // stops at the end of the data, at a zero length structure (padding), or
+    // at a structure whose length runs past the end of the data.
+    class AdParser
+    {
+    public:
+      class iterator
+      {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = AdStructure;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const AdStructure *;
+        using reference = const AdStructure &;
+
+        iterator() = default;
+
+        iterator(const uint8_t *pos, const uint8_t *end)
+          : pos(pos)
+          , end(end)
+        {
+          parse();
+        }
+
+        reference operator*() const
+        {
+          return current;
+        }
+
+        pointer operator->() const
+        {
+          return &current;
+        }
+
+        iterator &operator++()
+        {
+          pos = current.data + current.size;
+          parse();
+          return *this;
+        }
+
+        iterator operator++(int)
+        {
+          iterator tmp = *this;
+          ++(*this);
+          return tmp;
+        }
+
+        bool operator==(const iterator &other) const
+        {
+          return pos == other.pos;
+        }
+
+        bool operator!=(const iterator &other) const
+        {
+          return pos != other.pos;
+        }
+
+      private:
+        void parse()
+        {
+          if (pos == nullptr || pos >= end)
+            {
+              pos = nullptr;
+              return;
+            }
+
+          std::size_t length = pos[0];
+          if (length == 0 || length > static_cast<std::size_t>(end - pos - 1))
+            {
+              pos = nullptr;
+              return;
+            }
+
+          current.type = pos[1];
+          current.data = pos + 2;
+          current.size = length - 1;
+        }
+
+      private:
+        const uint8_t *pos = nullptr;
+        const uint8_t *end = nullptr;
+        AdStructure current;
+      };
+
+      AdParser(const uint8_t *data, std::size_t size)
+        : data(data)
+        , size(size)
+      {
+      }
+
+      explicit AdParser(const std::string &adv_data)
+        : data(reinterpret_cast<const uint8_t *>(adv_data.data()))
+        , size(adv_data.size())
+      {
+      }
+
+      iterator begin() const
+      {
+        return iterator(data, data + size);
+      }
+
+      iterator end() const
+      {
+        return iterator();
+      }
+
+    private:
+      const uint8_t *data;
+      std::size_t size;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_ADSTRUCTURE_HPP
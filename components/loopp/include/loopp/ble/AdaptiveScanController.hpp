@@ -0,0 +1,139 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_ADAPTIVESCANCONTROLLER_HPP
+#define LOOPP_BLE_ADAPTIVESCANCONTROLLER_HPP
+
+#include <cstdint>
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Chooses the scan interval, scan window and publish period from what
+    // the scanner observes:
+    //
+    //   {
+    //     "min_duty": 0.1, "max_duty": 1.0,
+    //     "min_interval": 80, "max_interval": 800,
+    //     "min_period": 1000, "max_period": 10000,
+    //     "target_records": 100, "quiet_rate": 5,
+    //     "max_queue": 500, "max_backlog": 16384
+    //   }
+    //
+    // Intervals and windows are in units of 0.625 ms, as in scan_interval
+    // and scan_window. Periods are in milliseconds.
+    //
+    // The duty cycle (window / interval) is lowered when the area is quiet,
+    // when nearly every advertisement comes from a device that was already
+    // seen (sampling less still sees every device), or when the scanner
+    // produces more than the uplink can handle. It is raised while new
+    // devices keep appearing. Low duty cycles use longer intervals, so
+    // that the radio switches channels less often.
+    //
+    // The publish period is chosen so that a batch holds about
+    // target_records records, and is doubled while the uplink is congested.
+    class AdaptiveScanController
+    {
+    public:
+      enum class State
+      {
+        Steady,
+        Quiet,
+        Discovering,
+        Saturated,
+        Congested,
+      };
+
+      struct Observation
+      {
+        // Advertisements per second received at the current duty cycle.
+        float adv_rate = 0.0f;
+        // Fraction of advertisements from devices already seen in the same
+        // observation period.
+        float duplicate_ratio = 0.0f;
+        std::size_t queue_depth = 0;
+        std::size_t send_backlog = 0;
+      };
+
+      struct Decision
+      {
+        uint16_t scan_interval = 0;
+        uint16_t scan_window = 0;
+        uint32_t publish_period = 0;
+      };
+
+      explicit AdaptiveScanController(const nlohmann::json &config);
+
+      // Returns true if the scan interval or window changed enough to be
+      // worth restarting the scan for. Changes of the publish period can
+      // be applied at any time.
+      bool update(const Observation &observation);
+
+      const Decision &get_decision() const
+      {
+        return decision;
+      }
+
+      State get_state() const
+      {
+        return state;
+      }
+
+      // Duty cycle of the current decision.
+      float get_duty_cycle() const
+      {
+        return static_cast<float>(decision.scan_window) / decision.scan_interval;
+      }
+
+      // Estimated advertisement rate at a 100% duty cycle.
+      float get_ambient_rate() const
+      {
+        return ambient_rate < 0.0f ? 0.0f : ambient_rate;
+      }
+
+      static const char *state_name(State state);
+
+    private:
+      void compute_scan_params(uint16_t &interval, uint16_t &window) const;
+
+    private:
+      float min_duty = 0.1f;
+      float max_duty = 1.0f;
+      uint16_t min_interval = 80;
+      uint16_t max_interval = 800;
+      uint32_t min_period = 1000;
+      uint32_t max_period = 10000;
+      float target_records = 100.0f;
+      float quiet_rate = 5.0f;
+      std::size_t max_queue = 500;
+      std::size_t max_backlog = 16384;
+
+      State state = State::Steady;
+      float duty = 1.0f;
+      float ambient_rate = -1.0f;
+      Decision decision;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_ADAPTIVESCANCONTROLLER_HPP
@@ -22,8 +22,10 @@
 #define LOOPP_BLE_DECODER_HPP
 
 #include <string>
-#include <list>
+#include <memory>
+#include <vector>
 
+#include "loopp/ble/AdStructure.hpp"
 #include "loopp/utils/json.hpp"
 
 namespace loopp
@@ -33,8 +35,11 @@ namespace loopp
     class Decoder
     {
     public:
-      ~Decoder() = default;
-      virtual void decode(const std::string &adv_data, nlohmann::json &info) const = 0;
+      virtual ~Decoder() = default;
+
+      // Decodes a single AD structure the decoder registered for. Returns
+      // true if the structure was recognized and info was updated.
+      virtual bool decode(const AdStructure &ad, nlohmann::json &info) const = 0;
     };
 
     class AdvertisementDecoder
@@ -43,10 +48,23 @@ namespace loopp
       AdvertisementDecoder();
       ~AdvertisementDecoder() = default;
 
-      void decode(const std::string &adv_data, nlohmann::json &info);
+      void add_decoder(AdType type, std::shared_ptr<Decoder> decoder);
+      void add_manufacturer_decoder(uint16_t company_id, std::shared_ptr<Decoder> decoder);
+      void add_service_data_decoder(uint16_t uuid, std::shared_ptr<Decoder> decoder);
+
+      bool decode(const std::string &adv_data, nlohmann::json &info) const;
+      bool decode(const uint8_t *adv_data, std::size_t size, nlohmann::json &info) const;
 
     private:
-      std::list<std::shared_ptr<Decoder>> decoders;
+      struct Registration
+      {
+        uint16_t key;
+        std::shared_ptr<Decoder> decoder;
+      };
+
+      std::vector<Registration> type_decoders;
+      std::vector<Registration> manufacturer_decoders;
+      std::vector<Registration> service_data_decoders;
     };
   } // namespace ble
 } // namespace loopp
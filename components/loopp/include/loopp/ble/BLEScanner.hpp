@@ -21,6 +21,8 @@
 #ifndef LOOPP_BLE_BLE__SCANNER_HPP
 #define LOOPP_BLE_BLE__SCANNER_HPP
 
+#include <atomic>
+#include <memory>
 #include <string>
 
 #include "esp_gap_ble_api.h"
@@ -29,7 +31,13 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 
+#include "loopp/ble/ScanCoverage.hpp"
+#include "loopp/ble/ScanFilter.hpp"
+#include "loopp/core/Mutex.hpp"
+#include "loopp/core/RadioCoordinator.hpp"
+#include "loopp/core/Semaphore.hpp"
 #include "loopp/core/Signal.hpp"
+#include "loopp/core/Task.hpp"
 
 namespace loopp
 {
@@ -43,7 +51,7 @@ namespace loopp
       struct ScanResult
       {
         ScanResult() = default;
-        ScanResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *scan_result);
+        ScanResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *scan_result, int64_t timestamp);
 
         std::string bda_as_string();
 
@@ -51,6 +59,10 @@ namespace loopp
         uint8_t bda[6];
         std::string adv_data;
         int rssi;
+        // esp_ble_addr_type_t of bda.
+        uint8_t ble_addr_type = 0;
+        // Receive time in microseconds since boot (esp_timer_get_time).
+        int64_t timestamp = 0;
       };
 
       BLEScanner(const BLEScanner &) = delete;
@@ -65,11 +77,43 @@ namespace loopp
       void set_scan_type(ScanType type);
       void set_scan_interval(uint16_t interval);
       void set_scan_window(uint16_t window);
+
+      // Duration of a single scan in seconds. A bounded scan is restarted
+      // as soon as it completes. 0 scans continuously without restarts.
+      void set_scan_duration(uint32_t duration);
+
+      // Changes the scan interval and window. If scanning, the scan is
+      // stopped and restarted with the new parameters.
+      void update_scan_params(uint16_t interval, uint16_t window);
+
+      // The Bluetooth controller and Bluedroid are initialized when
+      // scanning starts for the first time. prepare() initializes them in
+      // a background task instead, in parallel with e.g. WiFi association;
+      // start() then waits for that task if it has not finished yet.
+      void prepare();
+      bool is_initialized() const;
+
       void start();
       void stop();
 
+      // Replaces the advertisement filter. Safe to call while scanning; the
+      // Bluetooth task picks up the new filter on the next advertisement.
+      void set_scan_filter(std::shared_ptr<const ScanFilter> filter);
+
+      struct FilterStats
+      {
+        uint32_t accepted = 0;
+        uint32_t rejected = 0;
+      };
+
+      FilterStats get_filter_stats() const;
+
+      // Scan-on duty cycle and restart gaps since the previous call. Time
+      // paused by the RadioCoordinator counts as a gap.
+      ScanCoverage::Report get_scan_coverage();
+
       loopp::core::Signal<void()> &scan_complete_signal();
-      loopp::core::Signal<void(ScanResult)> &scan_result_signal();
+      loopp::core::Signal<void(const ScanResult &)> &scan_result_signal();
 
     private:
       BLEScanner();
@@ -79,17 +123,35 @@ namespace loopp
       void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
 
       void init();
+      void ensure_initialized();
       void deinit();
       void bt_task();
 
+      void on_radio_mode();
+      esp_ble_scan_params_t effective_scan_params();
+
     private:
       loopp::core::Signal<void(void)> signal_scan_complete;
-      loopp::core::Signal<void(ScanResult)> signal_scan_result;
+      loopp::core::Signal<void(const ScanResult &)> signal_scan_result;
 
       mutable loopp::core::Mutex mutex;
+      loopp::core::Mutex init_mutex;
+      std::atomic<bool> initialized{ false };
+      std::unique_ptr<loopp::core::Task> init_task;
+      // Given by the init task once it no longer holds init_mutex.
+      loopp::core::Semaphore init_done{ 1, 0 };
       esp_ble_scan_params_t ble_scan_params;
-
-      const static int scan_duration = 30;
+      std::shared_ptr<const ScanFilter> scan_filter;
+      std::atomic<uint32_t> filter_accepted{ 0 };
+      std::atomic<uint32_t> filter_rejected{ 0 };
+
+      ScanCoverage coverage;
+      uint32_t scan_duration = 30;
+      std::atomic<bool> scanning{ false };
+      std::atomic<bool> restart_pending{ false };
+      std::atomic<bool> paused{ false };
+      std::atomic<bool> reduced{ false };
+      loopp::core::ScopedConnection radio_mode_connection;
     };
   } // namespace ble
 } // namespace loopp
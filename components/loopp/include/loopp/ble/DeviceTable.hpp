@@ -0,0 +1,364 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_DEVICETABLE_HPP
+#define LOOPP_BLE_DEVICETABLE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Same values as esp_ble_addr_type_t.
+    enum class AddressType : uint8_t
+    {
+      Public = 0,
+      Random = 1,
+      RpaPublic = 2,
+      RpaRandom = 3,
+    };
+
+    // Fixed capacity hash table keyed by Bluetooth device address and
+    // address type.
+    //
+    // Entries are stored in a single flat vector using open addressing with
+    // linear probing. Removal uses backward shift deletion, so no tombstones
+    // are left behind and lookups stay short as devices come and go.
+    //
+    // When the table is full, a CLOCK sweep evicts a device that has not
+    // been seen recently. Phones rotate their private addresses every few
+    // minutes, so each rotation looks like a new device. To keep such
+    // churn from pushing out stable devices, private addresses may only
+    // occupy private_limit entries. Once that limit is reached a new
+    // private address evicts another private address. Stable devices (public
+    // and static random addresses) also survive one more sweep of the clock
+    // hand than private ones.
+    template<typename T>
+    class DeviceTable
+    {
+    public:
+      using clock = std::chrono::steady_clock;
+
+      struct Stats
+      {
+        std::uint32_t inserts = 0;
+        std::uint32_t evictions = 0;
+        std::uint32_t private_evictions = 0;
+        std::uint32_t expirations = 0;
+      };
+
+      explicit DeviceTable(std::size_t capacity = 128)
+      {
+        std::size_t size = 8;
+        while (size < capacity + capacity / 4)
+          {
+            size <<= 1;
+          }
+        entries.resize(size);
+        mask = size - 1;
+        max_size = capacity;
+        private_limit = capacity;
+      }
+
+      ~DeviceTable() = default;
+      DeviceTable(const DeviceTable &) = delete;
+      DeviceTable &operator=(const DeviceTable &) = delete;
+
+      static std::uint64_t make_key(const uint8_t bda[6], AddressType type = AddressType::Public)
+      {
+        std::uint64_t key = static_cast<std::uint64_t>(type);
+        for (int i = 0; i < 6; i++)
+          {
+            key = (key << 8) | bda[i];
+          }
+        return key;
+      }
+
+      // Resolvable and non-resolvable private addresses change over time;
+      // public and static random addresses do not.
+      static bool is_private(const uint8_t bda[6], AddressType type)
+      {
+        switch (type)
+          {
+          case AddressType::Public:
+            return false;
+          case AddressType::Random:
+            return (bda[0] & 0xc0) != 0xc0;
+          default:
+            return true;
+          }
+      }
+
+      // Maximum number of entries with a private address.
+      void set_private_limit(std::size_t limit)
+      {
+        private_limit = limit;
+      }
+
+      // Called with each device that is evicted to make room, just before
+      // it is removed.
+      void set_evict_handler(std::function<void(const T &)> handler)
+      {
+        evict_handler = std::move(handler);
+      }
+
+      T *find(const uint8_t bda[6], AddressType type = AddressType::Public)
+      {
+        std::size_t index = 0;
+        return lookup(make_key(bda, type), index) ? &entries[index].value : nullptr;
+      }
+
+      // Returns the entry for bda, creating a default constructed one if the
+      // device is not yet known. Evicts a device if the table is full.
+      // Returns nullptr only if the table has no capacity.
+      T *insert(const uint8_t bda[6], clock::time_point now, bool *created = nullptr, AddressType type = AddressType::Public)
+      {
+        std::uint64_t key = make_key(bda, type);
+        bool priv = is_private(bda, type);
+        std::size_t index = 0;
+
+        bool found = lookup(key, index);
+        if (!found)
+          {
+            if (max_size == 0 || (priv && private_limit == 0))
+              {
+                return nullptr;
+              }
+
+            if (priv && private_count >= private_limit)
+              {
+                evict(true);
+                lookup(key, index);
+              }
+            else if (count >= max_size)
+              {
+                evict(false);
+                lookup(key, index);
+              }
+
+            entries[index].used = true;
+            entries[index].key = key;
+            entries[index].is_private = priv;
+            entries[index].value = T();
+            count++;
+            private_count += priv ? 1 : 0;
+            stats.inserts++;
+          }
+
+        if (created != nullptr)
+          {
+            *created = !found;
+          }
+        entries[index].last_seen = now;
+        entries[index].referenced = entries[index].is_private ? 1 : 2;
+        return &entries[index].value;
+      }
+
+      void erase(const uint8_t bda[6], AddressType type = AddressType::Public)
+      {
+        std::size_t index = 0;
+        if (lookup(make_key(bda, type), index))
+          {
+            erase_at(index);
+          }
+      }
+
+      // Removes all devices that have not been seen for max_age.
+      std::size_t expire(clock::time_point now, clock::duration max_age)
+      {
+        std::size_t expired = 0;
+        std::size_t index = 0;
+        while (index < entries.size())
+          {
+            if (entries[index].used && now - entries[index].last_seen > max_age)
+              {
+                // Backward shift may move an unvisited entry into this slot.
+                erase_at(index);
+                expired++;
+              }
+            else
+              {
+                index++;
+              }
+          }
+        stats.expirations += expired;
+        return expired;
+      }
+
+      template<typename F>
+      void for_each(F f)
+      {
+        for (auto &e : entries)
+          {
+            if (e.used)
+              {
+                f(e.key, e.value);
+              }
+          }
+      }
+
+      template<typename F>
+      void for_each(F f) const
+      {
+        for (const auto &e : entries)
+          {
+            if (e.used)
+              {
+                f(e.key, e.value);
+              }
+          }
+      }
+
+      void clear()
+      {
+        for (auto &e : entries)
+          {
+            e.used = false;
+          }
+        count = 0;
+        private_count = 0;
+      }
+
+      std::size_t size() const
+      {
+        return count;
+      }
+
+      std::size_t private_size() const
+      {
+        return private_count;
+      }
+
+      std::size_t capacity() const
+      {
+        return max_size;
+      }
+
+      const Stats &get_stats() const
+      {
+        return stats;
+      }
+
+      void reset_stats()
+      {
+        stats = Stats();
+      }
+
+    private:
+      struct Entry
+      {
+        bool used = false;
+        bool is_private = false;
+        uint8_t referenced = 0;
+        std::uint64_t key = 0;
+        clock::time_point last_seen;
+        T value;
+      };
+
+      std::size_t home(std::uint64_t key) const
+      {
+        // Fibonacci hashing spreads the vendor prefix and the random part of the address.
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+      }
+
+      bool lookup(std::uint64_t key, std::size_t &index) const
+      {
+        index = home(key);
+        while (entries[index].used)
+          {
+            if (entries[index].key == key)
+              {
+                return true;
+              }
+            index = (index + 1) & mask;
+          }
+        return false;
+      }
+
+      // CLOCK sweep. Every visit of the hand ages an entry; an entry that was
+      // not seen since it was last aged to zero is evicted. The reference
+      // count is at most 2, so this ends within three rotations.
+      void evict(bool private_only)
+      {
+        for (;;)
+          {
+            Entry &e = entries[hand];
+            if (e.used && (!private_only || e.is_private))
+              {
+                if (e.referenced == 0)
+                  {
+                    stats.evictions++;
+                    stats.private_evictions += e.is_private ? 1 : 0;
+                    if (evict_handler)
+                      {
+                        evict_handler(e.value);
+                      }
+                    erase_at(hand);
+                    return;
+                  }
+                e.referenced--;
+              }
+            hand = (hand + 1) & mask;
+          }
+      }
+
+      void erase_at(std::size_t index)
+      {
+        private_count -= entries[index].is_private ? 1 : 0;
+        entries[index].used = false;
+        entries[index].value = T();
+        count--;
+
+        std::size_t hole = index;
+        std::size_t next = (index + 1) & mask;
+        while (entries[next].used)
+          {
+            std::size_t ideal = home(entries[next].key);
+            // Move the entry into the hole if the hole lies on its probe path.
+            if (((next - ideal) & mask) >= ((next - hole) & mask))
+              {
+                entries[hole] = std::move(entries[next]);
+                entries[next].used = false;
+                entries[next].value = T();
+                hole = next;
+              }
+            next = (next + 1) & mask;
+          }
+      }
+
+    private:
+      std::vector<Entry> entries;
+      std::size_t mask = 0;
+      std::size_t max_size = 0;
+      std::size_t count = 0;
+      std::size_t private_limit = 0;
+      std::size_t private_count = 0;
+      std::size_t hand = 0;
+      Stats stats;
+      std::function<void(const T &)> evict_handler;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_DEVICETABLE_HPP
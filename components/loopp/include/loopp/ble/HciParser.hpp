@@ -0,0 +1,83 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_HCIPARSER_HPP
+#define LOOPP_BLE_HCIPARSER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "loopp/ble/BLEScanner.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Extracts advertisements from HCI traffic, independent of the host
+    // stack. feed() accepts an H4 (UART transport) byte stream in chunks of
+    // any size: packets are reassembled across chunks and everything that
+    // is not an LE Advertising Report or LE Extended Advertising Report
+    // event is skipped. A byte that cannot start a packet is dropped, so the
+    // parser resynchronizes after line noise.
+    class HciParser
+    {
+    public:
+      struct Stats
+      {
+        uint32_t packets = 0;
+        uint32_t reports = 0;
+        uint32_t malformed = 0;
+        uint32_t resyncs = 0;
+      };
+
+      // Appends the advertisements in the stream to results, with the given
+      // receive timestamp.
+      void feed(const uint8_t *data, std::size_t size, int64_t timestamp, std::vector<BLEScanner::ScanResult> &results);
+
+      // Parses a single HCI event packet, without H4 packet indicator.
+      // Returns false if the event is truncated or inconsistent.
+      static bool parse_event(const uint8_t *event,
+                              std::size_t size,
+                              int64_t timestamp,
+                              std::vector<BLEScanner::ScanResult> &results,
+                              uint32_t *reports = nullptr);
+
+      // Discards a partially received packet.
+      void reset();
+
+      const Stats &get_stats() const
+      {
+        return stats;
+      }
+
+    private:
+      void process(const uint8_t *packet, std::size_t size, int64_t timestamp, std::vector<BLEScanner::ScanResult> &results);
+
+      static std::size_t header_size(uint8_t indicator);
+      static std::size_t packet_size(const uint8_t *header);
+
+    private:
+      std::vector<uint8_t> packet;
+      Stats stats;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_HCIPARSER_HPP
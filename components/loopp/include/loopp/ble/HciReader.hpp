@@ -0,0 +1,80 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_HCIREADER_HPP
+#define LOOPP_BLE_HCIREADER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/HciParser.hpp"
+#include "loopp/ble/ScanSource.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Reads advertisements from captured HCI traffic: a btsnoop file (as
+    // written by btmon, Android and Wireshark) or a raw H4 byte stream from
+    // a file, pipe or UART device. The format is detected from the first
+    // bytes.
+    //
+    // btsnoop records keep their capture timestamps. Raw H4 carries no
+    // timestamps, so results get the time they were read. Reading a pipe
+    // blocks until data arrives.
+    class HciReader : public ScanSource
+    {
+    public:
+      explicit HciReader(const std::string &path);
+      ~HciReader() override;
+
+      HciReader(const HciReader &) = delete;
+      HciReader &operator=(const HciReader &) = delete;
+
+      bool next(BLEScanner::ScanResult &result) override;
+      void rewind() override;
+
+      const HciParser::Stats &get_stats() const
+      {
+        return parser.get_stats();
+      }
+
+    private:
+      void read_header();
+      bool fill();
+      bool fill_btsnoop();
+      bool read(uint8_t *buffer, std::size_t size);
+
+    private:
+      std::string path;
+      int fd = -1;
+      bool btsnoop = false;
+      uint32_t datalink = 0;
+      HciParser parser;
+      std::vector<uint8_t> buffer;
+      std::vector<BLEScanner::ScanResult> pending;
+      std::size_t pending_pos = 0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_HCIREADER_HPP
@@ -0,0 +1,120 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_LOADGENERATOR_HPP
+#define LOOPP_BLE_LOADGENERATOR_HPP
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/DeviceTable.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Generates synthetic advertisements of a population of virtual devices
+    // for stress tests:
+    //
+    //   {
+    //     "seed": 1,
+    //     "ibeacons": { "count": 50, "interval_ms": 100 },
+    //     "phones": { "count": 200, "interval_ms": 250, "rotate_s": 900 },
+    //     "crowds": { "count": 500, "interval_ms": 200, "period_s": 60, "duration_s": 10 },
+    //     "rssi": { "power": -59, "path_loss_exponent": 2.0, "noise": 4.0, "max_distance": 30 }
+    //   }
+    //
+    // iBeacons advertise at a fixed rate from a fixed address. Phones
+    // advertise with a random resolvable private address that changes every
+    // rotate_s seconds. Crowd devices only appear for duration_s out of every
+    // period_s seconds, each time with a fresh address. Every device moves
+    // slowly at random and its RSSI follows a log-distance path loss model
+    // with gaussian noise.
+    class LoadGenerator
+    {
+    public:
+      explicit LoadGenerator(const nlohmann::json &config);
+
+      // Starts the timeline of all devices at the given time (us).
+      void start(int64_t now);
+
+      // Time of the next advertisement (us).
+      int64_t next_time() const;
+
+      // Produces the next advertisement, in time order.
+      void next(BLEScanner::ScanResult &result);
+
+      std::size_t get_device_count() const;
+
+      // Average number of advertisements per second of the configured population.
+      double get_nominal_rate() const;
+
+    private:
+      enum class Kind : uint8_t
+      {
+        IBeacon,
+        Phone,
+        Crowd
+      };
+
+      struct Device
+      {
+        Kind kind;
+        uint8_t bda[6];
+        uint16_t major;
+        uint16_t minor;
+        float distance;
+        int64_t interval;
+        int64_t next_time;
+        int64_t rotate_time;
+      };
+
+      void add_devices(Kind kind, const nlohmann::json &config);
+      void randomize_address(Device &device);
+      int64_t jitter(int64_t interval);
+      int sample_rssi(Device &device);
+      void encode_adv_data(const Device &device, std::string &adv_data);
+      void reschedule(Device &device);
+
+    private:
+      using Event = std::pair<int64_t, uint32_t>;
+
+      std::mt19937 rng;
+      std::vector<Device> devices;
+      std::vector<Event> queue;
+      int64_t rotate_interval = 900 * 1000000LL;
+      int64_t crowd_period = 60 * 1000000LL;
+      int64_t crowd_duration = 10 * 1000000LL;
+      int64_t start_time = 0;
+      int power = -59;
+      float path_loss_exponent = 2.0f;
+      float noise = 4.0f;
+      float max_distance = 30.0f;
+      double nominal_rate = 0.0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_LOADGENERATOR_HPP
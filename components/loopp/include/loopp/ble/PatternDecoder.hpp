@@ -0,0 +1,116 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_PATTERNDECODER_HPP
+#define LOOPP_BLE_PATTERNDECODER_HPP
+
+#include <string>
+#include <vector>
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Decoder for proprietary sensor tags, defined at provisioning time:
+    //
+    //   {
+    //     "name": "ruuvi",
+    //     "company_id": 1177,                     // or "service_uuid": "fe95"
+    //     "match": [ { "offset": 0, "mask": "ff", "value": "05" } ],
+    //     "fields": [ { "name": "temperature", "offset": 1, "width": 2,
+    //                   "endian": "big", "signed": true, "scale": 0.005 } ]
+    //   }
+    //
+    // Offsets are relative to the payload following the company ID or
+    // service UUID. All definitions are compiled into one flat table sorted by
+    // company ID/service UUID, so matching an advertisement is a binary
+    // search followed by byte compares, without any allocation.
+    class PatternDecoder : public Decoder
+    {
+    public:
+      PatternDecoder() = default;
+      explicit PatternDecoder(const nlohmann::json &config);
+
+      void add(const nlohmann::json &definition);
+      void compile();
+
+      bool decode(const AdStructure &ad, nlohmann::json &info) const override;
+
+      std::size_t size() const;
+
+    private:
+      enum class Source : uint8_t
+      {
+        Manufacturer,
+        ServiceData
+      };
+
+      struct Pattern
+      {
+        Source source;
+        uint16_t id;
+        uint16_t min_size;
+        uint16_t first_match;
+        uint16_t match_count;
+        uint16_t first_field;
+        uint16_t field_count;
+        uint16_t name;
+      };
+
+      struct Match
+      {
+        uint16_t offset;
+        uint16_t length;
+        uint16_t bytes; // Index in byte pool: mask followed by value.
+      };
+
+      struct Field
+      {
+        uint16_t offset;
+        uint8_t width;
+        bool big_endian;
+        bool is_signed;
+        float scale;
+        float bias;
+        uint16_t name;
+      };
+
+      static std::vector<uint8_t> parse_hex(const std::string &hex);
+      static uint16_t parse_id(const nlohmann::json &value);
+      static int parse_int(const nlohmann::json &value, int min, int max, const std::string &what);
+
+      bool matches(const Pattern &pattern, const uint8_t *payload, std::size_t size) const;
+      void extract(const Pattern &pattern, const uint8_t *payload, nlohmann::json &info) const;
+
+    private:
+      std::vector<Pattern> patterns;
+      std::vector<Match> matches_table;
+      std::vector<Field> fields;
+      std::vector<uint8_t> bytes;
+      std::vector<std::string> names;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_PATTERNDECODER_HPP
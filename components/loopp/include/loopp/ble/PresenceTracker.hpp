@@ -0,0 +1,129 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_PRESENCETRACKER_HPP
+#define LOOPP_BLE_PRESENCETRACKER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "loopp/ble/DeviceTable.hpp"
+#include "loopp/ble/RssiFilter.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Decides whether devices are in range, with hysteresis so that a
+    // device hovering around the edge of the range does not flap.
+    //
+    // A device enters when its filtered RSSI reaches enter_rssi, and exits
+    // when the filtered RSSI drops below exit_rssi, when it has not been
+    // seen for the absence timeout, or when it is evicted from the full
+    // device table. While present, a change event is only
+    // reported when the RSSI moved at least change_threshold dB since the
+    // last reported value. A stationary device therefore produces a single
+    // enter event and nothing else.
+    //
+    // All times are monotonic microseconds (esp_timer_get_time). The tracker
+    // has no timers of its own; the owner calls expire() at next_deadline().
+    class PresenceTracker
+    {
+    public:
+      enum class EventType
+      {
+        Enter,
+        Exit,
+        Change,
+      };
+
+      struct Event
+      {
+        EventType type = EventType::Enter;
+        uint8_t bda[6] = { 0 };
+        AddressType addr_type = AddressType::Public;
+        float rssi = 0.0f;
+        std::int64_t timestamp = 0;
+        // Set for an exit caused by the absence timeout.
+        bool timed_out = false;
+        // Set for an exit caused by eviction from the device table.
+        bool evicted = false;
+      };
+
+      struct Device
+      {
+        uint8_t bda[6];
+        AddressType addr_type;
+        RssiFilter::State filter;
+        float reported_rssi = 0.0f;
+        std::int64_t last_seen = 0;
+        bool present = false;
+      };
+
+      explicit PresenceTracker(const nlohmann::json &config);
+
+      void update(const uint8_t bda[6], AddressType addr_type, int rssi, std::int64_t now, std::vector<Event> &events);
+
+      // Reports an exit for all present devices that were not seen during
+      // the absence timeout, and forgets about them.
+      void expire(std::int64_t now, std::vector<Event> &events);
+
+      // Time at which the earliest device times out, or 0 if no devices
+      // are tracked.
+      std::int64_t next_deadline() const;
+
+      std::size_t present_count() const;
+
+      template<typename F>
+      void for_each_present(F f) const
+      {
+        devices.for_each([&f](std::uint64_t, const Device &device) {
+          if (device.present)
+            {
+              f(device);
+            }
+        });
+      }
+
+      std::int64_t get_timeout() const
+      {
+        return timeout_us;
+      }
+
+    private:
+      static Event make_event(EventType type, const Device &device, std::int64_t now);
+
+    private:
+      RssiFilter filter;
+      DeviceTable<Device> devices;
+      // Present devices evicted by the current update.
+      std::vector<Device> evicted;
+      float enter_rssi = -80.0f;
+      float exit_rssi = -90.0f;
+      float change_threshold = 6.0f;
+      std::uint32_t min_samples = 2;
+      std::int64_t timeout_us = 30 * 1000000LL;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_PRESENCETRACKER_HPP
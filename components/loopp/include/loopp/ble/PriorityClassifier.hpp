@@ -0,0 +1,86 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_PRIORITYCLASSIFIER_HPP
+#define LOOPP_BLE_PRIORITYCLASSIFIER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Recognizes advertisements that must not wait for the next batch, such
+    // as panic buttons and asset alarms:
+    //
+    //   [
+    //     { "ibeacon_uuid": "f7826da6-4fa2-4e98-8024-bc5b71e0893e", "major": 100 },
+    //     { "ibeacon_uuid": "f7826da6-4fa2-4e98-8024-bc5b71e0893e", "major": 7, "minor": 12 },
+    //     { "company_id": "0499", "offset": 3, "mask": 1, "value": 1 }
+    //   ]
+    //
+    // An iBeacon rule matches on the UUID and, if given, the major and minor
+    // numbers. A manufacturer rule matches on the company ID and, if an offset
+    // is given, on (byte & mask) == value, where offset counts from the first
+    // byte after the company ID. An advertisement has priority if any rule
+    // matches.
+    class PriorityClassifier
+    {
+    public:
+      PriorityClassifier() = default;
+      explicit PriorityClassifier(const nlohmann::json &config);
+
+      bool match(const uint8_t *adv_data, std::size_t size) const;
+
+      bool empty() const
+      {
+        return ibeacon_rules.empty() && manufacturer_rules.empty();
+      }
+
+    private:
+      struct IBeaconRule
+      {
+        std::array<uint8_t, 16> uuid;
+        int major = -1;
+        int minor = -1;
+      };
+
+      struct ManufacturerRule
+      {
+        uint16_t company_id = 0;
+        int offset = -1;
+        uint8_t mask = 0xff;
+        uint8_t value = 0;
+      };
+
+      static unsigned long parse_number(const nlohmann::json &value);
+
+    private:
+      std::vector<IBeaconRule> ibeacon_rules;
+      std::vector<ManufacturerRule> manufacturer_rules;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_PRIORITYCLASSIFIER_HPP
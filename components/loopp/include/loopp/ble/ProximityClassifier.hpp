@@ -0,0 +1,72 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_PROXIMITYCLASSIFIER_HPP
+#define LOOPP_BLE_PROXIMITYCLASSIFIER_HPP
+
+#include <cstdint>
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Maps a smoothed RSSI and the calibrated TX power of a beacon to a
+    // coarse proximity zone:
+    //
+    //   { "immediate": 0.5, "near": 3.0, "hysteresis": 3, "min_samples": 3, "path_loss_exponent": 2.0 }
+    //
+    // immediate and near are the outer zone boundaries in meters. They are
+    // converted to path loss once, so classifying a sample takes no
+    // floating point math beyond a subtraction. To leave its zone, the path
+    // loss of a beacon must cross the boundary by more than hysteresis dB.
+    class ProximityClassifier
+    {
+    public:
+      // Values are published, do not renumber.
+      enum class Zone : uint8_t
+      {
+        Unknown = 0,
+        Immediate = 1,
+        Near = 2,
+        Far = 3,
+      };
+
+      ProximityClassifier() = default;
+      explicit ProximityClassifier(const nlohmann::json &config);
+
+      // Returns the zone for a beacon currently in zone 'current'. rssi is
+      // the smoothed RSSI over 'samples' samples and measured_power the RSSI
+      // at 1 m as advertised by the beacon.
+      Zone classify(Zone current, float rssi, int measured_power, uint32_t samples) const;
+
+      static const char *zone_name(Zone zone);
+
+    private:
+      float immediate_loss = 0.0f;
+      float near_loss = 0.0f;
+      float hysteresis = 3.0f;
+      uint32_t min_samples = 3;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_PROXIMITYCLASSIFIER_HPP
@@ -0,0 +1,67 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_RSSIFILTER_HPP
+#define LOOPP_BLE_RSSIFILTER_HPP
+
+#include <cstdint>
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    class RssiFilter
+    {
+    public:
+      enum class Type
+      {
+        Ema,
+        Kalman
+      };
+
+      struct State
+      {
+        float estimate = 0.0f;
+        float error = 0.0f;
+        std::uint32_t samples = 0;
+      };
+
+      RssiFilter() = default;
+      explicit RssiFilter(const nlohmann::json &config);
+
+      float update(State &state, int rssi) const;
+
+      // Log-distance path loss model. measured_power is the RSSI at 1 m, as
+      // advertised in the iBeacon/AltBeacon 'power' field.
+      float estimate_distance(float rssi, int measured_power) const;
+
+    private:
+      Type type = Type::Kalman;
+      float alpha = 0.25f;
+      float process_noise = 0.05f;
+      float measurement_noise = 4.0f;
+      float path_loss_exponent = 2.0f;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_RSSIFILTER_HPP
@@ -0,0 +1,61 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_SCANBATCH_HPP
+#define LOOPP_BLE_SCANBATCH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Records of one publish period on the scan topic. Each record is a
+    // serialized JSON object that gets the offset of its receive time from
+    // the base time, in microseconds, as "dt". The base time is the earliest
+    // receive time in the batch, so that records from the main loop, the
+    // scan pipeline and the device table never get a negative offset.
+    class ScanBatch
+    {
+    public:
+      ScanBatch() = default;
+
+      void reserve(std::size_t size);
+      void add(std::string record, std::int64_t timestamp);
+
+      bool empty() const;
+      std::size_t size() const;
+      std::int64_t get_base_time() const;
+      const std::vector<std::int64_t> &get_timestamps() const;
+
+      // Appends the offsets and moves the records out of the batch.
+      std::vector<std::string> take_records();
+
+    private:
+      std::vector<std::string> records;
+      std::vector<std::int64_t> timestamps;
+      std::int64_t base_time = 0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_SCANBATCH_HPP
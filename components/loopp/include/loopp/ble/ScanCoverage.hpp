@@ -0,0 +1,74 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_SCANCOVERAGE_HPP
+#define LOOPP_BLE_SCANCOVERAGE_HPP
+
+#include <cstdint>
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Keeps track of the time the controller is actually scanning. A scan
+    // with a bounded duration stops by itself and must be restarted; the time
+    // between the stop and the next start is a blind gap in which
+    // advertisements are lost.
+    //
+    // All times are monotonic microseconds (esp_timer_get_time).
+    class ScanCoverage
+    {
+    public:
+      struct Report
+      {
+        // Percentage of the report period during which scanning was enabled.
+        float duty_cycle = 0.0f;
+        std::int64_t last_gap_us = 0;
+        std::int64_t max_gap_us = 0;
+        std::uint32_t restarts = 0;
+      };
+
+      // Starts a new report period and forgets the last stop, so that an
+      // explicit stop/start is not reported as a restart gap. The scan state
+      // is kept: the controller only reports state changes, so a scan that is
+      // still running keeps counting from now on.
+      void reset(std::int64_t now);
+
+      void scan_started(std::int64_t now);
+      void scan_stopped(std::int64_t now);
+
+      bool is_scanning() const;
+
+      // Returns the coverage since the previous report and starts a new
+      // report period.
+      Report take_report(std::int64_t now);
+
+    private:
+      std::int64_t period_start = 0;
+      std::int64_t on_time = 0;
+      std::int64_t started_at = 0;
+      std::int64_t stopped_at = -1;
+      bool scanning = false;
+      Report report;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_SCANCOVERAGE_HPP
@@ -0,0 +1,92 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_SCANFILTER_HPP
+#define LOOPP_BLE_SCANFILTER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Allow/deny filter for advertisements, evaluated in the Bluetooth
+    // callback before the scan result is copied:
+    //
+    //   {
+    //     "min_rssi": -90,
+    //     "allow": { "mac": [ "c4:7c:8d:6a:01:02" ], "mac_prefix": [ "c4:7c:8d" ],
+    //                "ibeacon_uuid": [ "f7826da6-4fa2-4e98-8024-bc5b71e0893e" ],
+    //                "company_id": [ 76, "0499" ] },
+    //     "deny": { ... }
+    //   }
+    //
+    // An advertisement is rejected if it is weaker than min_rssi or matches
+    // any deny rule. If allow rules are present, it must also match at least
+    // one of them. The filter is immutable once constructed; all rules are
+    // kept in sorted vectors so evaluation never allocates.
+    class ScanFilter
+    {
+    public:
+      ScanFilter() = default;
+      explicit ScanFilter(const nlohmann::json &config);
+
+      bool accept(const uint8_t bda[6], int rssi, const uint8_t *adv_data, std::size_t size) const;
+
+    private:
+      using Uuid = std::array<uint8_t, 16>;
+
+      struct Prefix
+      {
+        std::uint64_t value;
+        std::uint64_t mask;
+      };
+
+      struct Rules
+      {
+        std::vector<std::uint64_t> addresses;
+        std::vector<Prefix> prefixes;
+        std::vector<Uuid> uuids;
+        std::vector<uint16_t> company_ids;
+
+        void load(const nlohmann::json &config);
+        bool empty() const;
+        bool needs_adv_data() const;
+        bool match_address(std::uint64_t address) const;
+        bool match_adv_data(const uint8_t *adv_data, std::size_t size) const;
+      };
+
+      static std::uint64_t make_address(const uint8_t bda[6]);
+      static std::vector<uint8_t> parse_bytes(const std::string &text);
+
+    private:
+      int min_rssi = -128;
+      Rules allow;
+      Rules deny;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_SCANFILTER_HPP
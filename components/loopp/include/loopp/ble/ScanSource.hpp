@@ -0,0 +1,48 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_SCANSOURCE_HPP
+#define LOOPP_BLE_SCANSOURCE_HPP
+
+#include "loopp/ble/BLEScanner.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Sequential source of scan results other than the Bluetooth
+    // controller, such as a recorded trace or an HCI capture. TraceReplay
+    // feeds a source into a scan result signal.
+    class ScanSource
+    {
+    public:
+      virtual ~ScanSource() = default;
+
+      // Reads the next result. Returns false at the end of the source.
+      virtual bool next(BLEScanner::ScanResult &result) = 0;
+
+      // Restarts at the beginning. Sources that cannot seek, such as pipes,
+      // stay at the end.
+      virtual void rewind() = 0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_SCANSOURCE_HPP
@@ -0,0 +1,77 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_SKETCHAGGREGATOR_HPP
+#define LOOPP_BLE_SKETCHAGGREGATOR_HPP
+
+#include <cstdint>
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/core/CountMinSketch.hpp"
+#include "loopp/core/HyperLogLog.hpp"
+#include "loopp/core/TopK.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Summarizes a window of advertisements in fixed memory, for
+    // environments too dense to report individual devices:
+    //
+    //   {
+    //     "advertisements": 48213,
+    //     "unique_devices": 3120,       // HyperLogLog over addresses
+    //     "unique_ibeacons": 41,        // HyperLogLog over uuid/major/minor
+    //     "top_devices": [ { "mac": "..", "count": 212, "rssi_max": -48 }, .. ],
+    //     "top_uuids": [ { "uuid": "..", "count": 5120, "rssi_max": -51 }, .. ]
+    //   }
+    //
+    // Counts of the top devices and iBeacon UUIDs are Count-Min estimates.
+    // Configuration: precision (HyperLogLog, default 10), width and depth
+    // (Count-Min, default 256 x 4) and top (default 10).
+    class SketchAggregator
+    {
+    public:
+      explicit SketchAggregator(const nlohmann::json &config);
+
+      void add(const BLEScanner::ScanResult &result);
+      nlohmann::json summary() const;
+      void clear();
+
+      std::size_t memory_size() const;
+
+    private:
+      static bool get_ibeacon(const std::string &adv_data, const uint8_t *&uuid);
+
+    private:
+      loopp::core::HyperLogLog unique_devices;
+      loopp::core::HyperLogLog unique_ibeacons;
+      loopp::core::CountMinSketch device_counts;
+      loopp::core::CountMinSketch uuid_counts;
+      loopp::core::TopK top_devices;
+      loopp::core::TopK top_uuids;
+      std::uint32_t advertisements = 0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_SKETCHAGGREGATOR_HPP
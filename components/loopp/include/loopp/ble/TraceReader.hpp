@@ -0,0 +1,66 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_TRACEREADER_HPP
+#define LOOPP_BLE_TRACEREADER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/ScanSource.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Sequential reader of a trace written by TraceRecorder. On Linux the
+    // trace is memory mapped; on the ESP32 it is read through stdio.
+    class TraceReader : public ScanSource
+    {
+    public:
+      explicit TraceReader(const std::string &path);
+      ~TraceReader() override;
+
+      TraceReader(const TraceReader &) = delete;
+      TraceReader &operator=(const TraceReader &) = delete;
+
+      bool next(BLEScanner::ScanResult &result) override;
+      void rewind() override;
+
+    private:
+      bool read(uint8_t *buffer, std::size_t size);
+      void close();
+
+    private:
+#ifdef __linux__
+      int fd = -1;
+      const uint8_t *data = nullptr;
+      std::size_t size = 0;
+      std::size_t pos = 0;
+#else
+      std::FILE *file = nullptr;
+#endif
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_TRACEREADER_HPP
@@ -0,0 +1,73 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_TRACERECORDER_HPP
+#define LOOPP_BLE_TRACERECORDER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "loopp/ble/BLEScanner.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Appends scan results to a compact binary trace file. The file starts
+    // with an 8 byte header ("LPTR", version, 3 reserved bytes), followed by
+    // one record per advertisement:
+    //
+    //   int64   timestamp (us, little endian)
+    //   uint8   bda[6]
+    //   uint8   address type
+    //   int8    rssi
+    //   uint8   length
+    //   uint8   adv_data[length]
+    //
+    // A record that was only partially written, e.g. after a power loss, is
+    // ignored when the trace is read.
+    class TraceRecorder
+    {
+    public:
+      explicit TraceRecorder(const std::string &path);
+      ~TraceRecorder();
+
+      TraceRecorder(const TraceRecorder &) = delete;
+      TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+      void record(const BLEScanner::ScanResult &result);
+      void flush();
+
+      std::uint32_t get_count() const;
+
+      static constexpr std::size_t header_size = 8;
+      static constexpr std::size_t record_header_size = 17;
+      static constexpr std::uint8_t version = 2;
+      static const char magic[4];
+
+    private:
+      std::FILE *file = nullptr;
+      std::uint32_t count = 0;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_TRACERECORDER_HPP
@@ -0,0 +1,91 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_TRACEREPLAY_HPP
+#define LOOPP_BLE_TRACEREPLAY_HPP
+
+#include <functional>
+#include <memory>
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/ScanSource.hpp"
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/core/Signal.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // Replays a recorded trace or capture into a scan result signal,
+    // normally the one of BLEScanner, from the main loop. Timestamps are
+    // rebased to the time of replay.
+    //
+    // A speed of 1.0 replays with the original timing, other positive
+    // values scale it. A speed of 0 replays as fast as possible, in slices
+    // so that the main loop keeps serving other work in between.
+    class TraceReplay : public std::enable_shared_from_this<TraceReplay>
+    {
+    public:
+      using complete_callback_t = std::function<void()>;
+
+      TraceReplay(std::shared_ptr<loopp::core::MainLoop> loop,
+                  std::shared_ptr<ScanSource> reader,
+                  loopp::core::Signal<void(const BLEScanner::ScanResult &)> &signal);
+      ~TraceReplay() = default;
+
+      TraceReplay(const TraceReplay &) = delete;
+      TraceReplay &operator=(const TraceReplay &) = delete;
+
+      void set_speed(double speed);
+      void set_repeat(bool repeat);
+
+      void start(complete_callback_t complete = nullptr);
+      void stop();
+
+      std::uint32_t get_count() const;
+
+    private:
+      void replay();
+      void replay_fast();
+      void schedule();
+      bool fetch();
+      void finish();
+
+    private:
+      std::shared_ptr<loopp::core::MainLoop> loop;
+      std::shared_ptr<ScanSource> reader;
+      loopp::core::Signal<void(const BLEScanner::ScanResult &)> &signal;
+      complete_callback_t complete;
+      double speed = 1.0;
+      bool repeat = false;
+      bool running = false;
+      loopp::core::MainLoop::timer_id timer = 0;
+      BLEScanner::ScanResult next;
+      bool has_next = false;
+      int64_t trace_start = 0;
+      int64_t replay_start = 0;
+      std::uint32_t count = 0;
+
+      static constexpr int fast_slice = 256;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_TRACEREPLAY_HPP
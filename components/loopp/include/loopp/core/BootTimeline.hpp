@@ -0,0 +1,77 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_BOOTTIMELINE_HPP
+#define LOOPP_CORE_BOOTTIMELINE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "loopp/core/Mutex.hpp"
+#include "loopp/core/Signal.hpp"
+
+namespace loopp
+{
+  namespace core
+  {
+    // Records when each boot phase was first reached, in microseconds since
+    // boot (esp_timer_get_time). Phases are marked from any task, e.g.
+    // "wifi_connected" from the main loop and "bt_ready" from the task that
+    // initializes Bluetooth.
+    class BootTimeline
+    {
+    public:
+      struct Phase
+      {
+        std::string name;
+        int64_t time_us;
+      };
+
+      BootTimeline() = default;
+
+      BootTimeline(const BootTimeline &) = delete;
+      BootTimeline &operator=(const BootTimeline &) = delete;
+
+      static BootTimeline &instance();
+
+      // Records the current time for a phase. Only the first mark of a phase
+      // counts; returns false for later ones.
+      bool mark(const std::string &name);
+      bool mark(const std::string &name, int64_t time_us);
+
+      // Returns the time of a phase, or -1 if it was not reached yet.
+      int64_t get(const std::string &name) const;
+
+      // Phases in the order they were reached.
+      std::vector<Phase> get_phases() const;
+
+      // Emitted, on the marking task, for the first mark of each phase.
+      loopp::core::Signal<void(std::string)> &phase_signal();
+
+    private:
+      mutable loopp::core::Mutex mutex;
+      std::vector<Phase> phases;
+      loopp::core::Signal<void(std::string)> signal_phase;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_BOOTTIMELINE_HPP
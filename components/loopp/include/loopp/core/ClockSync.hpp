@@ -0,0 +1,87 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_CLOCKSYNC_HPP
+#define LOOPP_CORE_CLOCKSYNC_HPP
+
+#include <cstdint>
+#include <deque>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Estimates the offset and drift of the local monotonic clock relative
+    // to a reference clock from NTP-style request/response exchanges:
+    //
+    //   t1  local time the request was sent
+    //   t2  reference time the request was received
+    //   t3  reference time the response was sent
+    //   t4  local time the response was received
+    //
+    // All times are in microseconds. Of the last filter_size exchanges only
+    // the one with the smallest round trip delay is trusted, as it suffers
+    // least from queuing. The offsets of these trusted exchanges are fitted
+    // with a least squares line to estimate drift.
+    class ClockSync
+    {
+    public:
+      ClockSync() = default;
+
+      void add_sample(std::int64_t t1, std::int64_t t2, std::int64_t t3, std::int64_t t4);
+      void reset();
+
+      bool is_synchronized() const;
+
+      // Converts a local monotonic time to reference time.
+      std::int64_t to_reference(std::int64_t local) const;
+      std::int64_t get_offset(std::int64_t local) const;
+
+      // Drift of the local clock relative to the reference clock, in parts
+      // per million. Positive when the local clock runs fast.
+      double get_drift_ppm() const;
+      std::int64_t get_delay() const;
+
+    private:
+      struct Sample
+      {
+        std::int64_t local;
+        std::int64_t offset;
+        std::int64_t delay;
+      };
+
+      void fit();
+
+    private:
+      static constexpr std::size_t filter_size = 8;
+      static constexpr std::size_t history_size = 16;
+      // Drift is only estimated once the trusted samples span this period.
+      static constexpr std::int64_t min_drift_span = 60 * 1000000LL;
+
+      std::deque<Sample> samples;
+      std::deque<Sample> history;
+      std::int64_t reference_local = 0;
+      double intercept = 0.0;
+      double slope = 0.0;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_CLOCKSYNC_HPP
@@ -0,0 +1,61 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_COUNTMINSKETCH_HPP
+#define LOOPP_CORE_COUNTMINSKETCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Approximate per-key counts in fixed memory (depth x width counters).
+    // Estimates never undercount; with conservative update the overcount is
+    // at most total / width with high probability.
+    class CountMinSketch
+    {
+    public:
+      CountMinSketch(std::size_t width = 256, std::size_t depth = 4);
+
+      // Adds count to key and returns the new estimate for key.
+      std::uint32_t add(std::uint64_t key, std::uint32_t count = 1);
+      std::uint32_t estimate(std::uint64_t key) const;
+      void clear();
+
+      std::uint64_t total() const;
+      std::size_t memory_size() const;
+
+    private:
+      void get_slots(std::uint64_t key, std::size_t *slots) const;
+
+      static constexpr std::size_t max_depth = 8;
+
+    private:
+      std::size_t width;
+      std::size_t depth;
+      std::vector<std::uint32_t> counters;
+      std::uint64_t sum = 0;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_COUNTMINSKETCH_HPP
@@ -0,0 +1,54 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_HASH_HPP
+#define LOOPP_CORE_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Finalizer of SplitMix64. Turns structured keys such as Bluetooth
+    // addresses into well distributed 64 bit hashes.
+    inline std::uint64_t mix64(std::uint64_t x)
+    {
+      x += 0x9E3779B97F4A7C15ull;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+      return x ^ (x >> 31);
+    }
+
+    // 64 bit FNV-1a.
+    inline std::uint64_t hash_bytes(const std::uint8_t *data, std::size_t size)
+    {
+      std::uint64_t h = 0xCBF29CE484222325ull;
+      for (std::size_t i = 0; i < size; i++)
+        {
+          h = (h ^ data[i]) * 0x100000001B3ull;
+        }
+      return h;
+    }
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_HASH_HPP
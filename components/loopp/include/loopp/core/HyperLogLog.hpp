@@ -0,0 +1,52 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_HYPERLOGLOG_HPP
+#define LOOPP_CORE_HYPERLOGLOG_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Estimates the number of distinct keys in 2^precision bytes, regardless
+    // of how many keys are added. The standard error is 1.04 / sqrt(2^precision),
+    // about 3% for the default precision of 10.
+    class HyperLogLog
+    {
+    public:
+      explicit HyperLogLog(unsigned precision = 10);
+
+      void add(std::uint64_t key);
+      void clear();
+
+      std::uint64_t estimate() const;
+      std::size_t memory_size() const;
+
+    private:
+      unsigned precision;
+      std::vector<std::uint8_t> registers;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_HYPERLOGLOG_HPP
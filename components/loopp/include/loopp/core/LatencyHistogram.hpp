@@ -0,0 +1,64 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_LATENCYHISTOGRAM_HPP
+#define LOOPP_CORE_LATENCYHISTOGRAM_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Fixed size histogram of latencies in microseconds, for percentiles
+    // without storing samples. Buckets are log-linear: exact below 16 us,
+    // then four buckets per power of two, so a percentile is accurate to
+    // within 25%.
+    class LatencyHistogram
+    {
+    public:
+      void add(std::int64_t latency_us);
+      void reset();
+
+      std::uint32_t get_count() const;
+      std::int64_t get_max() const;
+      std::int64_t get_mean() const;
+
+      // Upper bound of the bucket holding the given percentile (0-100).
+      std::int64_t get_percentile(double percentile) const;
+
+    private:
+      static std::size_t bucket_index(std::uint64_t value);
+      static std::uint64_t bucket_upper_bound(std::size_t index);
+
+    private:
+      static constexpr std::size_t linear_buckets = 16;
+      static constexpr std::size_t bucket_count = linear_buckets + 4 * 40;
+
+      std::array<std::uint32_t, bucket_count> buckets{};
+      std::uint32_t count = 0;
+      std::int64_t max = 0;
+      std::int64_t sum = 0;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_LATENCYHISTOGRAM_HPP
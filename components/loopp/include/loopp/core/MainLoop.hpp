@@ -52,7 +52,7 @@ namespace loopp
       using timer_id = int;
 
       MainLoop() = default;
-      ~MainLoop();
+      ~MainLoop() = default;
 
       MainLoop(const MainLoop &) = delete;
       MainLoop &operator=(const MainLoop &) = delete;
@@ -0,0 +1,154 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_RADIOCOORDINATOR_HPP
+#define LOOPP_CORE_RADIOCOORDINATOR_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "esp_timer.h"
+
+#include "loopp/core/Mutex.hpp"
+#include "loopp/core/Signal.hpp"
+
+namespace loopp
+{
+  namespace core
+  {
+    // Shares the radio between BLE scanning and network bursts. WiFi and
+    // Bluetooth use the same radio, so TLS handshakes, large publishes and
+    // OTA downloads are slow while the scanner holds most of the air time.
+    //
+    // Network code requests a lease to pause scanning, or to scan with a
+    // reduced window, for at most a given duration. The scanner follows the
+    // resulting mode through mode_signal(). Paused time is limited by a
+    // budget of max_pause per budget window; once the budget is spent,
+    // pause requests only reduce the scan window.
+    //
+    // All times are monotonic microseconds (esp_timer_get_time).
+    class RadioCoordinator
+    {
+    public:
+      enum class Mode
+      {
+        Normal,
+        Reduced,
+        Paused,
+      };
+
+      struct Stats
+      {
+        uint32_t requests = 0;
+        // Pause requests that were reduced because the budget was spent.
+        uint32_t downgraded = 0;
+        int64_t paused_us = 0;
+        int64_t reduced_us = 0;
+      };
+
+      // Releases its request when destroyed.
+      class Lease
+      {
+      public:
+        Lease() = default;
+        ~Lease();
+
+        Lease(Lease &&other);
+        Lease &operator=(Lease &&other);
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        void release();
+
+      private:
+        friend class RadioCoordinator;
+        Lease(RadioCoordinator *coordinator, int id);
+
+        RadioCoordinator *coordinator = nullptr;
+        int id = 0;
+      };
+
+      RadioCoordinator();
+      ~RadioCoordinator();
+
+      RadioCoordinator(const RadioCoordinator &) = delete;
+      RadioCoordinator &operator=(const RadioCoordinator &) = delete;
+
+      static RadioCoordinator &instance();
+
+      // A disabled coordinator grants no requests; the mode stays Normal.
+      void configure(bool enabled, std::chrono::milliseconds max_pause, std::chrono::seconds budget_window);
+
+      Lease request(Mode mode, std::chrono::milliseconds max_duration, const char *reason);
+
+      Mode get_mode() const;
+      static const char *mode_name(Mode mode);
+
+      // Returns the counters since the previous call.
+      Stats take_stats();
+
+      // Emitted after the mode changed, on the thread that changed it.
+      // Emissions from different threads may arrive out of order, so
+      // listeners that act on the mode should read get_mode().
+      loopp::core::Signal<void(Mode)> &mode_signal();
+
+      // Expires leases, accounts for the budget and updates the mode.
+      // Called automatically by a timer; public for tests.
+      void update(int64_t now);
+
+    private:
+      struct Entry
+      {
+        int id;
+        Mode mode;
+        int64_t expires;
+        const char *reason;
+      };
+
+      void release(int id);
+      void account(int64_t now);
+      int64_t pause_remaining() const;
+      bool can_pause() const;
+      Mode evaluate() const;
+      int64_t next_deadline(int64_t now) const;
+      void schedule(int64_t now);
+      static void on_timer(void *arg);
+
+    private:
+      mutable loopp::core::Mutex mutex;
+      loopp::core::Signal<void(Mode)> signal_mode;
+      esp_timer_handle_t timer = nullptr;
+      std::vector<Entry> leases;
+      int next_id = 1;
+      bool enabled = true;
+      int64_t max_pause_us = 5000000;
+      int64_t budget_window_us = 60000000;
+      int64_t budget_us = 5000000;
+      int64_t last_update = 0;
+      bool recovering = false;
+      Mode mode = Mode::Normal;
+      Stats stats;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_RADIOCOORDINATOR_HPP
@@ -0,0 +1,118 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_SPSCRING_HPP
+#define LOOPP_CORE_SPSCRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Bounded lock-free queue for exactly one producer task and one
+    // consumer task. The producer only writes tail and the consumer only
+    // writes head, so neither side ever blocks or disables interrupts.
+    // Pushing to a full ring fails instead of waiting.
+    //
+    // The capacity is rounded up to a power of two. Slots are constructed
+    // up front; popped values are moved out and the slot is reused.
+    template<typename T>
+    class SpscRing
+    {
+    public:
+      explicit SpscRing(std::size_t capacity)
+      {
+        std::size_t size = 2;
+        while (size < capacity)
+          {
+            size <<= 1;
+          }
+        slots.resize(size);
+        mask = size - 1;
+      }
+
+      SpscRing(const SpscRing &) = delete;
+      SpscRing &operator=(const SpscRing &) = delete;
+
+      // Producer side.
+      bool try_push(T &&value)
+      {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+          {
+            return false;
+          }
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Checks for room before copying, so that a rejected value costs
+      // nothing.
+      bool try_push(const T &value)
+      {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+          {
+            return false;
+          }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Consumer side.
+      bool try_pop(T &value)
+      {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+          {
+            return false;
+          }
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Exact when called by either side, a snapshot otherwise.
+      std::size_t size() const
+      {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+      }
+
+      std::size_t capacity() const
+      {
+        return slots.size();
+      }
+
+    private:
+      std::vector<T> slots;
+      std::size_t mask = 0;
+      std::atomic<std::size_t> head{ 0 };
+      std::atomic<std::size_t> tail{ 0 };
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_SPSCRING_HPP
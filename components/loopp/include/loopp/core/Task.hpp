@@ -31,6 +31,8 @@ namespace loopp
 {
   namespace core
   {
+    // A FreeRTOS task that runs 'func'. The task is deleted when the Task
+    // is destroyed, also when 'func' has already returned.
     class Task
     {
     public:
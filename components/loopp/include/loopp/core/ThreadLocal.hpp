@@ -22,6 +22,7 @@
 #define LOOPP_CORE_THREADLOCAL_HPP
 
 #include <unordered_map>
+#include <utility>
 
 #include "loopp/core/Mutex.hpp"
 #include "loopp/core/ScopedLock.hpp"
@@ -41,7 +42,9 @@ namespace loopp
       {
         ScopedLock l(mutex);
         TaskHandle_t handle = xTaskGetCurrentTaskHandle();
-        objects[handle] = obj;
+        // The previous object is released after unlocking, in case its
+        // destructor removes itself.
+        std::swap(objects[handle], obj);
       }
 
       T get()
@@ -57,8 +60,14 @@ namespace loopp
 
       void remove()
       {
+        T obj{};
         ScopedLock l(mutex);
-        objects.erase(xTaskGetCurrentTaskHandle());
+        auto it = objects.find(xTaskGetCurrentTaskHandle());
+        if (it != objects.end())
+          {
+            std::swap(it->second, obj);
+            objects.erase(it);
+          }
       }
 
     private:
@@ -0,0 +1,106 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_CORE_TOPK_HPP
+#define LOOPP_CORE_TOPK_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace loopp
+{
+  namespace core
+  {
+    // Keeps the k keys with the highest counts, as estimated by a
+    // CountMinSketch. Only the k tracked keys are stored, so k should be
+    // small.
+    class TopK
+    {
+    public:
+      struct Item
+      {
+        std::uint64_t key = 0;
+        std::uint32_t count = 0;
+        int max_rssi = -128;
+        std::string label;
+      };
+
+      explicit TopK(std::size_t k = 10)
+        : k(k)
+      {
+        items.reserve(k);
+      }
+
+      // Offers a key with its current estimated count. Returns the tracked
+      // item, or nullptr if the key does not make the top k. inserted is set
+      // if the key was not tracked before.
+      Item *offer(std::uint64_t key, std::uint32_t count, bool &inserted)
+      {
+        inserted = false;
+        auto it = std::find_if(items.begin(), items.end(), [key](const Item &item) { return item.key == key; });
+        if (it != items.end())
+          {
+            it->count = count;
+            return &*it;
+          }
+
+        if (items.size() < k)
+          {
+            items.emplace_back();
+            it = items.end() - 1;
+          }
+        else
+          {
+            it = std::min_element(items.begin(), items.end(), [](const Item &a, const Item &b) { return a.count < b.count; });
+            if (it == items.end() || it->count >= count)
+              {
+                return nullptr;
+              }
+            *it = Item();
+          }
+
+        inserted = true;
+        it->key = key;
+        it->count = count;
+        return &*it;
+      }
+
+      std::vector<Item> sorted() const
+      {
+        std::vector<Item> result = items;
+        std::sort(result.begin(), result.end(), [](const Item &a, const Item &b) { return a.count > b.count; });
+        return result;
+      }
+
+      void clear()
+      {
+        items.clear();
+      }
+
+    private:
+      std::size_t k;
+      std::vector<Item> items;
+    };
+  } // namespace core
+} // namespace loopp
+
+#endif // LOOPP_CORE_TOPK_HPP
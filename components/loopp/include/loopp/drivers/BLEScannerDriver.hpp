@@ -21,13 +21,24 @@
 #ifndef BLESCANNERDRIVER_HH
 #define BLESCANNERDRIVER_HH
 
+#include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
-#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/ble/AdaptiveScanController.hpp"
+#include "loopp/ble/LoadGenerator.hpp"
+#include "loopp/ble/ScanBatch.hpp"
+#include "loopp/ble/ScanPipeline.hpp"
+#include "loopp/ble/TraceRecorder.hpp"
+#include "loopp/ble/TraceReplay.hpp"
+#include "loopp/core/HyperLogLog.hpp"
+#include "loopp/core/LatencyHistogram.hpp"
 #include "loopp/core/MainLoop.hpp"
 #include "loopp/drivers/IDriver.hpp"
 #include "loopp/drivers/DriverRegistry.hpp"
 #include "loopp/mqtt/MqttClient.hpp"
+#include "loopp/mqtt/MqttBatchPublisher.hpp"
 #include "loopp/ble/BLEScanner.hpp"
 
 #include "loopp/utils/json.hpp"
@@ -36,6 +47,10 @@ namespace loopp
 {
   namespace drivers
   {
+    class ScanContext;
+    class ScanStage;
+    class PriorityStage;
+
     class BLEScannerDriver
       : public loopp::drivers::IDriver
       , public std::enable_shared_from_this<BLEScannerDriver>
@@ -45,23 +60,62 @@ namespace loopp
       ~BLEScannerDriver();
 
     private:
-      static std::string base64_encode(const std::string &in);
+      void configure_scanner(const nlohmann::json &config);
+      void configure_publisher(const nlohmann::json &config);
+      void configure_stages(const nlohmann::json &config);
+      void configure_replay(const nlohmann::json &config);
+      void configure_pipeline(const nlohmann::json &config);
+      bool needs_loop_stage() const;
+      void add_pipeline_records(loopp::ble::ScanBatch &batch);
 
       void on_ble_scanner_scan_result(const loopp::ble::BLEScanner::ScanResult &result);
       void on_scan_timer();
+      void on_stats_timer();
+      void on_load_timer();
+      void on_adaptive_timer();
+      void start_scan_timer();
 
       virtual void start() override;
       virtual void stop() override;
 
     private:
+      std::shared_ptr<ScanContext> context;
       std::shared_ptr<loopp::core::MainLoop> loop;
-      std::shared_ptr<loopp::mqtt::MqttClient> mqtt;
       loopp::ble::BLEScanner &ble_scanner;
+      // Optional features, in the order in which scan results pass through
+      // them.
+      std::vector<std::shared_ptr<ScanStage>> stages;
+      std::shared_ptr<PriorityStage> priority;
       loopp::core::MainLoop::timer_id scan_timer = 0;
+      std::chrono::milliseconds publish_period{ 1000 };
+      loopp::core::MainLoop::timer_id stats_timer = 0;
+      std::chrono::seconds stats_interval{ 60 };
+      // Only when radio coordination is configured.
+      bool radio_stats = false;
       std::list<loopp::ble::BLEScanner::ScanResult> scan_results;
-      std::string topic_scan;
+      bool publish_raw = true;
+      std::shared_ptr<loopp::mqtt::MqttBatchPublisher> scan_publisher;
       loopp::core::ScopedConnection scan_result_signal_connection;
-      loopp::ble::AdvertisementDecoder decoder;
+      loopp::core::ScopedConnection pipeline_signal_connection;
+      std::shared_ptr<loopp::ble::ScanPipeline> pipeline;
+      loopp::core::Task::CoreId pipeline_core = loopp::core::Task::CoreId::CPU1;
+      std::vector<loopp::ble::ScanPipeline::Record> pipeline_records;
+      loopp::core::MainLoop::timer_id pipeline_timer = 0;
+      std::unique_ptr<loopp::ble::TraceRecorder> trace_recorder;
+      std::shared_ptr<loopp::ble::TraceReplay> trace_replay;
+      std::unique_ptr<loopp::ble::LoadGenerator> load_generator;
+      loopp::core::MainLoop::timer_id load_timer = 0;
+      std::unique_ptr<loopp::ble::AdaptiveScanController> adaptive;
+      std::chrono::seconds adaptive_interval{ 5 };
+      loopp::core::MainLoop::timer_id adaptive_timer = 0;
+      loopp::core::HyperLogLog adaptive_devices{ 8 };
+      uint32_t adaptive_count = 0;
+      int64_t adaptive_start = 0;
+      uint32_t received_count = 0;
+      int64_t stats_start = 0;
+      // Time from reception of an advertisement until it is written to the
+      // MQTT socket in a batch.
+      loopp::core::LatencyHistogram batch_latency;
 
       gpio_num_t pin_no;
       bool feedback = false;
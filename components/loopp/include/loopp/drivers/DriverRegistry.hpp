@@ -26,6 +26,7 @@
 
 #include "loopp/core/MainLoop.hpp"
 #include "loopp/mqtt/MqttClient.hpp"
+#include "loopp/mqtt/MqttTimeSync.hpp"
 
 #include "IDriver.hpp"
 
@@ -39,16 +40,21 @@ namespace loopp
     {
     public:
       DriverContext() = default;
-      DriverContext(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<loopp::mqtt::MqttClient> mqtt, std::string topic_root);
+      DriverContext(std::shared_ptr<loopp::core::MainLoop> loop,
+                    std::shared_ptr<loopp::mqtt::MqttClient> mqtt,
+                    std::string topic_root,
+                    std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync = nullptr);
 
       std::shared_ptr<loopp::core::MainLoop> get_loop() const;
       std::shared_ptr<loopp::mqtt::MqttClient> const get_mqtt();
       std::string get_topic_root() const;
+      std::shared_ptr<loopp::mqtt::MqttTimeSync> get_time_sync() const;
 
     private:
       std::shared_ptr<loopp::core::MainLoop> loop;
       std::shared_ptr<loopp::mqtt::MqttClient> mqtt;
       std::string topic_root;
+      std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync;
     };
 
     class IDriverFactory
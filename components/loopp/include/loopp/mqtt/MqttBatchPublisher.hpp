@@ -0,0 +1,101 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_MQTT_MQTTBATCHPUBLISHER_HPP
+#define LOOPP_MQTT_MQTTBATCHPUBLISHER_HPP
+
+#include <string>
+#include <memory>
+#include <vector>
+
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/mqtt/MqttClient.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace mqtt
+  {
+    // Publishes a batch of JSON records as one or more MQTT messages, each
+    // no larger than the configured maximum packet size. Every message is
+    // wrapped in an envelope:
+    //
+    //   { <header fields>, "seq": 12, "part": 1, "parts": 3, "results": [ ... ] }
+    //
+    // Parts are serialized and published one at a time from the main loop, so
+    // the batch as a whole is never materialized as a single string.
+    class MqttBatchPublisher : public std::enable_shared_from_this<MqttBatchPublisher>
+    {
+    public:
+      MqttBatchPublisher(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<MqttClient> mqtt, std::string topic);
+      ~MqttBatchPublisher() = default;
+
+      MqttBatchPublisher(const MqttBatchPublisher &) = delete;
+      MqttBatchPublisher &operator=(const MqttBatchPublisher &) = delete;
+
+      void set_max_packet_size(std::size_t size);
+      std::size_t get_max_packet_size() const;
+
+      // Options for every part, e.g. PublishOptions::Qos1.
+      void set_publish_options(PublishOptions options);
+
+      // The optional callback is invoked once the last part has been
+      // written to the socket (or acknowledged, for QoS 1 and 2), or when
+      // publishing fails.
+      void publish(std::vector<std::string> records, nlohmann::json header = nlohmann::json::object(),
+                   MqttClient::publish_callback_t callback = nullptr);
+
+      // Splits the records into parts whose envelope fits in max_packet_size
+      // and returns the end index of each part. Records that do not fit in
+      // an envelope of their own are dropped.
+      static std::vector<std::size_t> partition(std::vector<std::string> &records, const nlohmann::json &header, std::size_t max_packet_size);
+
+      // Serializes records [begin, end) as part 'part' (zero based) of
+      // 'parts', releasing each record once it has been copied.
+      static std::string encode_part(const nlohmann::json &header, std::uint32_t seq, std::size_t part, std::size_t parts,
+                                     std::vector<std::string> &records, std::size_t begin, std::size_t end);
+
+    private:
+      struct Batch
+      {
+        std::uint32_t seq = 0;
+        nlohmann::json header;
+        std::vector<std::string> records;
+        std::vector<std::size_t> part_ends;
+        std::size_t part = 0;
+        MqttClient::publish_callback_t callback;
+      };
+
+      static std::size_t get_envelope_size(const nlohmann::json &header, std::size_t parts);
+      void publish_part(std::shared_ptr<Batch> batch);
+
+    private:
+      std::shared_ptr<loopp::core::MainLoop> loop;
+      std::shared_ptr<MqttClient> mqtt;
+      std::string topic;
+      std::size_t max_packet_size;
+      PublishOptions options = PublishOptions::None;
+      std::uint32_t next_seq = 0;
+    };
+  } // namespace mqtt
+} // namespace loopp
+
+#endif // LOOPP_MQTT_MQTTBATCHPUBLISHER_HPP
@@ -21,11 +21,16 @@
 #ifndef LOOPP_MQTT_MQTTCLIENT_HPP
 #define LOOPP_MQTT_MQTTCLIENT_HPP
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <list>
+#include <set>
 #include <system_error>
 
+#include "loopp/mqtt/MqttOutbox.hpp"
+#include "loopp/mqtt/MqttPacket.hpp"
+#include "loopp/mqtt/MqttTopicTrie.hpp"
 #include "loopp/net/Stream.hpp"
 #include "loopp/utils/bitmask.hpp"
 
@@ -37,6 +42,10 @@ namespace loopp
     {
       None = 0,
       Retain = 0b00000001u,
+      // At least once, and exactly once delivery. Same bits as in the
+      // PUBLISH fixed header.
+      Qos1 = 0b00000010u,
+      Qos2 = 0b00000100u,
     };
   }
 
@@ -49,6 +58,7 @@ namespace loopp
     {
     public:
       using subscribe_callback_t = std::function<void(const std::string &topic, const std::string &payload)>;
+      using publish_callback_t = std::function<void(std::error_code ec)>;
 
       MqttClient(std::shared_ptr<loopp::core::MainLoop> loop, std::string client_id, std::string host, int port);
       ~MqttClient();
@@ -62,31 +72,67 @@ namespace loopp
       void set_password(std::string password);
       void set_will(std::string topic, std::string data);
       void set_will_retain(bool retain);
+      // Maximum number of QoS 1/2 messages sent but not yet acknowledged.
+      void set_max_inflight(std::size_t window);
+      // Without a clean session, the broker keeps subscriptions and QoS 1/2
+      // state across reconnects. Takes effect on the next connect.
+      void set_clean_session(bool clean);
 
       void connect();
       void disconnect();
-      void publish(const std::string &topic, const std::string &payload, PublishOptions options = PublishOptions::None);
-      void subscribe(const std::string &topic);
+      // The optional callback is invoked on the main loop once the message
+      // has been written to the socket (QoS 0), acknowledged by the broker
+      // (QoS 1: PUBACK, QoS 2: PUBCOMP), or has failed. QoS 1/2 messages
+      // survive reconnects and are retransmitted with the DUP flag; they
+      // only fail on disconnect().
+      void publish(const std::string &topic, const std::string &payload, PublishOptions options = PublishOptions::None,
+                   publish_callback_t callback = nullptr);
+      // Takes ownership of the payload. It is written to the socket from
+      // its own buffer, without being copied.
+      void publish(const std::string &topic, std::string &&payload, PublishOptions options = PublishOptions::None,
+                   publish_callback_t callback = nullptr);
+      void publish(const std::string &topic, std::shared_ptr<const std::string> payload, PublishOptions options = PublishOptions::None,
+                   publish_callback_t callback = nullptr);
+      void subscribe(const std::string &topic, std::uint8_t qos = 0);
       void unsubscribe(const std::string &topic);
 
+      std::size_t get_max_payload_size(const std::string &topic) const;
+
+      // Bytes of published messages that have not been written to the
+      // socket yet.
+      std::size_t get_send_backlog() const;
+
+      // QoS 1/2 messages waiting for an acknowledgement or for room in the
+      // in-flight window.
+      std::size_t get_unacknowledged_count() const;
+
       void add_filter(const std::string &filter, subscribe_callback_t callback);
       void remove_filter(const std::string &filter);
 
       loopp::core::Property<bool> &connected();
 
     private:
+      struct Subscription
+      {
+        std::string topic;
+        std::uint8_t qos;
+      };
+
       void send_connect();
       void send_ping();
-      void send_publish(const std::string &topic, const std::string &payload, PublishOptions options = PublishOptions::None);
-      void send_subscribe(const std::list<std::string> &topics);
+      void send_publish(const std::string &topic, std::shared_ptr<const std::string> payload, PublishOptions options, publish_callback_t callback);
+      void send_message(const MqttOutbox::Message &message, bool duplicate);
+      void write_publish(const std::string &topic, const std::shared_ptr<const std::string> &payload, BitMask<PublishFlags> flags,
+                         std::uint16_t id, publish_callback_t done);
+      void send_ack(PacketType type, std::uint16_t id);
+      void send_pending();
+      void resend_inflight();
+      void send_subscribe(const std::list<Subscription> &topics);
       void send_unsubscribe(const std::list<std::string> &topics);
 
-      void async_read_control_packet();
-      void async_read_remaining_length();
-      void async_read_payload();
-
-      void handle_control_packet();
-      void handle_remaining_length();
+      void async_read_packets();
+      void handle_input();
+      bool handle_packets();
 
       std::error_code handle_payload();
       std::error_code handle_connect_ack();
@@ -98,10 +144,10 @@ namespace loopp
       std::error_code handle_subscribe_ack();
       std::error_code handle_unsubscribe_ack();
       std::error_code handle_ping_response();
+      std::error_code read_packet_id(const char *what, std::uint16_t &id);
 
       void handle_error(const std::string &what, std::error_code ec);
       std::error_code verify(const std::string &what, std::size_t actual_size, std::size_t expect_size, std::error_code ec = std::error_code());
-      bool match_topic(const std::string &topic, const std::string &filter);
 
     private:
       std::shared_ptr<loopp::core::MainLoop> loop;
@@ -119,19 +165,29 @@ namespace loopp
       const char *ca_cert = nullptr;
       loopp::net::StreamBuffer buffer;
       std::size_t remaining_length = 0;
-      int remaining_length_multiplier = 1;
       uint8_t fixed_header = 0;
+      std::size_t read_size = read_chunk_size;
+      bool handling_input = false;
+      bool input_pending = false;
       loopp::core::MainLoop::timer_id ping_timer = 0;
-      int packet_id = 0;
       subscribe_callback_t subscribe_callback;
       loopp::core::Property<bool> connected_property{ false };
       int pending_ping_count = 0;
-      std::list<std::string> subscriptions;
-      std::map<std::string, subscribe_callback_t> filters;
+      std::atomic<std::size_t> send_backlog{ 0 };
+      std::list<Subscription> subscriptions;
+      bool clean_session = true;
+      bool session_ready = false;
+      MqttOutbox outbox;
+      std::atomic<std::size_t> unacknowledged{ 0 };
+      // QoS 2 messages received but not yet released by the broker; a
+      // retransmission of these is not delivered again.
+      std::set<std::uint16_t> inbound_pending;
+      MqttTopicTrie filters;
 
       static constexpr int ping_interval_sec = 15;
       static constexpr int keep_alive_sec = 60;
       static constexpr int pending_ping_count_limit = 5;
+      static constexpr std::size_t read_chunk_size = 512;
     };
   } // namespace mqtt
 } // namespace loopp
@@ -0,0 +1,117 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_MQTT_MQTTOUTBOX_HPP
+#define LOOPP_MQTT_MQTTOUTBOX_HPP
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace loopp
+{
+  namespace mqtt
+  {
+    // Delivery state of outgoing QoS 1 and QoS 2 messages. Up to 'window'
+    // messages are in flight, i.e. sent but not yet acknowledged; further
+    // messages wait in a queue. In-flight messages stay in the order they
+    // were first sent, which is the order in which they must be
+    // retransmitted after a reconnect.
+    class MqttOutbox
+    {
+    public:
+      using callback_t = std::function<void(std::error_code ec)>;
+
+      enum class State
+      {
+        Queued,
+        // QoS 1: waiting for PUBACK.
+        AwaitAck,
+        // QoS 2: waiting for PUBREC, then PUBCOMP.
+        AwaitRec,
+        AwaitComp,
+      };
+
+      struct Message
+      {
+        std::uint16_t id = 0;
+        std::string topic;
+        std::shared_ptr<const std::string> payload;
+        std::uint8_t qos = 1;
+        bool retain = false;
+        State state = State::Queued;
+        callback_t callback;
+      };
+
+      explicit MqttOutbox(std::size_t window = 8);
+
+      void set_window(std::size_t window);
+      std::size_t get_window() const;
+
+      void push(Message message);
+
+      // Moves the next queued message into the window and assigns its packet
+      // id. Returns nullptr if the window is full or nothing is queued. The
+      // pointer stays valid until the message completes or is cleared.
+      Message *admit();
+
+      Message *find(std::uint16_t id);
+
+      // Handles PUBACK (qos 1) or PUBCOMP (qos 2). Returns false if no
+      // message with this id waits for it.
+      bool complete(std::uint16_t id, std::uint8_t qos, Message &message);
+
+      // Handles PUBREC. Returns false for an unknown id.
+      bool received(std::uint16_t id);
+
+      // Returns a packet id that is not in flight, never 0. Also used for
+      // SUBSCRIBE and UNSUBSCRIBE.
+      std::uint16_t allocate_id();
+
+      // Removes and returns all messages, in flight first.
+      std::vector<Message> clear();
+
+      std::size_t inflight_size() const;
+      std::size_t queued_size() const;
+
+      template<typename F>
+      void for_each_inflight(F f)
+      {
+        for (auto &m : inflight)
+          {
+            f(m);
+          }
+      }
+
+    private:
+      std::size_t window;
+      std::uint16_t next_id = 1;
+      std::list<Message> inflight;
+      std::deque<Message> queue;
+    };
+  } // namespace mqtt
+} // namespace loopp
+
+#endif // LOOPP_MQTT_MQTTOUTBOX_HPP
@@ -21,8 +21,11 @@
 #ifndef LOOPP_MQTT_MQTTPACKET_HPP
 #define LOOPP_MQTT_MQTTPACKET_HPP
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "loopp/net/StreamBuffer.hpp"
 #include "loopp/utils/bitmask.hpp"
@@ -87,6 +90,53 @@ namespace loopp
       loopp::net::StreamBuffer buffer;
       std::ostream stream;
     };
+
+    // Framing of a received packet: fixed header byte, size of the fixed
+    // header including the remaining length, and the remaining length.
+    struct MqttFrame
+    {
+      enum class Status
+      {
+        Complete,
+        Incomplete,
+        Invalid,
+      };
+
+      // Decodes the fixed header at the start of 'data'. Complete means that
+      // the whole packet is present. For Incomplete, header_size is 0 if the
+      // fixed header itself is still incomplete.
+      static Status decode(const std::uint8_t *data, std::size_t size, MqttFrame &frame);
+
+      std::size_t size() const noexcept
+      {
+        return header_size + remaining_length;
+      }
+
+      std::uint8_t fixed_header = 0;
+      std::size_t header_size = 0;
+      std::size_t remaining_length = 0;
+    };
+
+    // Fixed header and variable header (topic and packet id) of a PUBLISH
+    // packet. The payload is not part of it, so that it can be written
+    // from its own buffer. Headers of topics up to about 50 characters are
+    // encoded inline, without allocating.
+    class MqttPublishHeader
+    {
+    public:
+      // Packet id 0 means QoS 0, without packet id.
+      MqttPublishHeader(const std::string &topic, std::uint8_t flags, std::uint16_t id, std::size_t payload_size);
+
+      const std::uint8_t *data() const noexcept;
+      std::size_t size() const noexcept;
+
+    private:
+      static constexpr std::size_t inline_size = 64;
+
+      std::array<std::uint8_t, inline_size> inline_data;
+      std::vector<std::uint8_t> overflow_data;
+      std::size_t length = 0;
+    };
   } // namespace mqtt
 
   DEFINE_BITMASK(mqtt::ConnectFlags);
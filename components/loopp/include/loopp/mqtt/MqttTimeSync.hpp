@@ -0,0 +1,100 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_MQTT_MQTTTIMESYNC_HPP
+#define LOOPP_MQTT_MQTTTIMESYNC_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "loopp/core/ClockSync.hpp"
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/mqtt/MqttClient.hpp"
+
+namespace loopp
+{
+  namespace mqtt
+  {
+    // Synchronizes to a time server using request/response exchanges over
+    // MQTT. A request
+    //
+    //   { "id": 17, "reply": "<response topic>" }
+    //
+    // is published on the request topic. The server answers on the reply
+    // topic with its wall clock time, in microseconds since the epoch, at
+    // which it received the request and sent the response:
+    //
+    //   { "id": 17, "t2": 1538000000123456, "t3": 1538000000123502 }
+    //
+    // The first exchanges are made in quick succession to synchronize
+    // quickly after connecting.
+    class MqttTimeSync : public std::enable_shared_from_this<MqttTimeSync>
+    {
+    public:
+      MqttTimeSync(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<MqttClient> mqtt, std::string request_topic, std::string response_topic);
+      ~MqttTimeSync();
+
+      MqttTimeSync(const MqttTimeSync &) = delete;
+      MqttTimeSync &operator=(const MqttTimeSync &) = delete;
+
+      void set_interval(std::chrono::seconds interval);
+
+      void start();
+      void stop();
+
+      bool is_synchronized() const;
+
+      // Converts a monotonic timestamp (esp_timer_get_time) to wall clock
+      // time in microseconds since the epoch. Falls back to the system
+      // clock until the first exchange completed.
+      int64_t to_wall_clock(int64_t timestamp) const;
+
+      // Same as to_wall_clock(), but also accepts a null time sync, in which
+      // case the system clock is used.
+      static int64_t to_wall_clock(const MqttTimeSync *time_sync, int64_t timestamp);
+
+      const loopp::core::ClockSync &get_clock() const;
+
+    private:
+      void schedule_request();
+      void send_request();
+      void on_response(const std::string &payload, int64_t received);
+
+    private:
+      std::shared_ptr<loopp::core::MainLoop> loop;
+      std::shared_ptr<MqttClient> mqtt;
+      std::string request_topic;
+      std::string response_topic;
+      std::chrono::seconds interval{ 64 };
+      loopp::core::ClockSync clock;
+      loopp::core::MainLoop::timer_id request_timer = 0;
+      uint32_t request_id = 0;
+      int64_t request_time = 0;
+      bool request_pending = false;
+      int fast_requests = 0;
+
+      static constexpr int initial_fast_requests = 8;
+      static constexpr int fast_interval_ms = 2000;
+    };
+  } // namespace mqtt
+} // namespace loopp
+
+#endif // LOOPP_MQTT_MQTTTIMESYNC_HPP
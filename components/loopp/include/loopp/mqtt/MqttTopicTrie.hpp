@@ -0,0 +1,82 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_MQTT_MQTTTOPICTRIE_HPP
+#define LOOPP_MQTT_MQTTTOPICTRIE_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace loopp
+{
+  namespace mqtt
+  {
+    // Topic filters stored by topic level. A lookup walks the levels of the
+    // topic once, following the literal child and the '+' child of each
+    // node and collecting '#' filters on the way, so the cost depends on
+    // the number of levels, not on the number of filters.
+    //
+    // As with MQTT subscriptions, "a/#" also matches "a".
+    class MqttTopicTrie
+    {
+    public:
+      using callback_t = std::function<void(const std::string &topic, const std::string &payload)>;
+
+      // Replaces the callback if the filter already exists. Throws
+      // std::runtime_error for filters with misplaced wildcards.
+      void insert(const std::string &filter, callback_t callback);
+      bool remove(const std::string &filter);
+
+      // Appends the callbacks of all matching filters.
+      void match(const std::string &topic, std::vector<callback_t> &callbacks) const;
+
+      std::size_t size() const;
+
+      static bool is_valid_filter(const std::string &filter);
+
+    private:
+      struct Node
+      {
+        std::map<std::string, std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> single_level;
+        callback_t callback;
+        callback_t multi_level_callback;
+
+        bool empty() const
+        {
+          return children.empty() && !single_level && !callback && !multi_level_callback;
+        }
+      };
+
+      void match(const Node &node, const std::string &topic, std::size_t pos, bool end, std::vector<callback_t> &callbacks) const;
+      bool remove(Node &node, const std::string &filter, std::size_t pos, bool end);
+
+    private:
+      Node root;
+      std::size_t count = 0;
+      mutable std::string level;
+    };
+  } // namespace mqtt
+} // namespace loopp
+
+#endif // LOOPP_MQTT_MQTTTOPICTRIE_HPP
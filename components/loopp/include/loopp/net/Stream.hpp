@@ -24,6 +24,7 @@
 #include <string>
 #include <system_error>
 #include <memory>
+#include <vector>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
@@ -37,6 +38,14 @@ namespace loopp
 {
   namespace net
   {
+    // A block of memory written by a gather write. The memory must remain
+    // valid until the write callback has been invoked.
+    struct ConstBuffer
+    {
+      const uint8_t *data;
+      std::size_t size;
+    };
+
     class Stream : public std::enable_shared_from_this<Stream>
     {
     public:
@@ -48,7 +57,13 @@ namespace loopp
 
       void connect(const std::string &host, int port, const connect_callback_t &callback);
       void write_async(StreamBuffer &buffer, const io_callback_t &callback);
+      // Writes all buffers in order, without first copying them into one
+      // contiguous buffer. Reports the total number of bytes written.
+      void write_async(std::vector<ConstBuffer> buffers, const io_callback_t &callback);
       void read_async(StreamBuffer &buffer, std::size_t count, const io_callback_t &callback);
+      // Reads whatever is available, at least one and at most 'count'
+      // bytes. The callback is invoked immediately if data is available.
+      void read_some_async(StreamBuffer &buffer, std::size_t count, const io_callback_t &callback);
       void read_until_async(StreamBuffer &buffer, const std::string &until, const io_callback_t &callback);
       void close();
 
@@ -57,6 +72,9 @@ namespace loopp
     protected:
       virtual int socket_read(uint8_t *buffer, std::size_t count) = 0;
       virtual int socket_write(uint8_t *buffer, std::size_t count) = 0;
+      // Writes (part of) the given buffers. The default implementation
+      // writes from the first buffer only.
+      virtual int socket_writev(const ConstBuffer *buffers, std::size_t count);
       virtual void socket_close() = 0;
       virtual void socket_on_connected(const std::string &host, const connect_callback_t &callback) = 0;
 
@@ -86,23 +104,84 @@ namespace loopp
       {
       public:
         WriteOperation(StreamBuffer &buffer, io_callback_t callback)
-          : buffer_(buffer)
+          : buffer_(&buffer)
+          , callback_(std::move(callback))
+        {
+        }
+
+        WriteOperation(std::vector<ConstBuffer> buffers, io_callback_t callback)
+          : buffers_(std::move(buffers))
           , callback_(std::move(callback))
         {
+          skip_empty();
         }
 
-        StreamBuffer &buffer()
+        // Null for gather writes.
+        StreamBuffer *buffer()
         {
           return buffer_;
         }
 
+        const ConstBuffer *buffers() const
+        {
+          return buffers_.data() + index_;
+        }
+
+        std::size_t buffer_count() const
+        {
+          return buffers_.size() - index_;
+        }
+
+        bool done() const
+        {
+          return buffer_ != nullptr ? buffer_->consume_size() == 0 : index_ == buffers_.size();
+        }
+
+        void commit(std::size_t n)
+        {
+          if (buffer_ != nullptr)
+            {
+              buffer_->consume_commit(n);
+              return;
+            }
+
+          written_ += n;
+          while (n > 0 && index_ < buffers_.size())
+            {
+              ConstBuffer &b = buffers_[index_];
+              std::size_t count = std::min(n, b.size);
+              b.data += count;
+              b.size -= count;
+              n -= count;
+              skip_empty();
+            }
+        }
+
+        // Stream buffer writes report the bytes left in the buffer.
+        std::size_t result() const
+        {
+          return buffer_ != nullptr ? buffer_->consume_size() : written_;
+        }
+
         void call(std::error_code ec, std::size_t bytes_transferred)
         {
           return callback_(ec, bytes_transferred);
         }
 
       private:
-        StreamBuffer &buffer_;
+        void skip_empty()
+        {
+          while (index_ < buffers_.size() && buffers_[index_].size == 0)
+            {
+              index_++;
+            }
+        }
+
+      private:
+        StreamBuffer *buffer_ = nullptr;
+        std::vector<ConstBuffer> buffers_;
+        std::size_t index_ = 0;
+        std::size_t written_ = 0;
         io_callback_t callback_;
       };
 
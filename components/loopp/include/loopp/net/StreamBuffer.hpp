@@ -42,6 +42,8 @@ namespace loopp
       std::size_t consume_size() const noexcept;
       void consume_commit(std::size_t n);
 
+      static constexpr std::size_t DEFAULT_MAX_BUFFER_SIZE = 10 * 1024;
+
     private:
       int_type underflow();
       int_type overflow(int_type ch);
@@ -52,7 +54,6 @@ namespace loopp
       std::vector<char> buffer;
 
       static constexpr std::size_t BUFFER_INCREASE_SIZE = 100;
-      static constexpr std::size_t DEFAULT_MAX_BUFFER_SIZE = 10 * 1024;
     };
   } // namespace net
 } // namespace loopp
@@ -40,8 +40,12 @@ namespace loopp
     private:
       virtual int socket_read(uint8_t *buffer, std::size_t count);
       virtual int socket_write(uint8_t *buffer, std::size_t count);
+      virtual int socket_writev(const ConstBuffer *buffers, std::size_t count);
       virtual void socket_close();
       virtual void socket_on_connected(const std::string &host, const connect_callback_t &callback);
+
+    private:
+      static constexpr std::size_t max_iov = 4;
     };
   } // namespace net
 } // namespace loopp
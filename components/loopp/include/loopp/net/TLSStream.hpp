@@ -26,6 +26,8 @@
 
 #include "Stream.hpp"
 
+#include "loopp/core/RadioCoordinator.hpp"
+
 #include "mbedtls/config.h"
 #include "mbedtls/platform.h"
 #include "mbedtls/net.h"
@@ -78,6 +80,7 @@ namespace loopp
       mbedtls_pk_context client_key;
       bool have_client_cert = false;
       bool have_ca_cert = false;
+      loopp::core::RadioCoordinator::Lease radio_lease;
     };
   } // namespace net
 } // namespace loopp
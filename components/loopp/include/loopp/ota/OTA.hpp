@@ -27,6 +27,7 @@
 #include "esp_ota_ops.h"
 
 #include "loopp/core/MainLoop.hpp"
+#include "loopp/core/RadioCoordinator.hpp"
 #include "loopp/http/HttpClient.hpp"
 
 namespace loopp
@@ -54,6 +55,7 @@ namespace loopp
       void check();
       void on_http_response(std::error_code ec, const loopp::http::Response &response);
       void retrieve_body();
+      void finish(std::error_code ec);
 
     private:
       std::shared_ptr<loopp::core::MainLoop> loop;
@@ -63,6 +65,8 @@ namespace loopp
       esp_ota_handle_t update_handle = 0;
       const esp_partition_t *update_partition = nullptr;
       loopp::core::MainLoop::timer_id timeout_timer = 0;
+      loopp::core::RadioCoordinator::Lease radio_lease;
+      int64_t start_time = 0;
     };
   } // namespace ota
 } // namespace loopp
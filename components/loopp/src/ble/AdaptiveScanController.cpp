@@ -0,0 +1,165 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/AdaptiveScanController.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  // Shortest scan window allowed by the Bluetooth specification (2.5 ms).
+  const uint16_t min_scan_window = 4;
+
+  // Relative change of the scan window or interval below which the scan is
+  // not restarted. Every restart leaves a gap in which nothing is received.
+  const float restart_threshold = 0.1f;
+
+  const float rate_smoothing = 0.5f;
+  const float duplicate_high = 0.9f;
+  const float duplicate_low = 0.5f;
+
+  bool changed(uint16_t current, uint16_t proposed)
+  {
+    return std::abs(static_cast<int>(proposed) - static_cast<int>(current)) > restart_threshold * current;
+  }
+} // namespace
+
+AdaptiveScanController::AdaptiveScanController(const nlohmann::json &config)
+{
+  min_duty = config.value("min_duty", min_duty);
+  max_duty = config.value("max_duty", max_duty);
+  min_interval = config.value("min_interval", min_interval);
+  max_interval = config.value("max_interval", max_interval);
+  min_period = config.value("min_period", min_period);
+  max_period = config.value("max_period", max_period);
+  target_records = config.value("target_records", target_records);
+  quiet_rate = config.value("quiet_rate", quiet_rate);
+  max_queue = config.value("max_queue", max_queue);
+  max_backlog = config.value("max_backlog", max_backlog);
+
+  if (min_duty <= 0.0f || min_duty > max_duty || max_duty > 1.0f)
+    {
+      throw std::runtime_error("adaptive duty cycle bounds must satisfy 0 < min_duty <= max_duty <= 1");
+    }
+  if (min_interval < min_scan_window || min_interval > max_interval)
+    {
+      throw std::runtime_error("invalid adaptive scan interval bounds");
+    }
+  if (min_period == 0 || min_period > max_period)
+    {
+      throw std::runtime_error("invalid adaptive publish period bounds");
+    }
+
+  // Start fully awake; the first observations quickly bring the duty cycle
+  // down if there is little to see.
+  duty = max_duty;
+  compute_scan_params(decision.scan_interval, decision.scan_window);
+  decision.publish_period = min_period;
+}
+
+const char *
+AdaptiveScanController::state_name(State state)
+{
+  switch (state)
+    {
+    case State::Steady:
+      return "steady";
+    case State::Quiet:
+      return "quiet";
+    case State::Discovering:
+      return "discovering";
+    case State::Saturated:
+      return "saturated";
+    case State::Congested:
+      return "congested";
+    }
+  return "unknown";
+}
+
+void
+AdaptiveScanController::compute_scan_params(uint16_t &interval, uint16_t &window) const
+{
+  float level = max_duty > min_duty ? (duty - min_duty) / (max_duty - min_duty) : 1.0f;
+  interval = static_cast<uint16_t>(std::lround(max_interval - level * (max_interval - min_interval)));
+  window = static_cast<uint16_t>(std::lround(duty * interval));
+  window = std::min(std::max(window, min_scan_window), interval);
+}
+
+bool
+AdaptiveScanController::update(const Observation &observation)
+{
+  // The observed rate scales with the duty cycle that was in effect.
+  float rate = observation.adv_rate / get_duty_cycle();
+  ambient_rate = ambient_rate < 0.0f ? rate : ambient_rate + rate_smoothing * (rate - ambient_rate);
+
+  if (observation.send_backlog > max_backlog || observation.queue_depth > max_queue)
+    {
+      state = State::Congested;
+      duty *= 0.5f;
+    }
+  else if (ambient_rate < quiet_rate)
+    {
+      state = State::Quiet;
+      duty *= 0.75f;
+    }
+  else if (observation.duplicate_ratio > duplicate_high)
+    {
+      state = State::Saturated;
+      duty *= 0.85f;
+    }
+  else if (observation.duplicate_ratio < duplicate_low)
+    {
+      state = State::Discovering;
+      duty *= 2.0f;
+    }
+  else
+    {
+      state = State::Steady;
+    }
+  duty = std::min(std::max(duty, min_duty), max_duty);
+
+  uint16_t interval = 0;
+  uint16_t window = 0;
+  compute_scan_params(interval, window);
+  bool restart = changed(decision.scan_interval, interval) || changed(decision.scan_window, window);
+  if (restart)
+    {
+      decision.scan_interval = interval;
+      decision.scan_window = window;
+    }
+
+  if (state == State::Congested)
+    {
+      decision.publish_period = std::min(decision.publish_period * 2, max_period);
+    }
+  else
+    {
+      float expected_rate = std::max(ambient_rate * get_duty_cycle(), 0.1f);
+      float period = 1000.0f * target_records / expected_rate;
+      decision.publish_period = static_cast<uint32_t>(std::min(std::max(period, static_cast<float>(min_period)), static_cast<float>(max_period)));
+    }
+  return restart;
+}
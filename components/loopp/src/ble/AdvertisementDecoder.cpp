@@ -22,20 +22,80 @@
 
 #include "loopp/ble/AdvertisementDecoder.hpp"
 
+#include "AltBeaconDecoder.hpp"
+#include "EddystoneDecoder.hpp"
 #include "IBeaconDecoder.hpp"
 
 using namespace loopp::ble;
 
 AdvertisementDecoder::AdvertisementDecoder()
 {
-  decoders.push_back(std::make_shared<loopp::ble::IBeaconDecoder>());
+  add_manufacturer_decoder(IBeaconDecoder::company_id, std::make_shared<loopp::ble::IBeaconDecoder>());
+  add_service_data_decoder(EddystoneDecoder::service_uuid, std::make_shared<loopp::ble::EddystoneDecoder>());
+  add_decoder(AdType::ManufacturerSpecific, std::make_shared<loopp::ble::AltBeaconDecoder>());
 }
 
 void
-AdvertisementDecoder::decode(const std::string &adv_data, nlohmann::json &info)
+AdvertisementDecoder::add_decoder(AdType type, std::shared_ptr<Decoder> decoder)
 {
-  for (auto decoder : decoders)
+  type_decoders.push_back(Registration{ static_cast<uint16_t>(type), std::move(decoder) });
+}
+
+void
+AdvertisementDecoder::add_manufacturer_decoder(uint16_t company_id, std::shared_ptr<Decoder> decoder)
+{
+  manufacturer_decoders.push_back(Registration{ company_id, std::move(decoder) });
+}
+
+void
+AdvertisementDecoder::add_service_data_decoder(uint16_t uuid, std::shared_ptr<Decoder> decoder)
+{
+  service_data_decoders.push_back(Registration{ uuid, std::move(decoder) });
+}
+
+bool
+AdvertisementDecoder::decode(const std::string &adv_data, nlohmann::json &info) const
+{
+  return decode(reinterpret_cast<const uint8_t *>(adv_data.data()), adv_data.size(), info);
+}
+
+bool
+AdvertisementDecoder::decode(const uint8_t *adv_data, std::size_t size, nlohmann::json &info) const
+{
+  bool recognized = false;
+
+  for (const AdStructure &ad : AdParser(adv_data, size))
     {
-      decoder->decode(adv_data, info);
+      for (const auto &r : type_decoders)
+        {
+          if (r.key == ad.type)
+            {
+              recognized |= r.decoder->decode(ad, info);
+            }
+        }
+
+      uint16_t id = 0;
+      if (ad.is(AdType::ManufacturerSpecific) && ad.get_uint16(0, id))
+        {
+          for (const auto &r : manufacturer_decoders)
+            {
+              if (r.key == id)
+                {
+                  recognized |= r.decoder->decode(ad, info);
+                }
+            }
+        }
+      else if (ad.is(AdType::ServiceData16) && ad.get_uint16(0, id))
+        {
+          for (const auto &r : service_data_decoders)
+            {
+              if (r.key == id)
+                {
+                  recognized |= r.decoder->decode(ad, info);
+                }
+            }
+        }
     }
+
+  return recognized;
 }
@@ -0,0 +1,52 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AltBeaconDecoder.hpp"
+
+#include "DecoderUtils.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+bool
+AltBeaconDecoder::decode(const AdStructure &ad, nlohmann::json &info) const
+{
+  if (ad.size != altbeacon_size || detail::get_big_uint16(ad.data + 2) != beacon_code)
+    {
+      return false;
+    }
+
+  uint16_t company_id = 0;
+  ad.get_uint16(0, company_id);
+
+  const uint8_t *id = ad.data + 4;
+
+  nlohmann::json j;
+  j["company_id"] = company_id;
+  j["id"] = detail::to_hex(id, 20);
+  j["uuid"] = detail::uuid_as_string(id);
+  j["major"] = detail::get_big_uint16(id + 16);
+  j["minor"] = detail::get_big_uint16(id + 18);
+  j["power"] = static_cast<int8_t>(ad.data[24]);
+  j["reserved"] = ad.data[25];
+
+  info["altbeacon"] = j;
+  return true;
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_ALTBEACON_DECODER_HPP
+#define LOOPP_BLE_ALTBEACON_DECODER_HPP
+
+#include <string>
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace ble
+  {
+    // AltBeacon frames may use any company ID, so this decoder registers for
+    // all manufacturer specific data and matches on the beacon code.
+    class AltBeaconDecoder : public Decoder
+    {
+    public:
+      AltBeaconDecoder() = default;
+      bool decode(const AdStructure &ad, nlohmann::json &info) const override;
+
+    private:
+      // Company ID, beacon code, 20 byte beacon ID, reference RSSI and manufacturer reserved byte.
+      static constexpr std::size_t altbeacon_size = 26;
+      static constexpr uint16_t beacon_code = 0xBEAC;
+    };
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_ALTBEACON_DECODER_HPP
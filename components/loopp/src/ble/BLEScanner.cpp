@@ -20,6 +20,7 @@
 
 #include "loopp/ble/BLEScanner.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <cstring>
@@ -28,6 +29,10 @@
 
 #include "esp_bt.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+
+#include "loopp/core/BootTimeline.hpp"
+#include "loopp/core/ScopedLock.hpp"
 
 static const char *tag = "BLE";
 
@@ -44,7 +49,16 @@ BLEScanner::instance()
 BLEScanner::BLEScanner()
   : ble_scan_params()
 {
-  init();
+  ble_scan_params.scan_type = BLE_SCAN_TYPE_PASSIVE;
+  ble_scan_params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+  ble_scan_params.scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL;
+  ble_scan_params.scan_interval = 0x50;
+  ble_scan_params.scan_window = 0x30;
+
+  // Runs on the thread that changed the mode; the GAP calls only queue
+  // work for the Bluetooth task.
+  radio_mode_connection = loopp::core::RadioCoordinator::instance().mode_signal().connect(
+    [this](loopp::core::RadioCoordinator::Mode) { on_radio_mode(); });
 }
 
 void
@@ -60,8 +74,17 @@ BLEScanner::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
     {
       case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
         {
-          ESP_LOGI(tag, "Scan param set complete, start scanning.");
-          esp_ble_gap_start_scanning(scan_duration);
+          // stop() or a radio pause may have happened while the parameters
+          // were being set.
+          if (scanning && !paused)
+            {
+              ESP_LOGI(tag, "Scan param set complete, start scanning.");
+              esp_ble_gap_start_scanning(scan_duration);
+            }
+          else
+            {
+              ESP_LOGI(tag, "Scan param set complete, not scanning.");
+            }
           break;
         }
 
@@ -73,6 +96,9 @@ BLEScanner::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         else
           {
             ESP_LOGI(tag, "Scan start successfully.");
+            loopp::core::BootTimeline::instance().mark("scan_started");
+            loopp::core::ScopedLock l(mutex);
+            coverage.scan_started(esp_timer_get_time());
           }
         break;
 
@@ -84,6 +110,17 @@ BLEScanner::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
         else
           {
             ESP_LOGI(tag, "Scan stop successfully.");
+            {
+              loopp::core::ScopedLock l(mutex);
+              coverage.scan_stopped(esp_timer_get_time());
+            }
+
+            if (restart_pending.exchange(false) && scanning && !paused)
+              {
+                // Scanning restarts once the parameters are set.
+                esp_ble_scan_params_t params = effective_scan_params();
+                esp_ble_gap_set_scan_params(&params);
+              }
           }
         break;
 
@@ -93,16 +130,43 @@ BLEScanner::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
             {
               case ESP_GAP_SEARCH_INQ_RES_EVT:
                 {
-                  ScanResult beacon(&param->scan_rst);
+                  // Timestamp before anything else, so filtering and copying
+                  // do not add to the receive time.
+                  int64_t timestamp = esp_timer_get_time();
+
+                  std::shared_ptr<const ScanFilter> filter = std::atomic_load(&scan_filter);
+                  if (filter && !filter->accept(param->scan_rst.bda, param->scan_rst.rssi, param->scan_rst.ble_adv, param->scan_rst.adv_data_len))
+                    {
+                      filter_rejected++;
+                      break;
+                    }
+                  filter_accepted++;
+
+                  ScanResult beacon(&param->scan_rst, timestamp);
                   signal_scan_result(beacon);
                   break;
                 }
 
               case ESP_GAP_SEARCH_INQ_CMPL_EVT:
                 {
-                  ESP_LOGI(tag, "Scan completed, restarting.");
+                  {
+                    loopp::core::ScopedLock l(mutex);
+                    coverage.scan_stopped(esp_timer_get_time());
+                  }
+
+                  // The controller keeps the scan parameters, so restart
+                  // immediately instead of waiting for another round trip
+                  // through esp_ble_gap_set_scan_params.
+                  if (scanning && !paused)
+                    {
+                      esp_ble_gap_start_scanning(scan_duration);
+                      ESP_LOGD(tag, "Scan completed, restarted.");
+                    }
+                  else
+                    {
+                      ESP_LOGD(tag, "Scan completed, %s.", scanning ? "paused" : "stopped");
+                    }
                   signal_scan_complete();
-                  esp_ble_gap_set_scan_params(&ble_scan_params);
                   break;
                 }
 
@@ -120,12 +184,6 @@ BLEScanner::gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
 void
 BLEScanner::init()
 {
-  ble_scan_params.scan_type = BLE_SCAN_TYPE_PASSIVE;
-  ble_scan_params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
-  ble_scan_params.scan_filter_policy = BLE_SCAN_FILTER_ALLOW_ALL;
-  ble_scan_params.scan_interval = 0x50;
-  ble_scan_params.scan_window = 0x30;
-
   esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
 
   esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
@@ -135,6 +193,38 @@ BLEScanner::init()
   esp_bluedroid_enable();
 }
 
+void
+BLEScanner::ensure_initialized()
+{
+  loopp::core::ScopedLock l(init_mutex);
+  if (!initialized)
+    {
+      init();
+      initialized = true;
+      loopp::core::BootTimeline::instance().mark("bt_ready");
+    }
+}
+
+void
+BLEScanner::prepare()
+{
+  if (!initialized && !init_task)
+    {
+      init_task = std::make_unique<loopp::core::Task>("ble_init",
+                                                      [this]() {
+                                                        ensure_initialized();
+                                                        init_done.give();
+                                                      },
+                                                      loopp::core::Task::CoreId::NoAffinity, 4096);
+    }
+}
+
+bool
+BLEScanner::is_initialized() const
+{
+  return initialized;
+}
+
 void
 BLEScanner::deinit()
 {
@@ -162,17 +252,126 @@ BLEScanner::set_scan_window(uint16_t window)
   ble_scan_params.scan_window = window;
 }
 
+void
+BLEScanner::set_scan_duration(uint32_t duration)
+{
+  scan_duration = duration;
+}
+
+void
+BLEScanner::update_scan_params(uint16_t interval, uint16_t window)
+{
+  {
+    loopp::core::ScopedLock l(mutex);
+    ble_scan_params.scan_interval = interval;
+    ble_scan_params.scan_window = window;
+  }
+
+  if (scanning && !restart_pending.exchange(true))
+    {
+      esp_ble_gap_stop_scanning();
+    }
+}
+
 void
 BLEScanner::start()
 {
+  ensure_initialized();
+  // The early init task is no longer needed. Wait until it has released
+  // init_mutex, so that it is not deleted while holding the mutex.
+  if (init_task)
+    {
+      init_done.take();
+      init_task.reset();
+    }
+  {
+    loopp::core::ScopedLock l(mutex);
+    coverage.reset(esp_timer_get_time());
+  }
+  scanning = true;
   esp_ble_gap_register_callback(gap_event_handler_static);
-  esp_ble_gap_set_scan_params(&ble_scan_params);
+  if (!paused)
+    {
+      esp_ble_scan_params_t params = effective_scan_params();
+      esp_ble_gap_set_scan_params(&params);
+    }
 }
 
 void
 BLEScanner::stop()
 {
-  esp_ble_gap_stop_scanning();
+  scanning = false;
+  if (initialized)
+    {
+      esp_ble_gap_stop_scanning();
+    }
+}
+
+esp_ble_scan_params_t
+BLEScanner::effective_scan_params()
+{
+  loopp::core::ScopedLock l(mutex);
+  esp_ble_scan_params_t params = ble_scan_params;
+  if (reduced)
+    {
+      // 4 slots (2.5 ms) is the smallest window the controller accepts.
+      params.scan_window = std::max<uint16_t>(4, params.scan_window / 4);
+    }
+  return params;
+}
+
+void
+BLEScanner::on_radio_mode()
+{
+  // Signals of concurrent mode changes may arrive out of order; the current
+  // mode is authoritative.
+  loopp::core::RadioCoordinator::Mode mode = loopp::core::RadioCoordinator::instance().get_mode();
+  bool was_paused = paused.exchange(mode == loopp::core::RadioCoordinator::Mode::Paused);
+  bool was_reduced = reduced.exchange(mode == loopp::core::RadioCoordinator::Mode::Reduced);
+
+  if (!scanning)
+    {
+      return;
+    }
+
+  if (paused && !was_paused)
+    {
+      ESP_LOGI(tag, "Scan paused for network traffic.");
+      restart_pending = false;
+      esp_ble_gap_stop_scanning();
+    }
+  else if (!paused && was_paused)
+    {
+      ESP_LOGI(tag, "Scan resumed.");
+      esp_ble_scan_params_t params = effective_scan_params();
+      esp_ble_gap_set_scan_params(&params);
+    }
+  else if (reduced != was_reduced && !restart_pending.exchange(true))
+    {
+      esp_ble_gap_stop_scanning();
+    }
+}
+
+void
+BLEScanner::set_scan_filter(std::shared_ptr<const ScanFilter> filter)
+{
+  std::atomic_store(&scan_filter, filter);
+}
+
+BLEScanner::FilterStats
+BLEScanner::get_filter_stats() const
+{
+  FilterStats stats;
+  stats.accepted = filter_accepted.load();
+  stats.rejected = filter_rejected.load();
+  return stats;
+}
+
+ScanCoverage::Report
+BLEScanner::get_scan_coverage()
+{
+  loopp::core::ScopedLock l(mutex);
+  return coverage.take_report(esp_timer_get_time());
 }
 
 loopp::core::Signal<void()> &
@@ -181,15 +380,17 @@ BLEScanner::scan_complete_signal()
   return signal_scan_complete;
 }
 
-loopp::core::Signal<void(loopp::ble::BLEScanner::ScanResult)> &
+loopp::core::Signal<void(const loopp::ble::BLEScanner::ScanResult &)> &
 BLEScanner::scan_result_signal()
 {
   return signal_scan_result;
 }
 
-BLEScanner::ScanResult::ScanResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *scan_result)
+BLEScanner::ScanResult::ScanResult(esp_ble_gap_cb_param_t::ble_scan_result_evt_param *scan_result, int64_t timestamp)
   : adv_data(reinterpret_cast<char *>(scan_result->ble_adv), scan_result->adv_data_len)
   , rssi(scan_result->rssi)
+  , ble_addr_type(static_cast<uint8_t>(scan_result->ble_addr_type))
+  , timestamp(timestamp)
 {
   memcpy(bda, scan_result->bda, 6);
 }
@@ -0,0 +1,55 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "DecoderUtils.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+std::string
+detail::to_hex(const uint8_t *data, std::size_t size)
+{
+  static const char digits[] = "0123456789abcdef";
+
+  std::string out;
+  out.reserve(size * 2);
+  for (std::size_t i = 0; i < size; i++)
+    {
+      out.push_back(digits[data[i] >> 4]);
+      out.push_back(digits[data[i] & 0x0f]);
+    }
+  return out;
+}
+
+std::string
+detail::uuid_as_string(const uint8_t uuid[16])
+{
+  std::string out;
+  out.reserve(36);
+  for (int i = 0; i < 16; i++)
+    {
+      out += to_hex(uuid + i, 1);
+      if (i == 3 || i == 5 || i == 7 || i == 9)
+        {
+          out.push_back('-');
+        }
+    }
+  return out;
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_BLE_DECODER_UTILS_HPP
+#define LOOPP_BLE_DECODER_UTILS_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace loopp
+{
+  namespace ble
+  {
+    namespace detail
+    {
+      std::string to_hex(const uint8_t *data, std::size_t size);
+      std::string uuid_as_string(const uint8_t uuid[16]);
+
+      inline uint16_t get_big_uint16(const uint8_t *data)
+      {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+      }
+
+      inline uint32_t get_big_uint32(const uint8_t *data)
+      {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+      }
+    } // namespace detail
+  } // namespace ble
+} // namespace loopp
+
+#endif // LOOPP_BLE_DECODER_UTILS_HPP
@@ -0,0 +1,145 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "EddystoneDecoder.hpp"
+
+#include "DecoderUtils.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+bool
+EddystoneDecoder::decode(const AdStructure &ad, nlohmann::json &info) const
+{
+  uint16_t uuid = 0;
+  if (!ad.get_uint16(0, uuid) || uuid != service_uuid || ad.size < 3)
+    {
+      return false;
+    }
+
+  const uint8_t *frame = ad.data + 2;
+  std::size_t size = ad.size - 2;
+
+  nlohmann::json j;
+  bool ok = false;
+
+  switch (frame[0])
+    {
+      case Uid:
+        ok = decode_uid(frame + 1, size - 1, j);
+        break;
+
+      case Url:
+        ok = decode_url(frame + 1, size - 1, j);
+        break;
+
+      case Tlm:
+        ok = decode_tlm(frame + 1, size - 1, j);
+        break;
+
+      default:
+        break;
+    }
+
+  if (ok)
+    {
+      info["eddystone"] = j;
+    }
+  return ok;
+}
+
+bool
+EddystoneDecoder::decode_uid(const uint8_t *data, std::size_t size, nlohmann::json &j) const
+{
+  // TX power, 10 byte namespace, 6 byte instance, optionally followed by 2 reserved bytes.
+  if (size != 17 && size != 19)
+    {
+      return false;
+    }
+
+  j["frame"] = "uid";
+  j["power"] = static_cast<int8_t>(data[0]);
+  j["namespace"] = detail::to_hex(data + 1, 10);
+  j["instance"] = detail::to_hex(data + 11, 6);
+  return true;
+}
+
+bool
+EddystoneDecoder::decode_url(const uint8_t *data, std::size_t size, nlohmann::json &j) const
+{
+  static const char *schemes[] = { "http://www.", "https://www.", "http://", "https://" };
+  static const char *expansions[] = { ".com/", ".org/", ".edu/", ".net/", ".info/", ".biz/", ".gov/",
+                                      ".com",  ".org",  ".edu",  ".net",  ".info",  ".biz",  ".gov" };
+
+  if (size < 2 || data[1] >= sizeof(schemes) / sizeof(schemes[0]))
+    {
+      return false;
+    }
+
+  std::string url = schemes[data[1]];
+  for (std::size_t i = 2; i < size; i++)
+    {
+      uint8_t c = data[i];
+      if (c < sizeof(expansions) / sizeof(expansions[0]))
+        {
+          url += expansions[c];
+        }
+      else if (c > 0x20 && c < 0x7f)
+        {
+          url.push_back(static_cast<char>(c));
+        }
+      else
+        {
+          return false;
+        }
+    }
+
+  j["frame"] = "url";
+  j["power"] = static_cast<int8_t>(data[0]);
+  j["url"] = url;
+  return true;
+}
+
+bool
+EddystoneDecoder::decode_tlm(const uint8_t *data, std::size_t size, nlohmann::json &j) const
+{
+  // Only the unencrypted (version 0) telemetry frame is supported.
+  if (size != 13 || data[0] != 0x00)
+    {
+      return false;
+    }
+
+  uint16_t battery = detail::get_big_uint16(data + 1);
+  uint16_t temperature = detail::get_big_uint16(data + 3);
+
+  j["frame"] = "tlm";
+  if (battery != 0)
+    {
+      j["battery"] = battery;
+    }
+  if (temperature != 0x8000)
+    {
+      // Signed 8.8 fixed point degrees Celsius.
+      j["temperature"] = static_cast<int16_t>(temperature) / 256.0;
+    }
+  j["adv_count"] = detail::get_big_uint32(data + 5);
+  j["uptime"] = detail::get_big_uint32(data + 9) / 10;
+  return true;
+}
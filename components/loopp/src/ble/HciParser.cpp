@@ -0,0 +1,233 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/HciParser.hpp"
+
+#include <algorithm>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  enum PacketIndicator : uint8_t
+  {
+    Command = 0x01,
+    AclData = 0x02,
+    ScoData = 0x03,
+    Event = 0x04,
+    IsoData = 0x05,
+  };
+
+  const uint8_t le_meta_event = 0x3e;
+  const uint8_t le_advertising_report = 0x02;
+  const uint8_t le_extended_advertising_report = 0x0d;
+
+  // Event type, address type, address, data length; the RSSI follows the data.
+  const std::size_t legacy_report_size = 1 + 1 + 6 + 1;
+  // Event type (2), address type, address, primary and secondary PHY, SID,
+  // TX power, RSSI, periodic interval (2), direct address type and
+  // address, data length.
+  const std::size_t extended_report_size = 2 + 1 + 6 + 1 + 1 + 1 + 1 + 1 + 2 + 1 + 6 + 1;
+  const uint16_t extended_data_status_mask = 0x0060;
+  const uint8_t anonymous_address = 0xff;
+
+  void
+  copy_address(uint8_t bda[6], const uint8_t *address)
+  {
+    // HCI sends the least significant byte first.
+    std::reverse_copy(address, address + 6, bda);
+  }
+} // namespace
+
+void
+HciParser::reset()
+{
+  packet.clear();
+}
+
+std::size_t
+HciParser::header_size(uint8_t indicator)
+{
+  switch (indicator)
+    {
+    case Command:
+    case ScoData:
+      return 4;
+    case AclData:
+    case IsoData:
+      return 5;
+    case Event:
+      return 3;
+    default:
+      return 0;
+    }
+}
+
+std::size_t
+HciParser::packet_size(const uint8_t *header)
+{
+  switch (header[0])
+    {
+    case Command:
+    case ScoData:
+      return 4 + header[3];
+    case AclData:
+      return 5 + (header[3] | (header[4] << 8));
+    case IsoData:
+      return 5 + ((header[3] | (header[4] << 8)) & 0x3fff);
+    case Event:
+      return 3 + header[2];
+    default:
+      return 0;
+    }
+}
+
+void
+HciParser::feed(const uint8_t *data, std::size_t size, int64_t timestamp, std::vector<BLEScanner::ScanResult> &results)
+{
+  while (size > 0)
+    {
+      if (packet.empty())
+        {
+          std::size_t header = header_size(data[0]);
+          if (header == 0)
+            {
+              stats.resyncs++;
+              data++;
+              size--;
+              continue;
+            }
+
+          // Parse complete packets in place, only buffer across chunks.
+          if (size >= header)
+            {
+              std::size_t total = packet_size(data);
+              if (size >= total)
+                {
+                  process(data, total, timestamp, results);
+                  data += total;
+                  size -= total;
+                  continue;
+                }
+            }
+        }
+
+      std::size_t header = header_size(packet.empty() ? data[0] : packet[0]);
+      std::size_t needed = packet.size() < header ? header - packet.size() : packet_size(packet.data()) - packet.size();
+      std::size_t count = std::min(needed, size);
+      packet.insert(packet.end(), data, data + count);
+      data += count;
+      size -= count;
+
+      if (packet.size() >= header && packet.size() == packet_size(packet.data()))
+        {
+          process(packet.data(), packet.size(), timestamp, results);
+          packet.clear();
+        }
+    }
+}
+
+void
+HciParser::process(const uint8_t *data, std::size_t size, int64_t timestamp, std::vector<BLEScanner::ScanResult> &results)
+{
+  stats.packets++;
+  if (data[0] == Event && !parse_event(data + 1, size - 1, timestamp, results, &stats.reports))
+    {
+      stats.malformed++;
+    }
+}
+
+bool
+HciParser::parse_event(const uint8_t *event,
+                       std::size_t size,
+                       int64_t timestamp,
+                       std::vector<BLEScanner::ScanResult> &results,
+                       uint32_t *reports)
+{
+  if (size < 2 || static_cast<std::size_t>(event[1]) + 2 != size)
+    {
+      return false;
+    }
+  if (event[0] != le_meta_event || size < 4)
+    {
+      return true;
+    }
+
+  uint8_t subevent = event[2];
+  if (subevent != le_advertising_report && subevent != le_extended_advertising_report)
+    {
+      return true;
+    }
+
+  const uint8_t *p = event + 4;
+  const uint8_t *end = event + size;
+  std::size_t count = event[3];
+  std::size_t first = results.size();
+
+  for (std::size_t i = 0; i < count; i++)
+    {
+      BLEScanner::ScanResult result;
+      result.timestamp = timestamp;
+
+      if (subevent == le_advertising_report)
+        {
+          if (static_cast<std::size_t>(end - p) < legacy_report_size || static_cast<std::size_t>(end - p) < legacy_report_size + p[8] + 1)
+            {
+              results.resize(first);
+              return false;
+            }
+          result.ble_addr_type = p[1];
+          copy_address(result.bda, p + 2);
+          result.adv_data.assign(reinterpret_cast<const char *>(p + legacy_report_size), p[8]);
+          result.rssi = static_cast<int8_t>(p[legacy_report_size + p[8]]);
+          p += legacy_report_size + p[8] + 1;
+          results.push_back(std::move(result));
+        }
+      else
+        {
+          if (static_cast<std::size_t>(end - p) < extended_report_size || static_cast<std::size_t>(end - p) < extended_report_size + p[23])
+            {
+              results.resize(first);
+              return false;
+            }
+          uint16_t event_type = p[0] | (p[1] << 8);
+          std::size_t length = p[23];
+
+          // Skip fragments of chained advertisements; the host would have to
+          // reassemble them across events.
+          if ((event_type & extended_data_status_mask) == 0 && p[2] != anonymous_address)
+            {
+              result.ble_addr_type = p[2];
+              copy_address(result.bda, p + 3);
+              result.rssi = static_cast<int8_t>(p[13]);
+              result.adv_data.assign(reinterpret_cast<const char *>(p + extended_report_size), length);
+              results.push_back(std::move(result));
+            }
+          p += extended_report_size + length;
+        }
+    }
+
+  if (reports != nullptr)
+    {
+      *reports += results.size() - first;
+    }
+  return true;
+}
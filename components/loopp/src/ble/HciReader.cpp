@@ -0,0 +1,231 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/HciReader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *tag = "BLE";
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  const uint8_t btsnoop_magic[8] = { 'b', 't', 's', 'n', 'o', 'o', 'p', 0 };
+  const std::size_t btsnoop_header_size = 16;
+  const std::size_t btsnoop_record_header_size = 24;
+
+  // Packets without H4 indicator; the record flags give the type.
+  const uint32_t datalink_h1 = 1001;
+  const uint32_t datalink_h4 = 1002;
+  const uint32_t flag_received = 0x01;
+  const uint32_t flag_command_or_event = 0x02;
+
+  const std::size_t chunk_size = 4096;
+
+  uint32_t
+  get_be32(const uint8_t *p)
+  {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+  }
+
+  int64_t
+  get_be64(const uint8_t *p)
+  {
+    return static_cast<int64_t>((static_cast<uint64_t>(get_be32(p)) << 32) | get_be32(p + 4));
+  }
+} // namespace
+
+HciReader::HciReader(const std::string &path)
+  : path(path)
+{
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      throw std::system_error(errno, std::generic_category(), "Could not open HCI capture " + path);
+    }
+
+  buffer.reserve(chunk_size);
+  try
+    {
+      read_header();
+    }
+  catch (...)
+    {
+      ::close(fd);
+      throw;
+    }
+}
+
+HciReader::~HciReader()
+{
+  if (fd >= 0)
+    {
+      ::close(fd);
+    }
+}
+
+bool
+HciReader::read(uint8_t *data, std::size_t size)
+{
+  while (size > 0)
+    {
+      ssize_t ret = ::read(fd, data, size);
+      if (ret < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (ret <= 0)
+        {
+          return false;
+        }
+      data += ret;
+      size -= static_cast<std::size_t>(ret);
+    }
+  return true;
+}
+
+void
+HciReader::read_header()
+{
+  btsnoop = false;
+  pending.clear();
+  pending_pos = 0;
+  parser.reset();
+
+  uint8_t header[btsnoop_header_size];
+  if (!read(header, sizeof(btsnoop_magic)))
+    {
+      return;
+    }
+
+  if (std::memcmp(header, btsnoop_magic, sizeof(btsnoop_magic)) != 0)
+    {
+      // Raw H4, the bytes are the start of the stream.
+      parser.feed(header, sizeof(btsnoop_magic), esp_timer_get_time(), pending);
+      return;
+    }
+
+  if (!read(header + sizeof(btsnoop_magic), btsnoop_header_size - sizeof(btsnoop_magic)))
+    {
+      throw std::runtime_error("truncated btsnoop header in " + path);
+    }
+
+  datalink = get_be32(header + 12);
+  if (datalink != datalink_h1 && datalink != datalink_h4)
+    {
+      throw std::runtime_error("unsupported btsnoop datalink " + std::to_string(datalink) + " in " + path);
+    }
+  btsnoop = true;
+}
+
+bool
+HciReader::fill_btsnoop()
+{
+  uint8_t header[btsnoop_record_header_size];
+  if (!read(header, sizeof(header)))
+    {
+      return false;
+    }
+
+  uint32_t length = get_be32(header + 4);
+  uint32_t flags = get_be32(header + 8);
+  int64_t timestamp = get_be64(header + 16);
+
+  buffer.resize(length);
+  if (!read(buffer.data(), length))
+    {
+      ESP_LOGW(tag, "Truncated btsnoop record in %s", path.c_str());
+      return false;
+    }
+
+  if (datalink == datalink_h4)
+    {
+      parser.feed(buffer.data(), buffer.size(), timestamp, pending);
+    }
+  else if ((flags & (flag_received | flag_command_or_event)) == (flag_received | flag_command_or_event))
+    {
+      HciParser::parse_event(buffer.data(), buffer.size(), timestamp, pending);
+    }
+  return true;
+}
+
+bool
+HciReader::fill()
+{
+  if (btsnoop)
+    {
+      return fill_btsnoop();
+    }
+
+  buffer.resize(chunk_size);
+  ssize_t ret = 0;
+  do
+    {
+      ret = ::read(fd, buffer.data(), buffer.size());
+    }
+  while (ret < 0 && errno == EINTR);
+
+  if (ret <= 0)
+    {
+      return false;
+    }
+
+  parser.feed(buffer.data(), static_cast<std::size_t>(ret), esp_timer_get_time(), pending);
+  return true;
+}
+
+bool
+HciReader::next(BLEScanner::ScanResult &result)
+{
+  while (pending_pos == pending.size())
+    {
+      pending.clear();
+      pending_pos = 0;
+      if (!fill())
+        {
+          return false;
+        }
+    }
+
+  result = std::move(pending[pending_pos++]);
+  return true;
+}
+
+void
+HciReader::rewind()
+{
+  if (::lseek(fd, 0, SEEK_SET) < 0)
+    {
+      ESP_LOGW(tag, "Cannot rewind %s", path.c_str());
+      return;
+    }
+  read_header();
+}
@@ -22,6 +22,8 @@
 
 #include <boost/endian/conversion.hpp>
 
+#include "DecoderUtils.hpp"
+
 using namespace loopp;
 using namespace loopp::ble;
 
@@ -29,60 +31,28 @@ IBeaconDecoder::IBeaconDecoder()
 {
 }
 
-std::string
-IBeaconDecoder::uuid_as_string(const uint8_t uuid[16]) const
+bool
+IBeaconDecoder::decode(const AdStructure &ad, nlohmann::json &info) const
 {
-  std::stringstream ss;
-  ss << std::hex << std::right;
-  ss.fill('0');
-  ss.width(2);
+  BOOST_STATIC_ASSERT(sizeof(ibeacon_data_t) == 25u);
 
-  for (int i = 0; i < 16; i++)
+  if (ad.size != sizeof(ibeacon_data_t))
     {
-      ss << static_cast<unsigned int>(uuid[i]);
-      if (i == 3 || i == 5 || i == 7 || i == 9)
-        {
-          ss << '-';
-        }
+      return false;
     }
 
-  return ss.str();
-}
-
-void
-IBeaconDecoder::decode(const std::string &adv_data, nlohmann::json &info) const
-{
-  BOOST_STATIC_ASSERT(sizeof(ibeacon_data_t) == 30u);
-
-  if (matches(adv_data))
+  const ibeacon_data_t *data = reinterpret_cast<const ibeacon_data_t *>(ad.data);
+  if (data->type != ibeacon_type || data->length != ibeacon_length)
     {
-      const ibeacon_data_t *data = reinterpret_cast<const ibeacon_data_t *>(adv_data.data());
-
-      nlohmann::json j;
-      j["uuid"] = uuid_as_string(data->uuid);
-      j["major"] = data->major.value();
-      j["minor"] = data->minor.value();
-      j["power"] = data->power;
-
-      info["ibeacon"] = j;
+      return false;
     }
-}
 
-bool
-IBeaconDecoder::matches(const std::string &adv_data) const
-{
-  static uint8_t ibeacon_prefix[] =
-    {
-      0x02, 0x01, 0x00, 0x1A, 0xFF, 0x4C, 0x00, 0x02, 0x15
-    };
-
-  for (int i = 0; i < sizeof(ibeacon_prefix); i++)
-    {
-      if (i != 2 && adv_data[i] != ibeacon_prefix[i])
-        {
-          return false;
-        }
-    }
+  nlohmann::json j;
+  j["uuid"] = detail::uuid_as_string(data->uuid);
+  j["major"] = data->major.value();
+  j["minor"] = data->minor.value();
+  j["power"] = data->power;
 
+  info["ibeacon"] = j;
   return true;
 }
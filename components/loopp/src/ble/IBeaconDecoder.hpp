@@ -35,21 +35,26 @@ namespace loopp
     class IBeaconDecoder : public Decoder
     {
     public:
+      static constexpr uint16_t company_id = 0x004C;
+
       IBeaconDecoder();
-      void decode(const std::string &adv_data, nlohmann::json &info) const;
+      bool decode(const AdStructure &ad, nlohmann::json &info) const override;
 
     private:
-      bool matches(const std::string &adv_data) const;
-      std::string uuid_as_string(const uint8_t uuid[16]) const;
-
+      // Manufacturer specific data following the AD length and type.
       struct ibeacon_data_t
       {
-        uint8_t  prefix[9];
+        boost::endian::little_uint16_t company_id;
+        uint8_t  type;
+        uint8_t  length;
         uint8_t  uuid[16];
         boost::endian::big_uint16_t major;
         boost::endian::big_uint16_t minor;
         int8_t   power;
       };
+
+      static constexpr uint8_t ibeacon_type = 0x02;
+      static constexpr uint8_t ibeacon_length = 0x15;
     };
   }
 }
@@ -0,0 +1,252 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/LoadGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  // Advertising events are delayed by a random 0-10 ms (advDelay).
+  const int64_t max_adv_delay = 10000;
+
+  const uint8_t ibeacon_uuid[16] = { 0x6c, 0x6f, 0x6f, 0x70, 0x70, 0x2d, 0x6c, 0x6f, 0x61, 0x64, 0x2d, 0x67, 0x65, 0x6e, 0x00, 0x01 };
+} // namespace
+
+LoadGenerator::LoadGenerator(const nlohmann::json &config)
+  : rng(config.value("seed", 1u))
+{
+  auto it = config.find("rssi");
+  if (it != config.end())
+    {
+      power = it->value("power", power);
+      path_loss_exponent = it->value("path_loss_exponent", path_loss_exponent);
+      noise = it->value("noise", noise);
+      max_distance = it->value("max_distance", max_distance);
+    }
+
+  it = config.find("ibeacons");
+  if (it != config.end())
+    {
+      add_devices(Kind::IBeacon, *it);
+    }
+
+  it = config.find("phones");
+  if (it != config.end())
+    {
+      rotate_interval = it->value("rotate_s", 900) * 1000000LL;
+      add_devices(Kind::Phone, *it);
+    }
+
+  it = config.find("crowds");
+  if (it != config.end())
+    {
+      crowd_period = it->value("period_s", 60) * 1000000LL;
+      crowd_duration = std::min<int64_t>(it->value("duration_s", 10) * 1000000LL, crowd_period);
+      add_devices(Kind::Crowd, *it);
+    }
+}
+
+void
+LoadGenerator::add_devices(Kind kind, const nlohmann::json &config)
+{
+  int count = config.value("count", 0);
+  int64_t interval = std::max(config.value("interval_ms", 100), 20) * 1000LL;
+  std::uniform_real_distribution<float> distance(0.5f, max_distance);
+
+  double rate = count * 1e6 / static_cast<double>(interval + max_adv_delay / 2);
+  if (kind == Kind::Crowd)
+    {
+      rate = rate * static_cast<double>(crowd_duration) / static_cast<double>(crowd_period);
+    }
+  nominal_rate += rate;
+
+  for (int i = 0; i < count; i++)
+    {
+      Device device{};
+      device.kind = kind;
+      device.interval = interval;
+      device.distance = distance(rng);
+      device.major = static_cast<uint16_t>(devices.size() >> 16);
+      device.minor = static_cast<uint16_t>(devices.size());
+
+      if (kind == Kind::IBeacon)
+        {
+          uint32_t id = static_cast<uint32_t>(devices.size());
+          uint8_t bda[6] = { 0xc0, 0x10, 0xad, static_cast<uint8_t>(id >> 16), static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id) };
+          std::copy(bda, bda + 6, device.bda);
+        }
+      else
+        {
+          randomize_address(device);
+        }
+      devices.push_back(device);
+    }
+}
+
+void
+LoadGenerator::randomize_address(Device &device)
+{
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (auto &b : device.bda)
+    {
+      b = static_cast<uint8_t>(byte(rng));
+    }
+  // Resolvable private address.
+  device.bda[0] = static_cast<uint8_t>((device.bda[0] & 0x3f) | 0x40);
+}
+
+int64_t
+LoadGenerator::jitter(int64_t interval)
+{
+  return interval + std::uniform_int_distribution<int64_t>(0, max_adv_delay)(rng);
+}
+
+void
+LoadGenerator::start(int64_t now)
+{
+  start_time = now;
+  queue.clear();
+  queue.reserve(devices.size());
+
+  for (uint32_t i = 0; i < devices.size(); i++)
+    {
+      Device &device = devices[i];
+      device.next_time = now + std::uniform_int_distribution<int64_t>(0, device.interval)(rng);
+      device.rotate_time = now + std::uniform_int_distribution<int64_t>(1, rotate_interval)(rng);
+      queue.emplace_back(device.next_time, i);
+    }
+  std::make_heap(queue.begin(), queue.end(), std::greater<Event>());
+}
+
+int64_t
+LoadGenerator::next_time() const
+{
+  return queue.empty() ? INT64_MAX : queue.front().first;
+}
+
+std::size_t
+LoadGenerator::get_device_count() const
+{
+  return devices.size();
+}
+
+double
+LoadGenerator::get_nominal_rate() const
+{
+  return nominal_rate;
+}
+
+int
+LoadGenerator::sample_rssi(Device &device)
+{
+  std::normal_distribution<float> step(0.0f, 0.02f * device.distance);
+  device.distance = std::min(std::max(device.distance + step(rng), 0.3f), max_distance);
+
+  std::normal_distribution<float> fading(0.0f, noise);
+  float rssi = static_cast<float>(power) - 10.0f * path_loss_exponent * std::log10(device.distance) + fading(rng);
+  return static_cast<int>(std::lround(std::min(std::max(rssi, -100.0f), -20.0f)));
+}
+
+void
+LoadGenerator::encode_adv_data(const Device &device, std::string &adv_data)
+{
+  switch (device.kind)
+    {
+    case Kind::IBeacon:
+      {
+        static const char prefix[] = "\x02\x01\x06\x1a\xff\x4c\x00\x02\x15";
+        adv_data.assign(prefix, sizeof(prefix) - 1);
+        adv_data.append(reinterpret_cast<const char *>(ibeacon_uuid), sizeof(ibeacon_uuid));
+        adv_data.push_back(static_cast<char>(device.major >> 8));
+        adv_data.push_back(static_cast<char>(device.major));
+        adv_data.push_back(static_cast<char>(device.minor >> 8));
+        adv_data.push_back(static_cast<char>(device.minor));
+        adv_data.push_back(static_cast<char>(power));
+        break;
+      }
+
+    case Kind::Phone:
+      {
+        // Apple nearby info.
+        static const char prefix[] = "\x02\x01\x1a\x0a\xff\x4c\x00\x10\x05";
+        adv_data.assign(prefix, sizeof(prefix) - 1);
+        adv_data.append(reinterpret_cast<const char *>(device.bda + 1), 5);
+        break;
+      }
+
+    case Kind::Crowd:
+      {
+        // Exposure notification service data.
+        static const char prefix[] = "\x02\x01\x1a\x03\x03\x6f\xfd\x17\x16\x6f\xfd";
+        adv_data.assign(prefix, sizeof(prefix) - 1);
+        for (int i = 0; i < 20; i++)
+          {
+            adv_data.push_back(static_cast<char>(device.bda[i % 6] ^ (i * 37)));
+          }
+        break;
+      }
+    }
+}
+
+void
+LoadGenerator::reschedule(Device &device)
+{
+  device.next_time += jitter(device.interval);
+
+  if (device.kind == Kind::Phone && device.next_time >= device.rotate_time)
+    {
+      randomize_address(device);
+      device.rotate_time += rotate_interval;
+    }
+  else if (device.kind == Kind::Crowd)
+    {
+      int64_t phase = (device.next_time - start_time) % crowd_period;
+      if (phase >= crowd_duration)
+        {
+          // Gone until the next burst, then back with a new address.
+          device.next_time += crowd_period - phase + std::uniform_int_distribution<int64_t>(0, device.interval)(rng);
+          randomize_address(device);
+        }
+    }
+}
+
+void
+LoadGenerator::next(BLEScanner::ScanResult &result)
+{
+  std::pop_heap(queue.begin(), queue.end(), std::greater<Event>());
+  Event &event = queue.back();
+  Device &device = devices[event.second];
+
+  std::copy(device.bda, device.bda + 6, result.bda);
+  result.ble_addr_type = device.kind == Kind::IBeacon ? static_cast<uint8_t>(AddressType::Public) : static_cast<uint8_t>(AddressType::Random);
+  result.timestamp = device.next_time;
+  result.rssi = sample_rssi(device);
+  encode_adv_data(device, result.adv_data);
+
+  reschedule(device);
+  event.first = device.next_time;
+  std::push_heap(queue.begin(), queue.end(), std::greater<Event>());
+}
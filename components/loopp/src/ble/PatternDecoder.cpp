@@ -0,0 +1,278 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/PatternDecoder.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  // The length of an AD structure is a single byte.
+  const int max_offset = std::numeric_limits<uint8_t>::max();
+} // namespace
+
+PatternDecoder::PatternDecoder(const nlohmann::json &config)
+{
+  for (const auto &definition : config)
+    {
+      add(definition);
+    }
+  compile();
+}
+
+std::vector<uint8_t>
+PatternDecoder::parse_hex(const std::string &hex)
+{
+  if (hex.size() % 2 != 0)
+    {
+      throw std::runtime_error("invalid hex string: " + hex);
+    }
+
+  std::vector<uint8_t> out;
+  for (std::size_t i = 0; i < hex.size(); i += 2)
+    {
+      out.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    }
+  return out;
+}
+
+uint16_t
+PatternDecoder::parse_id(const nlohmann::json &value)
+{
+  unsigned long id = value.is_string() ? std::stoul(value.get<std::string>(), nullptr, 16) : value.get<unsigned long>();
+  if (id > std::numeric_limits<uint16_t>::max())
+    {
+      throw std::runtime_error("invalid company ID or service UUID");
+    }
+  return static_cast<uint16_t>(id);
+}
+
+int
+PatternDecoder::parse_int(const nlohmann::json &value, int min, int max, const std::string &what)
+{
+  // Validate before narrowing, so that out of range values are not silently
+  // truncated.
+  long long v = value.get<long long>();
+  if (v < min || v > max)
+    {
+      throw std::runtime_error("invalid " + what);
+    }
+  return static_cast<int>(v);
+}
+
+void
+PatternDecoder::add(const nlohmann::json &definition)
+{
+  Pattern pattern{};
+  std::size_t min_size = 0;
+
+  auto it = definition.find("company_id");
+  if (it != definition.end())
+    {
+      pattern.source = Source::Manufacturer;
+      pattern.id = parse_id(*it);
+    }
+  else
+    {
+      pattern.source = Source::ServiceData;
+      pattern.id = parse_id(definition.at("service_uuid"));
+    }
+
+  pattern.name = static_cast<uint16_t>(names.size());
+  names.push_back(definition.at("name").get<std::string>());
+
+  pattern.first_match = static_cast<uint16_t>(matches_table.size());
+  it = definition.find("match");
+  if (it != definition.end())
+    {
+      for (const auto &m : *it)
+        {
+          std::vector<uint8_t> value = parse_hex(m.at("value").get<std::string>());
+          std::vector<uint8_t> mask = m.find("mask") != m.end() ? parse_hex(m["mask"].get<std::string>()) : std::vector<uint8_t>(value.size(), 0xff);
+          if (mask.size() != value.size() || value.empty())
+            {
+              throw std::runtime_error("mask and value of pattern " + names.back() + " differ in length");
+            }
+          if (value.size() > max_offset)
+            {
+              throw std::runtime_error("match value of pattern " + names.back() + " too long");
+            }
+
+          Match match{};
+          match.offset = static_cast<uint16_t>(parse_int(m.at("offset"), 0, max_offset, "match offset of pattern " + names.back()));
+          match.length = static_cast<uint16_t>(value.size());
+          match.bytes = static_cast<uint16_t>(bytes.size());
+          for (std::size_t i = 0; i < value.size(); i++)
+            {
+              // Pre-mask the value so matching is a single compare per byte.
+              value[i] &= mask[i];
+            }
+          bytes.insert(bytes.end(), mask.begin(), mask.end());
+          bytes.insert(bytes.end(), value.begin(), value.end());
+
+          matches_table.push_back(match);
+          min_size = std::max<std::size_t>(min_size, match.offset + match.length);
+        }
+    }
+  pattern.match_count = static_cast<uint16_t>(matches_table.size() - pattern.first_match);
+
+  pattern.first_field = static_cast<uint16_t>(fields.size());
+  for (const auto &f : definition.at("fields"))
+    {
+      Field field{};
+      field.name = static_cast<uint16_t>(names.size());
+      names.push_back(f.at("name").get<std::string>());
+      field.offset = static_cast<uint16_t>(parse_int(f.at("offset"), 0, max_offset, "offset for field " + names.back()));
+      field.width = static_cast<uint8_t>(parse_int(f.value("width", nlohmann::json(1)), 1, 4, "width for field " + names.back()));
+      field.big_endian = f.value("endian", std::string("little")) == "big";
+      field.is_signed = f.value("signed", false);
+      field.scale = f.value("scale", 1.0f);
+      field.bias = f.value("bias", 0.0f);
+
+      fields.push_back(field);
+      min_size = std::max<std::size_t>(min_size, field.offset + field.width);
+    }
+  pattern.field_count = static_cast<uint16_t>(fields.size() - pattern.first_field);
+  pattern.min_size = static_cast<uint16_t>(min_size);
+
+  patterns.push_back(pattern);
+}
+
+void
+PatternDecoder::compile()
+{
+  std::stable_sort(patterns.begin(), patterns.end(), [](const Pattern &a, const Pattern &b) {
+    return a.source < b.source || (a.source == b.source && a.id < b.id);
+  });
+  patterns.shrink_to_fit();
+  matches_table.shrink_to_fit();
+  fields.shrink_to_fit();
+  bytes.shrink_to_fit();
+}
+
+std::size_t
+PatternDecoder::size() const
+{
+  return patterns.size();
+}
+
+bool
+PatternDecoder::decode(const AdStructure &ad, nlohmann::json &info) const
+{
+  Pattern key{};
+  if (ad.is(AdType::ManufacturerSpecific))
+    {
+      key.source = Source::Manufacturer;
+    }
+  else if (ad.is(AdType::ServiceData16))
+    {
+      key.source = Source::ServiceData;
+    }
+  else
+    {
+      return false;
+    }
+
+  if (!ad.get_uint16(0, key.id))
+    {
+      return false;
+    }
+
+  const uint8_t *payload = ad.data + 2;
+  std::size_t size = ad.size - 2;
+
+  auto range = std::equal_range(patterns.begin(), patterns.end(), key, [](const Pattern &a, const Pattern &b) {
+    return a.source < b.source || (a.source == b.source && a.id < b.id);
+  });
+
+  bool recognized = false;
+  for (auto it = range.first; it != range.second; ++it)
+    {
+      if (size >= it->min_size && matches(*it, payload, size))
+        {
+          extract(*it, payload, info);
+          recognized = true;
+        }
+    }
+  return recognized;
+}
+
+bool
+PatternDecoder::matches(const Pattern &pattern, const uint8_t *payload, std::size_t size) const
+{
+  for (std::size_t m = pattern.first_match; m < pattern.first_match + pattern.match_count; m++)
+    {
+      const Match &match = matches_table[m];
+      const uint8_t *mask = &bytes[match.bytes];
+      const uint8_t *value = mask + match.length;
+
+      for (std::size_t i = 0; i < match.length; i++)
+        {
+          if ((payload[match.offset + i] & mask[i]) != value[i])
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+void
+PatternDecoder::extract(const Pattern &pattern, const uint8_t *payload, nlohmann::json &info) const
+{
+  nlohmann::json &j = info[names[pattern.name]];
+
+  for (std::size_t f = pattern.first_field; f < pattern.first_field + pattern.field_count; f++)
+    {
+      const Field &field = fields[f];
+      const uint8_t *data = payload + field.offset;
+
+      uint32_t raw = 0;
+      for (int i = 0; i < field.width; i++)
+        {
+          int index = field.big_endian ? i : field.width - 1 - i;
+          raw = (raw << 8) | data[index];
+        }
+
+      int64_t value = raw;
+      if (field.is_signed && field.width < 4 && (raw & (1u << (field.width * 8 - 1))) != 0)
+        {
+          value -= (int64_t(1) << (field.width * 8));
+        }
+      else if (field.is_signed && field.width == 4)
+        {
+          value = static_cast<int32_t>(raw);
+        }
+
+      if (field.scale == 1.0f && field.bias == 0.0f)
+        {
+          j[names[field.name]] = value;
+        }
+      else
+        {
+          j[names[field.name]] = static_cast<double>(value) * field.scale + field.bias;
+        }
+    }
+}
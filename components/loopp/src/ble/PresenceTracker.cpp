@@ -0,0 +1,180 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/PresenceTracker.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  DeviceTable<PresenceTracker::Device>::clock::time_point
+  to_time_point(std::int64_t now)
+  {
+    return DeviceTable<PresenceTracker::Device>::clock::time_point(std::chrono::microseconds(now));
+  }
+} // namespace
+
+PresenceTracker::PresenceTracker(const nlohmann::json &config)
+  : filter(config)
+  , devices(config.value("capacity", 64))
+{
+  enter_rssi = config.value("enter_rssi", enter_rssi);
+  exit_rssi = config.value("exit_rssi", exit_rssi);
+  change_threshold = config.value("change", change_threshold);
+  min_samples = config.value("min_samples", min_samples);
+  timeout_us = static_cast<std::int64_t>(config.value("timeout", 30.0) * 1e6);
+
+  if (exit_rssi > enter_rssi)
+    {
+      throw std::runtime_error("presence exit_rssi must not be above enter_rssi");
+    }
+  if (timeout_us <= 0)
+    {
+      throw std::runtime_error("presence timeout must be positive");
+    }
+
+  // Keep a share of the table for devices with a stable address, so that
+  // rotating private addresses do not push them out.
+  devices.set_private_limit(static_cast<std::size_t>(devices.capacity() * config.value("private_share", 0.5)));
+  devices.set_evict_handler([this](const Device &device) {
+    if (device.present)
+      {
+        evicted.push_back(device);
+      }
+  });
+}
+
+PresenceTracker::Event
+PresenceTracker::make_event(EventType type, const Device &device, std::int64_t now)
+{
+  Event event;
+  event.type = type;
+  memcpy(event.bda, device.bda, sizeof(event.bda));
+  event.addr_type = device.addr_type;
+  event.rssi = device.filter.estimate;
+  event.timestamp = now;
+  return event;
+}
+
+void
+PresenceTracker::update(const uint8_t bda[6], AddressType addr_type, int rssi, std::int64_t now, std::vector<Event> &events)
+{
+  bool created = false;
+  Device *device = devices.insert(bda, to_time_point(now), &created, addr_type);
+  for (const Device &d : evicted)
+    {
+      Event event = make_event(EventType::Exit, d, now);
+      event.evicted = true;
+      events.push_back(event);
+    }
+  evicted.clear();
+
+  if (device == nullptr)
+    {
+      return;
+    }
+
+  if (created)
+    {
+      memcpy(device->bda, bda, sizeof(device->bda));
+      device->addr_type = addr_type;
+    }
+
+  float estimate = filter.update(device->filter, rssi);
+  device->last_seen = now;
+
+  if (!device->present)
+    {
+      if (estimate >= enter_rssi && device->filter.samples >= min_samples)
+        {
+          device->present = true;
+          device->reported_rssi = estimate;
+          events.push_back(make_event(EventType::Enter, *device, now));
+        }
+    }
+  else if (estimate < exit_rssi)
+    {
+      device->present = false;
+      events.push_back(make_event(EventType::Exit, *device, now));
+    }
+  else if (std::fabs(estimate - device->reported_rssi) >= change_threshold)
+    {
+      device->reported_rssi = estimate;
+      events.push_back(make_event(EventType::Change, *device, now));
+    }
+}
+
+void
+PresenceTracker::expire(std::int64_t now, std::vector<Event> &events)
+{
+  std::vector<const Device *> absent;
+  devices.for_each([this, now, &absent](std::uint64_t, const Device &device) {
+    if (now - device.last_seen >= timeout_us)
+      {
+        absent.push_back(&device);
+      }
+  });
+
+  // Erasing moves entries around, so copy what is needed first.
+  std::vector<Event> expired;
+  expired.reserve(absent.size());
+  for (const Device *device : absent)
+    {
+      Event event = make_event(EventType::Exit, *device, now);
+      event.timed_out = device->present;
+      expired.push_back(event);
+    }
+
+  for (const Event &event : expired)
+    {
+      devices.erase(event.bda, event.addr_type);
+      if (event.timed_out)
+        {
+          events.push_back(event);
+        }
+    }
+}
+
+std::int64_t
+PresenceTracker::next_deadline() const
+{
+  std::int64_t deadline = 0;
+  devices.for_each([this, &deadline](std::uint64_t, const Device &device) {
+    std::int64_t t = device.last_seen + timeout_us;
+    if (deadline == 0 || t < deadline)
+      {
+        deadline = t;
+      }
+  });
+  return deadline;
+}
+
+std::size_t
+PresenceTracker::present_count() const
+{
+  std::size_t count = 0;
+  for_each_present([&count](const Device &) { count++; });
+  return count;
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/PriorityClassifier.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "loopp/ble/AdStructure.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  const uint16_t apple_company_id = 0x004C;
+  const uint8_t ibeacon_type = 0x02;
+  const uint8_t ibeacon_length = 0x15;
+  const std::size_t ibeacon_size = 25;
+
+  bool parse_uuid(const std::string &text, std::array<uint8_t, 16> &uuid)
+  {
+    std::string hex;
+    std::copy_if(text.begin(), text.end(), std::back_inserter(hex), [](char c) { return c != '-'; });
+    if (hex.size() != 2 * uuid.size() || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+      {
+        return false;
+      }
+
+    for (std::size_t i = 0; i < uuid.size(); i++)
+      {
+        uuid[i] = static_cast<uint8_t>(std::stoul(hex.substr(2 * i, 2), nullptr, 16));
+      }
+    return true;
+  }
+} // namespace
+
+PriorityClassifier::PriorityClassifier(const nlohmann::json &config)
+{
+  for (const auto &rule : config)
+    {
+      auto it = rule.find("ibeacon_uuid");
+      if (it != rule.end())
+        {
+          IBeaconRule r;
+          if (!parse_uuid(it->get<std::string>(), r.uuid))
+            {
+              throw std::runtime_error("invalid priority ibeacon uuid: " + it->get<std::string>());
+            }
+          r.major = rule.value("major", -1);
+          r.minor = rule.value("minor", -1);
+          if (r.major > 0xffff || r.minor > 0xffff)
+            {
+              throw std::runtime_error("invalid priority major/minor");
+            }
+          ibeacon_rules.push_back(r);
+          continue;
+        }
+
+      it = rule.find("company_id");
+      if (it != rule.end())
+        {
+          ManufacturerRule r;
+          unsigned long id = parse_number(*it);
+          if (id > std::numeric_limits<uint16_t>::max())
+            {
+              throw std::runtime_error("invalid priority company ID");
+            }
+          r.company_id = static_cast<uint16_t>(id);
+
+          auto offset = rule.find("offset");
+          if (offset != rule.end())
+            {
+              r.offset = offset->get<int>();
+              r.mask = static_cast<uint8_t>(parse_number(rule.value("mask", nlohmann::json(0xff))));
+              r.value = static_cast<uint8_t>(parse_number(rule.at("value")));
+              if (r.offset < 0)
+                {
+                  throw std::runtime_error("invalid priority offset");
+                }
+            }
+          manufacturer_rules.push_back(r);
+          continue;
+        }
+
+      throw std::runtime_error("priority rule needs an ibeacon_uuid or company_id");
+    }
+}
+
+unsigned long
+PriorityClassifier::parse_number(const nlohmann::json &value)
+{
+  return value.is_string() ? std::stoul(value.get<std::string>(), nullptr, 16) : value.get<unsigned long>();
+}
+
+bool
+PriorityClassifier::match(const uint8_t *adv_data, std::size_t size) const
+{
+  for (const auto &ad : AdParser(adv_data, size))
+    {
+      uint16_t company_id = 0;
+      if (!ad.is(AdType::ManufacturerSpecific) || !ad.get_uint16(0, company_id))
+        {
+          continue;
+        }
+
+      for (const auto &rule : manufacturer_rules)
+        {
+          if (rule.company_id != company_id)
+            {
+              continue;
+            }
+          if (rule.offset < 0)
+            {
+              return true;
+            }
+
+          std::size_t pos = 2 + static_cast<std::size_t>(rule.offset);
+          if (pos < ad.size && (ad.data[pos] & rule.mask) == rule.value)
+            {
+              return true;
+            }
+        }
+
+      if (!ibeacon_rules.empty() && company_id == apple_company_id && ad.size == ibeacon_size && ad.data[2] == ibeacon_type
+          && ad.data[3] == ibeacon_length)
+        {
+          int major = (ad.data[20] << 8) | ad.data[21];
+          int minor = (ad.data[22] << 8) | ad.data[23];
+          for (const auto &rule : ibeacon_rules)
+            {
+              if (std::memcmp(rule.uuid.data(), ad.data + 4, rule.uuid.size()) == 0 && (rule.major < 0 || rule.major == major)
+                  && (rule.minor < 0 || rule.minor == minor))
+                {
+                  return true;
+                }
+            }
+        }
+    }
+  return false;
+}
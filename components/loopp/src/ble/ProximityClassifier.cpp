@@ -0,0 +1,102 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/ProximityClassifier.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+ProximityClassifier::ProximityClassifier(const nlohmann::json &config)
+{
+  float immediate = config.value("immediate", 0.5f);
+  float near = config.value("near", 3.0f);
+  float path_loss_exponent = config.value("path_loss_exponent", 2.0f);
+  hysteresis = config.value("hysteresis", hysteresis);
+  min_samples = config.value("min_samples", min_samples);
+
+  if (immediate <= 0.0f || near <= immediate)
+    {
+      throw std::runtime_error("proximity zones must satisfy 0 < immediate < near");
+    }
+  if (path_loss_exponent <= 0.0f)
+    {
+      throw std::runtime_error("proximity path_loss_exponent must be positive");
+    }
+  if (hysteresis < 0.0f)
+    {
+      throw std::runtime_error("proximity hysteresis must not be negative");
+    }
+
+  // Inverse of RssiFilter::estimate_distance.
+  immediate_loss = 10.0f * path_loss_exponent * std::log10(immediate);
+  near_loss = 10.0f * path_loss_exponent * std::log10(near);
+}
+
+ProximityClassifier::Zone
+ProximityClassifier::classify(Zone current, float rssi, int measured_power, uint32_t samples) const
+{
+  if (samples < min_samples)
+    {
+      return Zone::Unknown;
+    }
+
+  float loss = static_cast<float>(measured_power) - rssi;
+
+  // Move each boundary away from the current zone, so that a beacon near a
+  // boundary does not flip between zones on every sample.
+  bool known = current != Zone::Unknown;
+  float immediate_boundary = immediate_loss;
+  float near_boundary = near_loss;
+  if (known)
+    {
+      immediate_boundary += current == Zone::Immediate ? hysteresis : -hysteresis;
+      near_boundary += current == Zone::Far ? -hysteresis : hysteresis;
+    }
+
+  if (loss < immediate_boundary)
+    {
+      return Zone::Immediate;
+    }
+  if (loss < near_boundary)
+    {
+      return Zone::Near;
+    }
+  return Zone::Far;
+}
+
+const char *
+ProximityClassifier::zone_name(Zone zone)
+{
+  switch (zone)
+    {
+    case Zone::Immediate:
+      return "immediate";
+    case Zone::Near:
+      return "near";
+    case Zone::Far:
+      return "far";
+    case Zone::Unknown:
+      break;
+    }
+  return "unknown";
+}
@@ -0,0 +1,92 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/RssiFilter.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+RssiFilter::RssiFilter(const nlohmann::json &config)
+{
+  auto it = config.find("type");
+  if (it != config.end())
+    {
+      std::string t = *it;
+
+      if (t == "ema")
+        {
+          type = Type::Ema;
+        }
+      else if (t == "kalman")
+        {
+          type = Type::Kalman;
+        }
+      else
+        {
+          throw std::runtime_error("invalid rssi filter type: " + t);
+        }
+    }
+
+  alpha = config.value("alpha", alpha);
+  process_noise = config.value("process_noise", process_noise);
+  measurement_noise = config.value("measurement_noise", measurement_noise);
+  path_loss_exponent = config.value("path_loss_exponent", path_loss_exponent);
+
+  if (alpha <= 0.0f || alpha > 1.0f)
+    {
+      throw std::runtime_error("rssi filter alpha must be in (0, 1]");
+    }
+}
+
+float
+RssiFilter::update(State &state, int rssi) const
+{
+  float z = static_cast<float>(rssi);
+
+  if (state.samples == 0)
+    {
+      state.estimate = z;
+      state.error = measurement_noise;
+    }
+  else if (type == Type::Ema)
+    {
+      state.estimate += alpha * (z - state.estimate);
+    }
+  else
+    {
+      // One dimensional Kalman filter with a constant (random walk) model.
+      float p = state.error + process_noise;
+      float k = p / (p + measurement_noise);
+      state.estimate += k * (z - state.estimate);
+      state.error = (1.0f - k) * p;
+    }
+
+  state.samples++;
+  return state.estimate;
+}
+
+float
+RssiFilter::estimate_distance(float rssi, int measured_power) const
+{
+  return std::pow(10.0f, (static_cast<float>(measured_power) - rssi) / (10.0f * path_loss_exponent));
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/ScanBatch.hpp"
+
+#include <algorithm>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+void
+ScanBatch::reserve(std::size_t size)
+{
+  records.reserve(size);
+  timestamps.reserve(size);
+}
+
+void
+ScanBatch::add(std::string record, std::int64_t timestamp)
+{
+  base_time = records.empty() ? timestamp : std::min(base_time, timestamp);
+  records.push_back(std::move(record));
+  timestamps.push_back(timestamp);
+}
+
+bool
+ScanBatch::empty() const
+{
+  return records.empty();
+}
+
+std::size_t
+ScanBatch::size() const
+{
+  return records.size();
+}
+
+std::int64_t
+ScanBatch::get_base_time() const
+{
+  return base_time;
+}
+
+const std::vector<std::int64_t> &
+ScanBatch::get_timestamps() const
+{
+  return timestamps;
+}
+
+std::vector<std::string>
+ScanBatch::take_records()
+{
+  // Append the offset to the closing brace, instead of parsing the records
+  // again.
+  for (std::size_t i = 0; i < records.size(); i++)
+    {
+      std::string &r = records[i];
+      r.pop_back();
+      if (r.size() > 1)
+        {
+          r += ',';
+        }
+      r += "\"dt\":";
+      r += std::to_string(timestamps[i] - base_time);
+      r += '}';
+    }
+  std::vector<std::string> result;
+  result.swap(records);
+  return result;
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/ScanCoverage.hpp"
+
+#include <algorithm>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+void
+ScanCoverage::reset(std::int64_t now)
+{
+  period_start = now;
+  on_time = 0;
+  started_at = now;
+  stopped_at = -1;
+  report = Report();
+}
+
+void
+ScanCoverage::scan_started(std::int64_t now)
+{
+  if (scanning)
+    {
+      return;
+    }
+
+  if (stopped_at >= 0)
+    {
+      report.last_gap_us = now - stopped_at;
+      report.max_gap_us = std::max(report.max_gap_us, report.last_gap_us);
+      report.restarts++;
+    }
+
+  scanning = true;
+  started_at = now;
+}
+
+void
+ScanCoverage::scan_stopped(std::int64_t now)
+{
+  if (!scanning)
+    {
+      return;
+    }
+
+  on_time += now - std::max(started_at, period_start);
+  scanning = false;
+  stopped_at = now;
+}
+
+bool
+ScanCoverage::is_scanning() const
+{
+  return scanning;
+}
+
+ScanCoverage::Report
+ScanCoverage::take_report(std::int64_t now)
+{
+  std::int64_t on = on_time;
+  if (scanning)
+    {
+      on += now - std::max(started_at, period_start);
+    }
+
+  Report result = report;
+  std::int64_t period = now - period_start;
+  result.duty_cycle = period > 0 ? 100.0f * static_cast<float>(on) / static_cast<float>(period) : (scanning ? 100.0f : 0.0f);
+
+  period_start = now;
+  on_time = 0;
+  report.max_gap_us = 0;
+  report.restarts = 0;
+
+  return result;
+}
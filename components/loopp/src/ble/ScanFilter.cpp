@@ -0,0 +1,239 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/ScanFilter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include "loopp/ble/AdStructure.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+namespace
+{
+  const uint16_t apple_company_id = 0x004C;
+  const uint8_t ibeacon_type = 0x02;
+  const uint8_t ibeacon_length = 0x15;
+} // namespace
+
+ScanFilter::ScanFilter(const nlohmann::json &config)
+{
+  min_rssi = config.value("min_rssi", -128);
+
+  auto it = config.find("allow");
+  if (it != config.end())
+    {
+      allow.load(*it);
+    }
+
+  it = config.find("deny");
+  if (it != config.end())
+    {
+      deny.load(*it);
+    }
+}
+
+std::uint64_t
+ScanFilter::make_address(const uint8_t bda[6])
+{
+  std::uint64_t address = 0;
+  for (int i = 0; i < 6; i++)
+    {
+      address = (address << 8) | bda[i];
+    }
+  return address;
+}
+
+std::vector<uint8_t>
+ScanFilter::parse_bytes(const std::string &text)
+{
+  std::string hex;
+  std::copy_if(text.begin(), text.end(), std::back_inserter(hex), [](char c) { return c != ':' && c != '-'; });
+
+  if (hex.empty() || hex.size() % 2 != 0)
+    {
+      throw std::runtime_error("invalid hex string: " + text);
+    }
+
+  std::vector<uint8_t> out;
+  for (std::size_t i = 0; i < hex.size(); i += 2)
+    {
+      out.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    }
+  return out;
+}
+
+void
+ScanFilter::Rules::load(const nlohmann::json &config)
+{
+  auto it = config.find("mac");
+  if (it != config.end())
+    {
+      for (const auto &mac : *it)
+        {
+          std::vector<uint8_t> bda = parse_bytes(mac.get<std::string>());
+          if (bda.size() != 6)
+            {
+              throw std::runtime_error("invalid mac address: " + mac.get<std::string>());
+            }
+          addresses.push_back(make_address(bda.data()));
+        }
+      std::sort(addresses.begin(), addresses.end());
+      addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    }
+
+  it = config.find("mac_prefix");
+  if (it != config.end())
+    {
+      for (const auto &mac : *it)
+        {
+          std::vector<uint8_t> bytes = parse_bytes(mac.get<std::string>());
+          if (bytes.size() > 6)
+            {
+              throw std::runtime_error("invalid mac prefix: " + mac.get<std::string>());
+            }
+
+          uint8_t bda[6] = { 0 };
+          uint8_t mask[6] = { 0 };
+          std::copy(bytes.begin(), bytes.end(), bda);
+          std::fill(mask, mask + bytes.size(), 0xff);
+          prefixes.push_back(Prefix{ make_address(bda), make_address(mask) });
+        }
+    }
+
+  it = config.find("ibeacon_uuid");
+  if (it != config.end())
+    {
+      for (const auto &uuid : *it)
+        {
+          std::vector<uint8_t> bytes = parse_bytes(uuid.get<std::string>());
+          if (bytes.size() != 16)
+            {
+              throw std::runtime_error("invalid ibeacon uuid: " + uuid.get<std::string>());
+            }
+          Uuid u;
+          std::copy(bytes.begin(), bytes.end(), u.begin());
+          uuids.push_back(u);
+        }
+      std::sort(uuids.begin(), uuids.end());
+    }
+
+  it = config.find("company_id");
+  if (it != config.end())
+    {
+      for (const auto &value : *it)
+        {
+          unsigned long id = value.is_string() ? std::stoul(value.get<std::string>(), nullptr, 16) : value.get<unsigned long>();
+          if (id > std::numeric_limits<uint16_t>::max())
+            {
+              throw std::runtime_error("invalid company ID");
+            }
+          company_ids.push_back(static_cast<uint16_t>(id));
+        }
+      std::sort(company_ids.begin(), company_ids.end());
+    }
+}
+
+bool
+ScanFilter::Rules::empty() const
+{
+  return addresses.empty() && prefixes.empty() && !needs_adv_data();
+}
+
+bool
+ScanFilter::Rules::needs_adv_data() const
+{
+  return !uuids.empty() || !company_ids.empty();
+}
+
+bool
+ScanFilter::Rules::match_address(std::uint64_t address) const
+{
+  if (std::binary_search(addresses.begin(), addresses.end(), address))
+    {
+      return true;
+    }
+
+  for (const auto &prefix : prefixes)
+    {
+      if ((address & prefix.mask) == prefix.value)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+ScanFilter::Rules::match_adv_data(const uint8_t *adv_data, std::size_t size) const
+{
+  for (const auto &ad : AdParser(adv_data, size))
+    {
+      uint16_t company_id = 0;
+      if (!ad.is(AdType::ManufacturerSpecific) || !ad.get_uint16(0, company_id))
+        {
+          continue;
+        }
+
+      if (std::binary_search(company_ids.begin(), company_ids.end(), company_id))
+        {
+          return true;
+        }
+
+      if (!uuids.empty() && company_id == apple_company_id && ad.size == 25 && ad.data[2] == ibeacon_type && ad.data[3] == ibeacon_length)
+        {
+          Uuid uuid;
+          std::memcpy(uuid.data(), ad.data + 4, uuid.size());
+          if (std::binary_search(uuids.begin(), uuids.end(), uuid))
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+bool
+ScanFilter::accept(const uint8_t bda[6], int rssi, const uint8_t *adv_data, std::size_t size) const
+{
+  if (rssi < min_rssi)
+    {
+      return false;
+    }
+
+  std::uint64_t address = make_address(bda);
+
+  if (deny.match_address(address) || (deny.needs_adv_data() && deny.match_adv_data(adv_data, size)))
+    {
+      return false;
+    }
+
+  if (allow.empty())
+    {
+      return true;
+    }
+
+  return allow.match_address(address) || (allow.needs_adv_data() && allow.match_adv_data(adv_data, size));
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/ScanPipeline.hpp"
+
+#include "esp_log.h"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+static const char *tag = "SCAN-PIPELINE";
+
+ScanPipeline::ScanPipeline(std::size_t capacity, Encoder encoder)
+  : encoder(std::move(encoder))
+  , captured(capacity)
+  , encoded(capacity)
+{
+}
+
+ScanPipeline::~ScanPipeline()
+{
+  stop();
+}
+
+void
+ScanPipeline::start(loopp::core::Task::CoreId core)
+{
+  if (running)
+    {
+      return;
+    }
+
+  running = true;
+  task = std::make_unique<loopp::core::Task>("scan_decode", [this]() { decode_task(); }, core, 4096);
+}
+
+void
+ScanPipeline::stop()
+{
+  if (!running)
+    {
+      return;
+    }
+
+  running = false;
+  wakeup.give();
+  stopped.take();
+  task.reset();
+}
+
+void
+ScanPipeline::Counters::update_depth(std::size_t depth)
+{
+  if (depth > max_depth.load(std::memory_order_relaxed))
+    {
+      max_depth.store(depth, std::memory_order_relaxed);
+    }
+}
+
+ScanPipeline::StageStats
+ScanPipeline::Counters::take(std::size_t depth)
+{
+  StageStats stats;
+  stats.processed = processed.exchange(0);
+  stats.dropped = dropped.exchange(0);
+  stats.max_depth = max_depth.exchange(0);
+  stats.depth = depth;
+  return stats;
+}
+
+bool
+ScanPipeline::capture(const BLEScanner::ScanResult &result)
+{
+  if (!captured.try_push(result))
+    {
+      capture_counters.dropped++;
+      return false;
+    }
+
+  capture_counters.processed++;
+  capture_counters.update_depth(captured.size());
+  wakeup.give();
+  return true;
+}
+
+void
+ScanPipeline::decode_task()
+{
+  BLEScanner::ScanResult result;
+  for (;;)
+    {
+      // The timeout rechecks the output ring after it was full.
+      wakeup.take(std::chrono::milliseconds(10));
+      if (!running)
+        {
+          // Signal stop() exactly once and block until it deletes the task.
+          // Giving again would leave a stale count that lets a later stop()
+          // return while a new decode task is still running.
+          stopped.give();
+          for (;;)
+            {
+              wakeup.take();
+            }
+        }
+
+      // The decode task is the only producer of encoded, so once there is
+      // room it stays available. When the publish stage falls behind,
+      // results back up in the capture ring and are dropped there, before
+      // any work was spent on them.
+      while (encoded.size() < encoded.capacity() && captured.try_pop(result))
+        {
+          Record record;
+          record.timestamp = result.timestamp;
+
+          bool ok = false;
+          try
+            {
+              ok = encoder(result, record.data);
+            }
+          catch (std::exception &e)
+            {
+              ESP_LOGE(tag, "Failed to encode scan result: %s", e.what());
+            }
+
+          if (!ok || !encoded.try_push(std::move(record)))
+            {
+              decode_counters.dropped++;
+              continue;
+            }
+          decode_counters.processed++;
+          decode_counters.update_depth(encoded.size());
+        }
+    }
+}
+
+std::size_t
+ScanPipeline::drain(std::vector<Record> &records)
+{
+  std::size_t count = 0;
+  Record record;
+  while (encoded.try_pop(record))
+    {
+      records.push_back(std::move(record));
+      count++;
+    }
+  published += count;
+  if (count > 0 && running)
+    {
+      // The decode stage may be waiting for room.
+      wakeup.give();
+    }
+  return count;
+}
+
+ScanPipeline::Stats
+ScanPipeline::take_stats()
+{
+  Stats stats;
+  stats.capture = capture_counters.take(captured.size());
+  stats.decode = decode_counters.take(encoded.size());
+  stats.published = published;
+  published = 0;
+  return stats;
+}
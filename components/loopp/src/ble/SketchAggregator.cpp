@@ -0,0 +1,157 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/SketchAggregator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "loopp/ble/AdStructure.hpp"
+#include "loopp/core/Hash.hpp"
+
+#include "DecoderUtils.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+using json = nlohmann::json;
+
+namespace
+{
+  std::string
+  mac_as_string(std::uint64_t key)
+  {
+    char mac[18];
+    std::snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x", static_cast<unsigned>((key >> 40) & 0xff), static_cast<unsigned>((key >> 32) & 0xff),
+                  static_cast<unsigned>((key >> 24) & 0xff), static_cast<unsigned>((key >> 16) & 0xff), static_cast<unsigned>((key >> 8) & 0xff),
+                  static_cast<unsigned>(key & 0xff));
+    return mac;
+  }
+
+  json
+  to_json(const std::vector<loopp::core::TopK::Item> &items, const char *label_name)
+  {
+    json result = json::array();
+    for (const auto &item : items)
+      {
+        json j;
+        j[label_name] = item.label.empty() ? mac_as_string(item.key) : item.label;
+        j["count"] = item.count;
+        j["rssi_max"] = item.max_rssi;
+        result.push_back(j);
+      }
+    return result;
+  }
+} // namespace
+
+SketchAggregator::SketchAggregator(const nlohmann::json &config)
+  : unique_devices(config.value("precision", 10u))
+  , unique_ibeacons(config.value("precision", 10u))
+  , device_counts(config.value("width", 256u), config.value("depth", 4u))
+  , uuid_counts(config.value("width", 256u), config.value("depth", 4u))
+  , top_devices(config.value("top", 10u))
+  , top_uuids(config.value("top", 10u))
+{
+}
+
+bool
+SketchAggregator::get_ibeacon(const std::string &adv_data, const uint8_t *&data)
+{
+  for (const auto &ad : AdParser(adv_data))
+    {
+      uint16_t company_id = 0;
+      if (ad.is(AdType::ManufacturerSpecific) && ad.size == 25 && ad.get_uint16(0, company_id) && company_id == 0x004C && ad.data[2] == 0x02
+          && ad.data[3] == 0x15)
+        {
+          data = ad.data + 4;
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+SketchAggregator::add(const BLEScanner::ScanResult &result)
+{
+  advertisements++;
+
+  std::uint64_t key = 0;
+  for (int i = 0; i < 6; i++)
+    {
+      key = (key << 8) | result.bda[i];
+    }
+  unique_devices.add(key);
+
+  bool inserted = false;
+  loopp::core::TopK::Item *item = top_devices.offer(key, device_counts.add(key), inserted);
+  if (item != nullptr)
+    {
+      item->max_rssi = inserted ? result.rssi : std::max(item->max_rssi, result.rssi);
+    }
+
+  const uint8_t *ibeacon = nullptr;
+  if (get_ibeacon(result.adv_data, ibeacon))
+    {
+      // UUID, major and minor.
+      unique_ibeacons.add(loopp::core::hash_bytes(ibeacon, 20));
+
+      std::uint64_t uuid_key = loopp::core::hash_bytes(ibeacon, 16);
+      item = top_uuids.offer(uuid_key, uuid_counts.add(uuid_key), inserted);
+      if (item != nullptr)
+        {
+          if (inserted)
+            {
+              item->label = detail::uuid_as_string(ibeacon);
+              item->max_rssi = result.rssi;
+            }
+          item->max_rssi = std::max(item->max_rssi, result.rssi);
+        }
+    }
+}
+
+json
+SketchAggregator::summary() const
+{
+  json j;
+  j["advertisements"] = advertisements;
+  j["unique_devices"] = unique_devices.estimate();
+  j["unique_ibeacons"] = unique_ibeacons.estimate();
+  j["top_devices"] = to_json(top_devices.sorted(), "mac");
+  j["top_uuids"] = to_json(top_uuids.sorted(), "uuid");
+  return j;
+}
+
+void
+SketchAggregator::clear()
+{
+  advertisements = 0;
+  unique_devices.clear();
+  unique_ibeacons.clear();
+  device_counts.clear();
+  uuid_counts.clear();
+  top_devices.clear();
+  top_uuids.clear();
+}
+
+std::size_t
+SketchAggregator::memory_size() const
+{
+  return unique_devices.memory_size() + unique_ibeacons.memory_size() + device_counts.memory_size() + uuid_counts.memory_size();
+}
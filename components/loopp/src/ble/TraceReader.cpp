@@ -0,0 +1,173 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/TraceReader.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "loopp/ble/TraceRecorder.hpp"
+
+using namespace loopp;
+using namespace loopp::ble;
+
+TraceReader::TraceReader(const std::string &path)
+{
+#ifdef __linux__
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    {
+      throw std::system_error(errno, std::generic_category(), "Could not open trace " + path);
+    }
+
+  struct stat st;
+  if (::fstat(fd, &st) < 0)
+    {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "Could not stat trace " + path);
+    }
+
+  size = static_cast<std::size_t>(st.st_size);
+  if (size > 0)
+    {
+      void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED)
+        {
+          int error = errno;
+          ::close(fd);
+          throw std::system_error(error, std::generic_category(), "Could not map trace " + path);
+        }
+      ::madvise(mapping, size, MADV_SEQUENTIAL);
+      data = static_cast<const uint8_t *>(mapping);
+    }
+#else
+  file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr)
+    {
+      throw std::system_error(errno, std::generic_category(), "Could not open trace " + path);
+    }
+#endif
+
+  uint8_t header[TraceRecorder::header_size];
+  if (!read(header, sizeof(header)) || std::memcmp(header, TraceRecorder::magic, sizeof(TraceRecorder::magic)) != 0
+      || header[4] != TraceRecorder::version)
+    {
+      close();
+      throw std::runtime_error("invalid trace " + path);
+    }
+}
+
+TraceReader::~TraceReader()
+{
+  close();
+}
+
+void
+TraceReader::close()
+{
+#ifdef __linux__
+  if (data != nullptr)
+    {
+      ::munmap(const_cast<uint8_t *>(data), size);
+      data = nullptr;
+    }
+  if (fd >= 0)
+    {
+      ::close(fd);
+      fd = -1;
+    }
+#else
+  if (file != nullptr)
+    {
+      std::fclose(file);
+      file = nullptr;
+    }
+#endif
+}
+
+bool
+TraceReader::read(uint8_t *buffer, std::size_t length)
+{
+#ifdef __linux__
+  if (size - pos < length)
+    {
+      return false;
+    }
+  std::memcpy(buffer, data + pos, length);
+  pos += length;
+  return true;
+#else
+  return std::fread(buffer, 1, length, file) == length;
+#endif
+}
+
+bool
+TraceReader::next(BLEScanner::ScanResult &result)
+{
+  uint8_t header[TraceRecorder::record_header_size];
+  if (!read(header, sizeof(header)))
+    {
+      return false;
+    }
+
+  uint64_t timestamp = 0;
+  for (int i = 7; i >= 0; i--)
+    {
+      timestamp = (timestamp << 8) | header[i];
+    }
+  result.timestamp = static_cast<int64_t>(timestamp);
+  std::memcpy(result.bda, header + 8, 6);
+  result.ble_addr_type = header[14];
+  result.rssi = static_cast<int8_t>(header[15]);
+
+  std::size_t length = header[16];
+#ifdef __linux__
+  if (size - pos < length)
+    {
+      return false;
+    }
+  result.adv_data.assign(reinterpret_cast<const char *>(data + pos), length);
+  pos += length;
+  return true;
+#else
+  result.adv_data.resize(length);
+  return read(reinterpret_cast<uint8_t *>(&result.adv_data[0]), length);
+#endif
+}
+
+void
+TraceReader::rewind()
+{
+#ifdef __linux__
+  pos = TraceRecorder::header_size;
+#else
+  std::fseek(file, TraceRecorder::header_size, SEEK_SET);
+#endif
+}
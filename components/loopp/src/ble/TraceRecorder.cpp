@@ -0,0 +1,104 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/TraceRecorder.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+using namespace loopp;
+using namespace loopp::ble;
+
+constexpr std::size_t TraceRecorder::header_size;
+constexpr std::size_t TraceRecorder::record_header_size;
+constexpr std::uint8_t TraceRecorder::version;
+const char TraceRecorder::magic[4] = { 'L', 'P', 'T', 'R' };
+
+TraceRecorder::TraceRecorder(const std::string &path)
+{
+  file = std::fopen(path.c_str(), "ab+");
+  if (file == nullptr)
+    {
+      throw std::system_error(errno, std::generic_category(), "Could not open trace " + path);
+    }
+
+  // Opened for appending, so only a new file gets a header. Records are only
+  // appended to a trace in the same format.
+  uint8_t header[header_size] = { 0 };
+  std::fseek(file, 0, SEEK_END);
+  if (std::ftell(file) == 0)
+    {
+      std::memcpy(header, magic, sizeof(magic));
+      header[4] = version;
+      std::fwrite(header, 1, sizeof(header), file);
+    }
+  else
+    {
+      std::fseek(file, 0, SEEK_SET);
+      if (std::fread(header, 1, sizeof(header), file) != sizeof(header) || std::memcmp(header, magic, sizeof(magic)) != 0 || header[4] != version)
+        {
+          std::fclose(file);
+          throw std::runtime_error("Cannot append to trace " + path + ": invalid header or version");
+        }
+    }
+}
+
+TraceRecorder::~TraceRecorder()
+{
+  std::fclose(file);
+}
+
+void
+TraceRecorder::record(const BLEScanner::ScanResult &result)
+{
+  std::size_t length = std::min<std::size_t>(result.adv_data.size(), 255);
+
+  uint8_t header[record_header_size];
+  uint64_t timestamp = static_cast<uint64_t>(result.timestamp);
+  for (int i = 0; i < 8; i++)
+    {
+      header[i] = static_cast<uint8_t>(timestamp >> (8 * i));
+    }
+  std::memcpy(header + 8, result.bda, 6);
+  header[14] = result.ble_addr_type;
+  header[15] = static_cast<uint8_t>(static_cast<int8_t>(result.rssi));
+  header[16] = static_cast<uint8_t>(length);
+
+  if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header) || std::fwrite(result.adv_data.data(), 1, length, file) != length)
+    {
+      throw std::system_error(errno, std::generic_category(), "Could not write trace");
+    }
+  count++;
+}
+
+void
+TraceRecorder::flush()
+{
+  std::fflush(file);
+}
+
+std::uint32_t
+TraceRecorder::get_count() const
+{
+  return count;
+}
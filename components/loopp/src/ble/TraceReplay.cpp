@@ -0,0 +1,188 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/ble/TraceReplay.hpp"
+
+#include <algorithm>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *tag = "BLE";
+
+using namespace loopp;
+using namespace loopp::ble;
+
+constexpr int TraceReplay::fast_slice;
+
+TraceReplay::TraceReplay(std::shared_ptr<loopp::core::MainLoop> loop,
+                         std::shared_ptr<ScanSource> reader,
+                         loopp::core::Signal<void(const BLEScanner::ScanResult &)> &signal)
+  : loop(std::move(loop))
+  , reader(std::move(reader))
+  , signal(signal)
+{
+}
+
+void
+TraceReplay::set_speed(double speed)
+{
+  this->speed = std::max(speed, 0.0);
+}
+
+void
+TraceReplay::set_repeat(bool repeat)
+{
+  this->repeat = repeat;
+}
+
+void
+TraceReplay::start(complete_callback_t complete)
+{
+  stop();
+
+  this->complete = std::move(complete);
+  running = true;
+  count = 0;
+  reader->rewind();
+  has_next = reader->next(next);
+  trace_start = next.timestamp;
+  replay_start = esp_timer_get_time();
+
+  auto self = shared_from_this();
+  loop->invoke([this, self]() { replay(); });
+}
+
+void
+TraceReplay::stop()
+{
+  running = false;
+  if (timer != 0)
+    {
+      loop->cancel_timer(timer);
+      timer = 0;
+    }
+}
+
+std::uint32_t
+TraceReplay::get_count() const
+{
+  return count;
+}
+
+bool
+TraceReplay::fetch()
+{
+  has_next = reader->next(next);
+  if (!has_next && repeat && count > 0)
+    {
+      reader->rewind();
+      has_next = reader->next(next);
+      // Continue the timeline after the last replayed record.
+      replay_start = esp_timer_get_time();
+      trace_start = next.timestamp;
+    }
+  return has_next;
+}
+
+void
+TraceReplay::replay()
+{
+  if (!running)
+    {
+      return;
+    }
+
+  if (speed == 0.0)
+    {
+      replay_fast();
+      return;
+    }
+
+  int64_t now = esp_timer_get_time();
+  while (has_next)
+    {
+      int64_t due = replay_start + static_cast<int64_t>(static_cast<double>(next.timestamp - trace_start) / speed);
+      if (due > now)
+        {
+          break;
+        }
+
+      next.timestamp = due;
+      signal(next);
+      count++;
+      fetch();
+    }
+
+  schedule();
+}
+
+void
+TraceReplay::replay_fast()
+{
+  for (int i = 0; i < fast_slice && has_next; i++)
+    {
+      next.timestamp = esp_timer_get_time();
+      signal(next);
+      count++;
+      fetch();
+    }
+
+  if (!has_next)
+    {
+      finish();
+      return;
+    }
+
+  auto self = shared_from_this();
+  loop->invoke([this, self]() { replay(); });
+}
+
+void
+TraceReplay::schedule()
+{
+  if (!has_next)
+    {
+      finish();
+      return;
+    }
+
+  int64_t due = replay_start + static_cast<int64_t>(static_cast<double>(next.timestamp - trace_start) / speed);
+  int64_t delay_ms = std::max<int64_t>((due - esp_timer_get_time()) / 1000, 0);
+
+  auto self = shared_from_this();
+  timer = loop->add_timer(std::chrono::milliseconds(delay_ms), [this, self]() {
+    timer = 0;
+    replay();
+  });
+}
+
+void
+TraceReplay::finish()
+{
+  running = false;
+  ESP_LOGI(tag, "Replayed %u advertisements", static_cast<unsigned>(count));
+  if (complete)
+    {
+      complete_callback_t cb = std::move(complete);
+      complete = nullptr;
+      cb();
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/BootTimeline.hpp"
+
+#include <algorithm>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "loopp/core/ScopedLock.hpp"
+
+using namespace loopp;
+using namespace loopp::core;
+
+static const char *tag = "BOOT";
+
+BootTimeline &
+BootTimeline::instance()
+{
+  static BootTimeline instance;
+  return instance;
+}
+
+bool
+BootTimeline::mark(const std::string &name)
+{
+  return mark(name, esp_timer_get_time());
+}
+
+bool
+BootTimeline::mark(const std::string &name, int64_t time_us)
+{
+  {
+    ScopedLock l(mutex);
+    if (std::any_of(phases.begin(), phases.end(), [&name](const Phase &p) { return p.name == name; }))
+      {
+        return false;
+      }
+    phases.push_back(Phase{ name, time_us });
+  }
+
+  ESP_LOGI(tag, "%s at %d ms", name.c_str(), static_cast<int>(time_us / 1000));
+  signal_phase(name);
+  return true;
+}
+
+int64_t
+BootTimeline::get(const std::string &name) const
+{
+  ScopedLock l(mutex);
+  auto it = std::find_if(phases.begin(), phases.end(), [&name](const Phase &p) { return p.name == name; });
+  return it != phases.end() ? it->time_us : -1;
+}
+
+std::vector<BootTimeline::Phase>
+BootTimeline::get_phases() const
+{
+  ScopedLock l(mutex);
+  return phases;
+}
+
+loopp::core::Signal<void(std::string)> &
+BootTimeline::phase_signal()
+{
+  return signal_phase;
+}
@@ -0,0 +1,140 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/ClockSync.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace loopp;
+using namespace loopp::core;
+
+constexpr std::size_t ClockSync::filter_size;
+constexpr std::size_t ClockSync::history_size;
+constexpr std::int64_t ClockSync::min_drift_span;
+
+void
+ClockSync::add_sample(std::int64_t t1, std::int64_t t2, std::int64_t t3, std::int64_t t4)
+{
+  Sample sample;
+  sample.local = t1 + (t4 - t1) / 2;
+  sample.offset = ((t2 - t1) + (t3 - t4)) / 2;
+  sample.delay = std::max<std::int64_t>((t4 - t1) - (t3 - t2), 0);
+
+  samples.push_back(sample);
+  if (samples.size() > filter_size)
+    {
+      samples.pop_front();
+    }
+
+  auto best = std::min_element(samples.begin(), samples.end(), [](const Sample &a, const Sample &b) { return a.delay < b.delay; });
+
+  // The same exchange can remain the best one for several rounds; it only
+  // contributes to the fit once.
+  if (history.empty() || history.back().local != best->local)
+    {
+      history.push_back(*best);
+      if (history.size() > history_size)
+        {
+          history.pop_front();
+        }
+      fit();
+    }
+}
+
+void
+ClockSync::reset()
+{
+  samples.clear();
+  history.clear();
+  reference_local = 0;
+  intercept = 0.0;
+  slope = 0.0;
+}
+
+void
+ClockSync::fit()
+{
+  reference_local = history.back().local;
+  intercept = static_cast<double>(history.back().offset);
+  slope = 0.0;
+
+  std::int64_t span = history.back().local - history.front().local;
+  if (history.size() < 3 || span < min_drift_span)
+    {
+      return;
+    }
+
+  double n = static_cast<double>(history.size());
+  double sum_x = 0.0;
+  double sum_y = 0.0;
+  for (const auto &s : history)
+    {
+      sum_x += static_cast<double>(s.local - reference_local);
+      sum_y += static_cast<double>(s.offset);
+    }
+
+  double mean_x = sum_x / n;
+  double mean_y = sum_y / n;
+  double sxx = 0.0;
+  double sxy = 0.0;
+  for (const auto &s : history)
+    {
+      double dx = static_cast<double>(s.local - reference_local) - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (static_cast<double>(s.offset) - mean_y);
+    }
+
+  if (sxx > 0.0)
+    {
+      slope = sxy / sxx;
+      intercept = mean_y - slope * mean_x;
+    }
+}
+
+bool
+ClockSync::is_synchronized() const
+{
+  return !history.empty();
+}
+
+std::int64_t
+ClockSync::get_offset(std::int64_t local) const
+{
+  return static_cast<std::int64_t>(std::llround(intercept + slope * static_cast<double>(local - reference_local)));
+}
+
+std::int64_t
+ClockSync::to_reference(std::int64_t local) const
+{
+  return local + get_offset(local);
+}
+
+double
+ClockSync::get_drift_ppm() const
+{
+  return -slope * 1e6;
+}
+
+std::int64_t
+ClockSync::get_delay() const
+{
+  return history.empty() ? 0 : history.back().delay;
+}
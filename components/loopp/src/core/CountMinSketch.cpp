@@ -0,0 +1,111 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/CountMinSketch.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "loopp/core/Hash.hpp"
+
+using namespace loopp;
+using namespace loopp::core;
+
+constexpr std::size_t CountMinSketch::max_depth;
+
+CountMinSketch::CountMinSketch(std::size_t width, std::size_t depth)
+  : width(width)
+  , depth(depth)
+{
+  if (width == 0 || depth == 0 || depth > max_depth)
+    {
+      throw std::runtime_error("invalid Count-Min sketch dimensions");
+    }
+  counters.resize(width * depth);
+}
+
+void
+CountMinSketch::get_slots(std::uint64_t key, std::size_t *slots) const
+{
+  // Derive the row hashes from two halves of one hash (Kirsch-Mitzenmacher).
+  std::uint64_t h = mix64(key);
+  std::uint32_t h1 = static_cast<std::uint32_t>(h);
+  std::uint32_t h2 = static_cast<std::uint32_t>(h >> 32) | 1;
+  for (std::size_t row = 0; row < depth; row++)
+    {
+      slots[row] = row * width + (h1 + row * h2) % width;
+    }
+}
+
+std::uint32_t
+CountMinSketch::add(std::uint64_t key, std::uint32_t count)
+{
+  std::size_t slots[max_depth];
+  get_slots(key, slots);
+
+  std::uint32_t current = std::numeric_limits<std::uint32_t>::max();
+  for (std::size_t row = 0; row < depth; row++)
+    {
+      current = std::min(current, counters[slots[row]]);
+    }
+  std::uint32_t target = current > std::numeric_limits<std::uint32_t>::max() - count ? std::numeric_limits<std::uint32_t>::max() : current + count;
+
+  // Conservative update: only raise counters that are below the new estimate.
+  for (std::size_t row = 0; row < depth; row++)
+    {
+      counters[slots[row]] = std::max(counters[slots[row]], target);
+    }
+  sum += count;
+  return target;
+}
+
+std::uint32_t
+CountMinSketch::estimate(std::uint64_t key) const
+{
+  std::size_t slots[max_depth];
+  get_slots(key, slots);
+
+  std::uint32_t result = std::numeric_limits<std::uint32_t>::max();
+  for (std::size_t row = 0; row < depth; row++)
+    {
+      result = std::min(result, counters[slots[row]]);
+    }
+  return result;
+}
+
+void
+CountMinSketch::clear()
+{
+  std::fill(counters.begin(), counters.end(), 0);
+  sum = 0;
+}
+
+std::uint64_t
+CountMinSketch::total() const
+{
+  return sum;
+}
+
+std::size_t
+CountMinSketch::memory_size() const
+{
+  return counters.size() * sizeof(std::uint32_t);
+}
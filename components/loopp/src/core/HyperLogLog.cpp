@@ -0,0 +1,85 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/HyperLogLog.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "loopp/core/Hash.hpp"
+
+using namespace loopp;
+using namespace loopp::core;
+
+HyperLogLog::HyperLogLog(unsigned precision)
+  : precision(precision)
+{
+  if (precision < 4 || precision > 16)
+    {
+      throw std::runtime_error("invalid HyperLogLog precision");
+    }
+  registers.resize(1u << precision);
+}
+
+void
+HyperLogLog::add(std::uint64_t key)
+{
+  std::uint64_t h = mix64(key);
+  std::size_t index = static_cast<std::size_t>(h >> (64 - precision));
+  std::uint64_t rest = (h << precision) | (1ull << (precision - 1));
+  std::uint8_t rank = static_cast<std::uint8_t>(__builtin_clzll(rest) + 1);
+  registers[index] = std::max(registers[index], rank);
+}
+
+void
+HyperLogLog::clear()
+{
+  std::fill(registers.begin(), registers.end(), 0);
+}
+
+std::uint64_t
+HyperLogLog::estimate() const
+{
+  double m = static_cast<double>(registers.size());
+  double sum = 0.0;
+  std::size_t zeros = 0;
+  for (std::uint8_t r : registers)
+    {
+      sum += std::ldexp(1.0, -r);
+      zeros += r == 0 ? 1 : 0;
+    }
+
+  double alpha = 0.7213 / (1.0 + 1.079 / m);
+  double e = alpha * m * m / sum;
+
+  // Linear counting is more accurate for small cardinalities.
+  if (e <= 2.5 * m && zeros > 0)
+    {
+      e = m * std::log(m / static_cast<double>(zeros));
+    }
+  return static_cast<std::uint64_t>(std::llround(e));
+}
+
+std::size_t
+HyperLogLog::memory_size() const
+{
+  return registers.size();
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace loopp;
+using namespace loopp::core;
+
+constexpr std::size_t LatencyHistogram::linear_buckets;
+constexpr std::size_t LatencyHistogram::bucket_count;
+
+std::size_t
+LatencyHistogram::bucket_index(std::uint64_t value)
+{
+  if (value < linear_buckets)
+    {
+      return static_cast<std::size_t>(value);
+    }
+
+  int msb = 63 - __builtin_clzll(value);
+  std::size_t sub = static_cast<std::size_t>((value >> (msb - 2)) & 3);
+  return std::min(linear_buckets + (msb - 4) * 4 + sub, bucket_count - 1);
+}
+
+std::uint64_t
+LatencyHistogram::bucket_upper_bound(std::size_t index)
+{
+  if (index < linear_buckets)
+    {
+      return index;
+    }
+
+  std::size_t msb = (index - linear_buckets) / 4 + 4;
+  std::uint64_t sub = (index - linear_buckets) % 4;
+  return ((4 + sub + 1) << (msb - 2)) - 1;
+}
+
+void
+LatencyHistogram::add(std::int64_t latency_us)
+{
+  latency_us = std::max<std::int64_t>(latency_us, 0);
+  buckets[bucket_index(static_cast<std::uint64_t>(latency_us))]++;
+  count++;
+  sum += latency_us;
+  max = std::max(max, latency_us);
+}
+
+void
+LatencyHistogram::reset()
+{
+  buckets.fill(0);
+  count = 0;
+  max = 0;
+  sum = 0;
+}
+
+std::uint32_t
+LatencyHistogram::get_count() const
+{
+  return count;
+}
+
+std::int64_t
+LatencyHistogram::get_max() const
+{
+  return max;
+}
+
+std::int64_t
+LatencyHistogram::get_mean() const
+{
+  return count > 0 ? sum / count : 0;
+}
+
+std::int64_t
+LatencyHistogram::get_percentile(double percentile) const
+{
+  if (count == 0)
+    {
+      return 0;
+    }
+
+  std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * count));
+  rank = std::max<std::uint64_t>(rank, 1);
+
+  std::uint64_t seen = 0;
+  for (std::size_t i = 0; i < bucket_count; i++)
+    {
+      seen += buckets[i];
+      if (seen >= rank)
+        {
+          return std::min<std::int64_t>(static_cast<std::int64_t>(bucket_upper_bound(i)), max);
+        }
+    }
+  return max;
+}
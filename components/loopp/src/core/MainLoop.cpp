@@ -37,11 +37,6 @@ static const char *tag = "MAINLOOP";
 using namespace loopp;
 using namespace loopp::core;
 
-MainLoop::~MainLoop()
-{
-  get_thread_local().remove();
-}
-
 void
 MainLoop::invoke_func(const std::function<void()> &func)
 {
@@ -314,7 +309,18 @@ MainLoop::run()
   get_thread_local().set(shared_from_this());
   task_handle = Task::get_handle_of_current_task();
 
-  while (true)
+  // The registration holds a reference to the loop. Drop it when the loop
+  // returns, instead of leaving it to the destruction of the thread local
+  // at exit.
+  struct Unregister
+  {
+    ~Unregister()
+    {
+      get_thread_local().remove();
+    }
+  } unregister;
+
+  while (!terminate_loop)
     {
       poll_list_type poll_list_copy = get_poll_list();
 
@@ -0,0 +1,343 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/core/RadioCoordinator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "esp_log.h"
+
+#include "loopp/core/ScopedLock.hpp"
+
+using namespace loopp;
+using namespace loopp::core;
+
+static const char *tag = "RADIO";
+
+RadioCoordinator::Lease::Lease(RadioCoordinator *coordinator, int id)
+  : coordinator(coordinator)
+  , id(id)
+{
+}
+
+RadioCoordinator::Lease::~Lease()
+{
+  release();
+}
+
+RadioCoordinator::Lease::Lease(Lease &&other)
+  : coordinator(other.coordinator)
+  , id(other.id)
+{
+  other.coordinator = nullptr;
+  other.id = 0;
+}
+
+RadioCoordinator::Lease &
+RadioCoordinator::Lease::operator=(Lease &&other)
+{
+  if (this != &other)
+    {
+      release();
+      coordinator = other.coordinator;
+      id = other.id;
+      other.coordinator = nullptr;
+      other.id = 0;
+    }
+  return *this;
+}
+
+void
+RadioCoordinator::Lease::release()
+{
+  if (coordinator != nullptr)
+    {
+      coordinator->release(id);
+      coordinator = nullptr;
+      id = 0;
+    }
+}
+
+RadioCoordinator::RadioCoordinator()
+{
+  esp_timer_create_args_t args;
+  args.callback = &RadioCoordinator::on_timer;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "radio";
+  esp_timer_create(&args, &timer);
+}
+
+RadioCoordinator::~RadioCoordinator()
+{
+  if (timer != nullptr)
+    {
+      esp_timer_stop(timer);
+      esp_timer_delete(timer);
+    }
+}
+
+RadioCoordinator &
+RadioCoordinator::instance()
+{
+  static RadioCoordinator instance;
+  return instance;
+}
+
+void
+RadioCoordinator::configure(bool enabled, std::chrono::milliseconds max_pause, std::chrono::seconds budget_window)
+{
+  {
+    ScopedLock l(mutex);
+    this->enabled = enabled;
+    max_pause_us = std::chrono::duration_cast<std::chrono::microseconds>(max_pause).count();
+    budget_window_us = std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(budget_window).count(), 1);
+    budget_us = std::min(budget_us, max_pause_us);
+    if (!enabled)
+      {
+        leases.clear();
+      }
+  }
+  update(esp_timer_get_time());
+}
+
+const char *
+RadioCoordinator::mode_name(Mode mode)
+{
+  switch (mode)
+    {
+    case Mode::Normal:
+      return "normal";
+    case Mode::Reduced:
+      return "reduced";
+    case Mode::Paused:
+      return "paused";
+    }
+  return "unknown";
+}
+
+RadioCoordinator::Lease
+RadioCoordinator::request(Mode mode, std::chrono::milliseconds max_duration, const char *reason)
+{
+  int64_t now = esp_timer_get_time();
+  int id = 0;
+  {
+    ScopedLock l(mutex);
+    if (!enabled || mode == Mode::Normal)
+      {
+        return Lease();
+      }
+
+    account(now);
+    id = next_id++;
+    leases.push_back(Entry{ id, mode, now + std::chrono::duration_cast<std::chrono::microseconds>(max_duration).count(), reason });
+    stats.requests++;
+    if (mode == Mode::Paused && !can_pause())
+      {
+        stats.downgraded++;
+      }
+  }
+
+  ESP_LOGD(tag, "%s requests %s for at most %d ms", reason, mode_name(mode), static_cast<int>(max_duration.count()));
+  update(now);
+  return Lease(this, id);
+}
+
+void
+RadioCoordinator::release(int id)
+{
+  {
+    ScopedLock l(mutex);
+    account(esp_timer_get_time());
+    leases.erase(std::remove_if(leases.begin(), leases.end(), [id](const Entry &e) { return e.id == id; }), leases.end());
+  }
+  update(esp_timer_get_time());
+}
+
+RadioCoordinator::Mode
+RadioCoordinator::get_mode() const
+{
+  ScopedLock l(mutex);
+  return mode;
+}
+
+RadioCoordinator::Stats
+RadioCoordinator::take_stats()
+{
+  ScopedLock l(mutex);
+  account(esp_timer_get_time());
+  Stats result = stats;
+  stats = Stats();
+  return result;
+}
+
+loopp::core::Signal<void(RadioCoordinator::Mode)> &
+RadioCoordinator::mode_signal()
+{
+  return signal_mode;
+}
+
+void
+RadioCoordinator::account(int64_t now)
+{
+  if (last_update == 0 || now <= last_update)
+    {
+      last_update = std::max(last_update, now);
+      return;
+    }
+
+  int64_t elapsed = now - last_update;
+  last_update = now;
+
+  // Refill at max_pause per budget window, and drain in real time while
+  // paused. Once the budget runs out the pause continues as reduced.
+  int64_t paused = 0;
+  if (mode == Mode::Paused)
+    {
+      paused = std::min(elapsed, pause_remaining());
+      stats.paused_us += paused;
+      stats.reduced_us += elapsed - paused;
+    }
+  else if (mode == Mode::Reduced)
+    {
+      stats.reduced_us += elapsed;
+    }
+
+  budget_us = std::min(budget_us - paused + elapsed * max_pause_us / budget_window_us, max_pause_us);
+
+  // A spent budget must recover to a tenth before scanning pauses again, so
+  // that a long request does not toggle the scanner on every refill.
+  if (paused < elapsed && mode == Mode::Paused)
+    {
+      recovering = true;
+    }
+  if (recovering && budget_us >= max_pause_us / 10)
+    {
+      recovering = false;
+    }
+}
+
+bool
+RadioCoordinator::can_pause() const
+{
+  return !recovering && budget_us > 0;
+}
+
+int64_t
+RadioCoordinator::pause_remaining() const
+{
+  int64_t drain = budget_window_us - max_pause_us;
+  if (drain <= 0)
+    {
+      // Refills at least as fast as it drains.
+      return INT64_MAX / 2;
+    }
+  return std::max<int64_t>(budget_us, 0) * budget_window_us / drain;
+}
+
+RadioCoordinator::Mode
+RadioCoordinator::evaluate() const
+{
+  Mode result = Mode::Normal;
+  for (const auto &e : leases)
+    {
+      if (e.mode == Mode::Paused && can_pause())
+        {
+          return Mode::Paused;
+        }
+      result = Mode::Reduced;
+    }
+  return result;
+}
+
+int64_t
+RadioCoordinator::next_deadline(int64_t now) const
+{
+  int64_t deadline = 0;
+  for (const auto &e : leases)
+    {
+      if (deadline == 0 || e.expires < deadline)
+        {
+          deadline = e.expires;
+        }
+    }
+
+  if (mode == Mode::Paused)
+    {
+      int64_t exhausted = now + pause_remaining();
+      if (deadline == 0 || exhausted < deadline)
+        {
+          deadline = exhausted;
+        }
+    }
+  return deadline;
+}
+
+void
+RadioCoordinator::schedule(int64_t now)
+{
+  if (timer == nullptr)
+    {
+      return;
+    }
+
+  esp_timer_stop(timer);
+  int64_t deadline = next_deadline(now);
+  if (deadline != 0)
+    {
+      esp_timer_start_once(timer, static_cast<uint64_t>(std::max<int64_t>(deadline - now, 1000)));
+    }
+}
+
+void
+RadioCoordinator::on_timer(void *arg)
+{
+  static_cast<RadioCoordinator *>(arg)->update(esp_timer_get_time());
+}
+
+void
+RadioCoordinator::update(int64_t now)
+{
+  Mode previous;
+  Mode current;
+  {
+    ScopedLock l(mutex);
+    account(now);
+
+    auto expired = std::remove_if(leases.begin(), leases.end(), [now](const Entry &e) { return e.expires <= now; });
+    for (auto it = expired; it != leases.end(); ++it)
+      {
+        ESP_LOGW(tag, "%s did not release the radio in time", it->reason);
+      }
+    leases.erase(expired, leases.end());
+
+    previous = mode;
+    mode = evaluate();
+    current = mode;
+    schedule(now);
+  }
+
+  if (current != previous)
+    {
+      ESP_LOGI(tag, "Radio mode %s", mode_name(current));
+      signal_mode(current);
+    }
+}
@@ -30,7 +30,7 @@ Task::Task(const std::string &name, std::function<void()> func, CoreId core_id,
   , func(std::move(func))
 {
   BaseType_t rc = pdPASS;
-  if (core_id != CoreId::NoAffinity)
+  if (core_id == CoreId::NoAffinity)
     {
       rc = xTaskCreate(&Task::run, name.c_str(), stack_size, this, priority, &task_handle);
     }
@@ -47,12 +47,21 @@ Task::Task(const std::string &name, std::function<void()> func, CoreId core_id,
 
 Task::~Task()
 {
-  vTaskDelete(task_handle);
+  if (task_handle != nullptr)
+    {
+      vTaskDelete(task_handle);
+    }
 }
 
 void
 Task::run(void *self)
 {
   static_cast<Task *>(self)->func();
-  vTaskDelete(nullptr);
+  // Only the destructor deletes the task, and task_handle is only written
+  // before the task starts, so the two never race. A finished task waits
+  // here until its Task is destroyed.
+  for (;;)
+    {
+      vTaskSuspend(nullptr);
+    }
 }
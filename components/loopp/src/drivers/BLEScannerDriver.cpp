@@ -23,14 +23,30 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 
-#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/ble/HciReader.hpp"
+#include "loopp/ble/ScanFilter.hpp"
+#include "loopp/ble/TraceReader.hpp"
+#include "loopp/core/BootTimeline.hpp"
+#include "loopp/core/Hash.hpp"
+#include "loopp/core/RadioCoordinator.hpp"
 #include "loopp/drivers/DriverRegistry.hpp"
 #include "loopp/utils/memlog.hpp"
 
+#include "BeaconStage.hpp"
+#include "PresenceStage.hpp"
+#include "PriorityStage.hpp"
+#include "ScanContext.hpp"
+#include "ScanStage.hpp"
+#include "SketchStage.hpp"
+
 using namespace loopp::drivers;
 
 // LOOPP_REGISTER_DRIVER("ble-scanner", BLEScannerDriver);
@@ -40,11 +56,11 @@ using json = nlohmann::json;
 static const char *tag = "BLE-SCANNER";
 
 BLEScannerDriver::BLEScannerDriver(loopp::drivers::DriverContext context, const nlohmann::json &config)
-  : loop(context.get_loop())
-  , mqtt(context.get_mqtt())
+  : context(std::make_shared<ScanContext>(context, config))
+  , loop(context.get_loop())
   , ble_scanner(loopp::ble::BLEScanner::instance())
 {
-  topic_scan = context.get_topic_root() + "scan";
+  scan_publisher = std::make_shared<loopp::mqtt::MqttBatchPublisher>(loop, context.get_mqtt(), this->context->get_topic("scan"));
 
   auto it = config.find("feedback_pin");
   if (it != config.end())
@@ -56,7 +72,71 @@ BLEScannerDriver::BLEScannerDriver(loopp::drivers::DriverContext context, const
       gpio_set_direction(pin_no, GPIO_MODE_OUTPUT);
     }
 
-  it = config.find("scan_type");
+  configure_scanner(config);
+  configure_publisher(config);
+  configure_stages(config);
+
+  it = config.find("record");
+  if (it != config.end())
+    {
+      trace_recorder = std::make_unique<loopp::ble::TraceRecorder>(it->get<std::string>());
+    }
+
+  it = config.find("replay");
+  if (it != config.end())
+    {
+      configure_replay(*it);
+    }
+
+  it = config.find("load");
+  if (it != config.end())
+    {
+      load_generator = std::make_unique<loopp::ble::LoadGenerator>(*it);
+      ESP_LOGI(tag, "Generating load of %d virtual devices, %d adv/s", static_cast<int>(load_generator->get_device_count()),
+               static_cast<int>(load_generator->get_nominal_rate()));
+    }
+
+  it = config.find("adaptive");
+  if (it != config.end())
+    {
+      adaptive = std::make_unique<loopp::ble::AdaptiveScanController>(*it);
+      adaptive_interval = std::chrono::seconds(it->value("control_interval", 5));
+      const auto &decision = adaptive->get_decision();
+      ble_scanner.set_scan_interval(decision.scan_interval);
+      ble_scanner.set_scan_window(decision.scan_window);
+      publish_period = std::chrono::milliseconds(decision.publish_period);
+    }
+
+  it = config.find("pipeline");
+  if (it != config.end())
+    {
+      configure_pipeline(*it);
+    }
+
+  it = config.find("radio");
+  if (it != config.end())
+    {
+      radio_stats = it->value("enabled", true);
+      loopp::core::RadioCoordinator::instance().configure(radio_stats,
+                                                          std::chrono::milliseconds(it->value("max_pause_ms", 5000)),
+                                                          std::chrono::seconds(it->value("budget_window_s", 60)));
+    }
+
+  it = config.find("stats_interval");
+  if (it != config.end())
+    {
+      stats_interval = std::chrono::seconds(it->get<int>());
+    }
+}
+
+BLEScannerDriver::~BLEScannerDriver()
+{
+}
+
+void
+BLEScannerDriver::configure_scanner(const nlohmann::json &config)
+{
+  auto it = config.find("scan_type");
   if (it != config.end())
     {
       std::string type = *it;
@@ -88,38 +168,172 @@ BLEScannerDriver::BLEScannerDriver(loopp::drivers::DriverContext context, const
       uint16_t window = *it;
       ble_scanner.set_scan_window(window);
     }
+
+  it = config.find("scan_duration");
+  if (it != config.end())
+    {
+      uint32_t duration = *it;
+      ble_scanner.set_scan_duration(duration);
+    }
+
+  // Always replace the filter, so that reprovisioning without a
+  // scan_filter removes the one installed by the previous configuration.
+  std::shared_ptr<const loopp::ble::ScanFilter> scan_filter;
+  it = config.find("scan_filter");
+  if (it != config.end())
+    {
+      scan_filter = std::make_shared<const loopp::ble::ScanFilter>(*it);
+    }
+  ble_scanner.set_scan_filter(scan_filter);
 }
 
-BLEScannerDriver::~BLEScannerDriver()
+void
+BLEScannerDriver::configure_publisher(const nlohmann::json &config)
 {
+  auto it = config.find("max_packet_size");
+  if (it != config.end())
+    {
+      std::size_t size = *it;
+      scan_publisher->set_max_packet_size(size);
+    }
+
+  it = config.find("qos");
+  if (it != config.end())
+    {
+      int qos = *it;
+      switch (qos)
+        {
+        case 0:
+          scan_publisher->set_publish_options(loopp::mqtt::PublishOptions::None);
+          break;
+        case 1:
+          scan_publisher->set_publish_options(loopp::mqtt::PublishOptions::Qos1);
+          break;
+        case 2:
+          scan_publisher->set_publish_options(loopp::mqtt::PublishOptions::Qos2);
+          break;
+        default:
+          throw std::runtime_error("invalid qos value: " + std::to_string(qos));
+        }
+    }
 }
 
-// https://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
-std::string
-BLEScannerDriver::base64_encode(const std::string &in)
+void
+BLEScannerDriver::configure_stages(const nlohmann::json &config)
 {
-  std::string out;
+  // Priority advertisements are published before any other stage can
+  // delay them.
+  auto it = config.find("priority");
+  if (it != config.end())
+    {
+      priority = std::make_shared<PriorityStage>(context, *it);
+      stages.push_back(priority);
+    }
+
+  it = config.find("presence");
+  bool presence = it != config.end();
+  if (presence)
+    {
+      stages.push_back(std::make_shared<PresenceStage>(context, *it));
+    }
 
-  int val = 0, valb = -6;
-  for (char c : in)
+  it = config.find("sketch");
+  if (it != config.end())
     {
-      val = (val << 8) + c;
-      valb += 8;
-      while (valb >= 0)
+      stages.push_back(std::make_shared<SketchStage>(context, *it));
+    }
+
+  auto filter = config.find("rssi_filter");
+  auto zones = config.find("proximity");
+  bool filtered = filter != config.end() || zones != config.end();
+  if (filtered)
+    {
+      // Zones need the smoothed RSSI of each beacon.
+      auto beacons = std::make_shared<BeaconStage>(context, filter != config.end() ? *filter : json::object());
+      if (zones != config.end())
         {
-          out.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(val >> valb) & 0x3F]);
-          valb -= 6;
+          beacons->set_proximity(*zones);
         }
+      stages.push_back(beacons);
     }
-  if (valb > -6)
+
+  // Filtered and presence output replace the raw records, unless both are
+  // explicitly requested.
+  publish_raw = config.value("raw", !filtered && !presence);
+}
+
+void
+BLEScannerDriver::configure_pipeline(const nlohmann::json &config)
+{
+  // Opt-in: the hand-off only pays off when the main loop is saturated and
+  // the decode task has a core of its own.
+  if (!config.value("enabled", false))
     {
-      out.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[((val << 8) >> (valb + 8)) & 0x3F]);
+      return;
     }
-  while ((out.size() % 4) != 0u)
+
+  // The pipeline only produces raw records.
+  if (!publish_raw)
     {
-      out.push_back('=');
+      ESP_LOGW(tag, "Pipeline disabled, raw records are not published");
+      return;
     }
-  return out;
+
+  int core = config.value("core", 1);
+  switch (core)
+    {
+    case 0:
+      pipeline_core = loopp::core::Task::CoreId::CPU0;
+      break;
+    case 1:
+      pipeline_core = loopp::core::Task::CoreId::CPU1;
+      break;
+    case -1:
+      pipeline_core = loopp::core::Task::CoreId::NoAffinity;
+      break;
+    default:
+      throw std::runtime_error("invalid pipeline core: " + std::to_string(core));
+    }
+
+  // Runs on the decode task. The scan context does not change after
+  // construction.
+  std::shared_ptr<const ScanContext> c = context;
+  pipeline = std::make_shared<loopp::ble::ScanPipeline>(config.value("capacity", 256),
+                                                        [c](const loopp::ble::BLEScanner::ScanResult &result, std::string &record) {
+                                                          record = c->encode_scan_result(result.bda, result.rssi, result.adv_data).dump();
+                                                          return true;
+                                                        });
+}
+
+bool
+BLEScannerDriver::needs_loop_stage() const
+{
+  return !pipeline || !publish_raw || !stages.empty() || adaptive || trace_recorder || feedback;
+}
+
+void
+BLEScannerDriver::configure_replay(const nlohmann::json &config)
+{
+  std::string file = config.at("file").get<std::string>();
+  std::string format = config.value("format", "trace");
+
+  std::shared_ptr<loopp::ble::ScanSource> reader;
+  if (format == "trace")
+    {
+      reader = std::make_shared<loopp::ble::TraceReader>(file);
+    }
+  else if (format == "hci")
+    {
+      reader = std::make_shared<loopp::ble::HciReader>(file);
+    }
+  else
+    {
+      throw std::runtime_error("invalid replay format: " + format);
+    }
+
+  trace_replay = std::make_shared<loopp::ble::TraceReplay>(loop, reader, ble_scanner.scan_result_signal());
+  trace_replay->set_speed(config.value("speed", 1.0));
+  trace_replay->set_repeat(config.value("repeat", false));
 }
 
 void
@@ -131,7 +345,58 @@ BLEScannerDriver::on_ble_scanner_scan_result(const loopp::ble::BLEScanner::ScanR
       led_state ^= 1;
       gpio_set_level(pin_no, led_state);
     }
-  scan_results.push_back(result);
+
+  received_count++;
+
+  if (adaptive)
+    {
+      adaptive_count++;
+      adaptive_devices.add(loopp::core::hash_bytes(result.bda, sizeof(result.bda)));
+    }
+
+  if (trace_recorder)
+    {
+      try
+        {
+          trace_recorder->record(result);
+        }
+      catch (std::exception &e)
+        {
+          ESP_LOGE(tag, "Failed to record scan result, recording stopped: %s", e.what());
+          trace_recorder.reset();
+        }
+    }
+
+  bool batched = publish_raw && !pipeline;
+  for (auto &stage : stages)
+    {
+      ScanStage::Disposition disposition = stage->process(result);
+      if (disposition == ScanStage::Disposition::Consumed)
+        {
+          return;
+        }
+      if (disposition == ScanStage::Disposition::NotBatched)
+        {
+          batched = false;
+        }
+    }
+
+  if (batched)
+    {
+      scan_results.push_back(result);
+    }
+}
+
+void
+BLEScannerDriver::add_pipeline_records(loopp::ble::ScanBatch &batch)
+{
+  assert(publish_raw && "Raw records while raw output is disabled");
+  pipeline->drain(pipeline_records);
+  for (auto &r : pipeline_records)
+    {
+      batch.add(std::move(r.data), r.timestamp);
+    }
+  pipeline_records.clear();
 }
 
 void
@@ -140,22 +405,55 @@ BLEScannerDriver::on_scan_timer()
   loopp::utils::memlog("BLEScannerDriver::on_scan_timer entry");
   try
     {
-      json j;
-      if (mqtt && mqtt->connected().get() && scan_results.size() > 0)
+      if (context->is_connected() && (scan_results.size() > 0 || !stages.empty() || pipeline))
         {
-          for (auto r : scan_results)
+          loopp::ble::ScanBatch batch;
+          batch.reserve(scan_results.size());
+
+          for (auto &stage : stages)
             {
-              json jb;
-              jb["mac"] = r.bda_as_string();
-              jb["bda"] = base64_encode(std::string(reinterpret_cast<char *>(r.bda), sizeof(r.bda)));
-              jb["rssi"] = r.rssi;
-              jb["adv_data"] = base64_encode(r.adv_data);
-
-              decoder.decode(r.adv_data, jb);
-              j.push_back(jb);
+              stage->add_records(batch);
             }
 
-          mqtt->publish(topic_scan, j.dump());
+          if (pipeline)
+            {
+              add_pipeline_records(batch);
+            }
+
+          for (auto &r : scan_results)
+            {
+              try
+                {
+                  batch.add(context->encode_scan_result(r.bda, r.rssi, r.adv_data).dump(), r.timestamp);
+                }
+              catch (std::exception &e)
+                {
+                  ESP_LOGE(tag, "on_scan_timer. Failed to encode scan result: %s", e.what());
+                }
+            }
+
+          if (!batch.empty())
+            {
+              // Records carry their receive time as an offset in
+              // microseconds from base_time. base_wall maps base_time to
+              // the (synchronized) wall clock in microseconds since the epoch.
+              json header;
+              header["base_time"] = batch.get_base_time();
+              header["base_wall"] = context->to_wall_clock(batch.get_base_time());
+              auto self = shared_from_this();
+              std::vector<int64_t> timestamps = batch.get_timestamps();
+              scan_publisher->publish(batch.take_records(), std::move(header), [this, self, timestamps](std::error_code ec) {
+                if (!ec)
+                  {
+                    loopp::core::BootTimeline::instance().mark("scan_published");
+                    int64_t now = esp_timer_get_time();
+                    for (int64_t timestamp : timestamps)
+                      {
+                        batch_latency.add(now - timestamp);
+                      }
+                  }
+              });
+            }
         }
     }
   catch (std::exception &e)
@@ -163,16 +461,224 @@ BLEScannerDriver::on_scan_timer()
       ESP_LOGE(tag, "on_scan_timer. Exception: %s", e.what());
     }
   scan_results.clear();
+  // Drop whatever could not be published.
+  pipeline_records.clear();
+
+  if (trace_recorder)
+    {
+      trace_recorder->flush();
+    }
+}
+
+void
+BLEScannerDriver::on_stats_timer()
+{
+  try
+    {
+      if (context->is_connected())
+        {
+          loopp::ble::BLEScanner::FilterStats filter_stats = ble_scanner.get_filter_stats();
+          loopp::ble::ScanCoverage::Report coverage = ble_scanner.get_scan_coverage();
+
+          int64_t now = esp_timer_get_time();
+          float elapsed = static_cast<float>(now - stats_start) / 1e6f;
+
+          json stats;
+          stats["received"]["count"] = received_count;
+          stats["received"]["rate"] = elapsed > 0.0f ? std::round(static_cast<float>(received_count) / elapsed * 10.0f) / 10.0f : 0.0f;
+          stats["latency_us"]["batch"] = ScanContext::latency_stats(batch_latency);
+          stats["heap"]["free"] = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+          stats["heap"]["min_free"] = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+          for (auto &stage : stages)
+            {
+              stage->add_stats(stats);
+            }
+          if (adaptive)
+            {
+              const auto &decision = adaptive->get_decision();
+              stats["adaptive"]["state"] = loopp::ble::AdaptiveScanController::state_name(adaptive->get_state());
+              stats["adaptive"]["duty_cycle"] = std::round(adaptive->get_duty_cycle() * 100.0f) / 100.0f;
+              stats["adaptive"]["scan_interval"] = decision.scan_interval;
+              stats["adaptive"]["scan_window"] = decision.scan_window;
+              stats["adaptive"]["publish_period"] = decision.publish_period;
+              stats["adaptive"]["ambient_rate"] = std::round(adaptive->get_ambient_rate() * 10.0f) / 10.0f;
+              stats["adaptive"]["send_backlog"] = context->get_mqtt()->get_send_backlog();
+            }
+          if (pipeline)
+            {
+              loopp::ble::ScanPipeline::Stats pipeline_stats = pipeline->take_stats();
+              for (const auto &stage : { std::make_pair("capture", pipeline_stats.capture), std::make_pair("decode", pipeline_stats.decode) })
+                {
+                  json &js = stats["pipeline"][stage.first];
+                  js["processed"] = stage.second.processed;
+                  js["dropped"] = stage.second.dropped;
+                  js["depth"] = stage.second.depth;
+                  js["max_depth"] = stage.second.max_depth;
+                }
+              stats["pipeline"]["publish"]["processed"] = pipeline_stats.published;
+              if (!needs_loop_stage())
+                {
+                  // Nothing passes through the main loop.
+                  stats["received"]["count"] = pipeline_stats.capture.processed + pipeline_stats.capture.dropped;
+                  stats["received"]["rate"] = elapsed > 0.0f ? std::round(stats["received"]["count"].get<float>() / elapsed * 10.0f) / 10.0f : 0.0f;
+                }
+            }
+          stats["filter"]["accepted"] = filter_stats.accepted;
+          stats["filter"]["rejected"] = filter_stats.rejected;
+          stats["scan"]["duty_cycle"] = std::round(coverage.duty_cycle * 100.0f) / 100.0f;
+          stats["scan"]["restarts"] = coverage.restarts;
+          stats["scan"]["last_gap_us"] = coverage.last_gap_us;
+          stats["scan"]["max_gap_us"] = coverage.max_gap_us;
+          if (radio_stats)
+            {
+              loopp::core::RadioCoordinator &radio = loopp::core::RadioCoordinator::instance();
+              loopp::core::RadioCoordinator::Stats rs = radio.take_stats();
+              stats["radio"]["mode"] = loopp::core::RadioCoordinator::mode_name(radio.get_mode());
+              stats["radio"]["paused_ms"] = rs.paused_us / 1000;
+              stats["radio"]["reduced_ms"] = rs.reduced_us / 1000;
+              stats["radio"]["requests"] = rs.requests;
+              stats["radio"]["downgraded"] = rs.downgraded;
+            }
+          std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync = context->get_time_sync();
+          if (time_sync && time_sync->is_synchronized())
+            {
+              const loopp::core::ClockSync &clock = time_sync->get_clock();
+              stats["clock"]["drift_ppm"] = std::round(clock.get_drift_ppm() * 100.0) / 100.0;
+              stats["clock"]["delay_us"] = clock.get_delay();
+            }
+          context->get_mqtt()->publish(context->get_topic("scan/stats"), stats.dump());
+        }
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "on_stats_timer. Exception: %s", e.what());
+    }
+
+  received_count = 0;
+  stats_start = esp_timer_get_time();
+  batch_latency.reset();
+}
+
+void
+BLEScannerDriver::on_adaptive_timer()
+{
+  int64_t now = esp_timer_get_time();
+  float elapsed = static_cast<float>(now - adaptive_start) / 1e6f;
+
+  loopp::ble::AdaptiveScanController::Observation observation;
+  observation.adv_rate = elapsed > 0.0f ? static_cast<float>(adaptive_count) / elapsed : 0.0f;
+  if (adaptive_count > 0)
+    {
+      float unique = std::min(static_cast<float>(adaptive_devices.estimate()), static_cast<float>(adaptive_count));
+      observation.duplicate_ratio = 1.0f - unique / static_cast<float>(adaptive_count);
+    }
+  observation.queue_depth = scan_results.size();
+  std::shared_ptr<loopp::mqtt::MqttClient> mqtt = context->get_mqtt();
+  observation.send_backlog = mqtt ? mqtt->get_send_backlog() : 0;
+
+  const auto &decision = adaptive->get_decision();
+  if (adaptive->update(observation))
+    {
+      ESP_LOGI(tag, "Adaptive scan (%s): interval %d window %d", loopp::ble::AdaptiveScanController::state_name(adaptive->get_state()),
+               decision.scan_interval, decision.scan_window);
+      ble_scanner.update_scan_params(decision.scan_interval, decision.scan_window);
+    }
+
+  std::chrono::milliseconds period(decision.publish_period);
+  if (period != publish_period)
+    {
+      publish_period = period;
+      start_scan_timer();
+    }
+
+  adaptive_count = 0;
+  adaptive_devices.clear();
+  adaptive_start = now;
+}
+
+void
+BLEScannerDriver::start_scan_timer()
+{
+  if (scan_timer != 0)
+    {
+      loop->cancel_timer(scan_timer);
+    }
+  auto self = shared_from_this();
+  scan_timer = loop->add_periodic_timer(publish_period, [this, self]() { on_scan_timer(); });
+}
+
+void
+BLEScannerDriver::on_load_timer()
+{
+  int64_t now = esp_timer_get_time();
+  loopp::ble::BLEScanner::ScanResult result;
+  while (load_generator->next_time() <= now)
+    {
+      load_generator->next(result);
+      ble_scanner.scan_result_signal()(result);
+    }
 }
 
 void
 BLEScannerDriver::start()
 {
   auto self = shared_from_this();
-  scan_result_signal_connection = ble_scanner.scan_result_signal().connect(
-    loopp::core::bind_loop(loop, [this, self](loopp::ble::BLEScanner::ScanResult scan_result) { on_ble_scanner_scan_result(scan_result); }));
-  scan_timer = loop->add_periodic_timer(std::chrono::milliseconds(1000), [this, self]() { on_scan_timer(); });
-  ble_scanner.start();
+  if (pipeline)
+    {
+      // Capture directly on the Bluetooth task, without going through the
+      // main loop.
+      pipeline->start(pipeline_core);
+      // The priority rules do not change after construction, so they can be
+      // evaluated on the Bluetooth task.
+      std::shared_ptr<loopp::ble::ScanPipeline> p = pipeline;
+      std::shared_ptr<const PriorityStage> ps = priority;
+      pipeline_signal_connection = ble_scanner.scan_result_signal().connect([p, ps](const loopp::ble::BLEScanner::ScanResult &scan_result) {
+        if (!ps || !ps->matches(scan_result))
+          {
+            p->capture(scan_result);
+          }
+      });
+      // Empty the record ring well before it fills; batches are only
+      // published once per publish period.
+      pipeline_timer = loop->add_periodic_timer(std::chrono::milliseconds(20), [this, self]() { pipeline->drain(pipeline_records); });
+    }
+  if (needs_loop_stage())
+    {
+      scan_result_signal_connection = ble_scanner.scan_result_signal().connect(
+        loopp::core::bind_loop(loop, [this, self](loopp::ble::BLEScanner::ScanResult scan_result) { on_ble_scanner_scan_result(scan_result); }));
+    }
+  start_scan_timer();
+  if (stats_interval.count() > 0)
+    {
+      stats_timer = loop->add_periodic_timer(stats_interval, [this, self]() { on_stats_timer(); });
+    }
+  for (auto &stage : stages)
+    {
+      stage->start();
+    }
+  if (adaptive)
+    {
+      adaptive_count = 0;
+      adaptive_devices.clear();
+      adaptive_start = esp_timer_get_time();
+      adaptive_timer = loop->add_periodic_timer(adaptive_interval, [this, self]() { on_adaptive_timer(); });
+    }
+
+  stats_start = esp_timer_get_time();
+  if (trace_replay)
+    {
+      // Replay instead of scanning, so the trace is the only source.
+      trace_replay->start();
+    }
+  else if (load_generator)
+    {
+      load_generator->start(esp_timer_get_time());
+      load_timer = loop->add_periodic_timer(std::chrono::milliseconds(10), [this, self]() { on_load_timer(); });
+    }
+  else
+    {
+      ble_scanner.start();
+    }
 }
 
 void
@@ -180,6 +686,39 @@ BLEScannerDriver::stop()
 {
   loop->cancel_timer(scan_timer);
   scan_timer = 0;
-  ble_scanner.stop();
+  if (stats_timer != 0)
+    {
+      loop->cancel_timer(stats_timer);
+      stats_timer = 0;
+    }
+  for (auto &stage : stages)
+    {
+      stage->stop();
+    }
+  if (adaptive_timer != 0)
+    {
+      loop->cancel_timer(adaptive_timer);
+      adaptive_timer = 0;
+    }
+  if (trace_replay)
+    {
+      trace_replay->stop();
+    }
+  else if (load_generator)
+    {
+      loop->cancel_timer(load_timer);
+      load_timer = 0;
+    }
+  else
+    {
+      ble_scanner.stop();
+    }
   scan_result_signal_connection.disconnect();
+  if (pipeline)
+    {
+      pipeline_signal_connection.disconnect();
+      pipeline->stop();
+      loop->cancel_timer(pipeline_timer);
+      pipeline_timer = 0;
+    }
 }
@@ -0,0 +1,221 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "BeaconStage.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "esp_log.h"
+
+using namespace loopp::drivers;
+
+using json = nlohmann::json;
+
+static const char *tag = "BLE-SCANNER";
+
+BeaconStage::BeaconStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config)
+  : context(std::move(context))
+  , topic_proximity(this->context->get_topic("proximity/"))
+  , rssi_filter(config)
+  , beacons(config.value("capacity", 128))
+  , max_age(config.value("max_age", 30))
+{
+  // Limit the share of rotating private addresses, so that crowds of
+  // phones do not evict stationary beacons.
+  beacons.set_private_limit(static_cast<std::size_t>(beacons.capacity() * config.value("private_share", 0.5)));
+}
+
+void
+BeaconStage::set_proximity(const nlohmann::json &config)
+{
+  proximity = std::make_unique<loopp::ble::ProximityClassifier>(config);
+}
+
+void
+BeaconStage::start()
+{
+  // Age the table on its own, so that devices also expire while nothing is
+  // published, e.g. while MQTT is disconnected.
+  std::chrono::seconds period = std::max(max_age / 2, std::chrono::seconds(1));
+  auto self = shared_from_this();
+  expire_timer = context->get_loop()->add_periodic_timer(period, [this, self]() { on_expire_timer(); });
+}
+
+void
+BeaconStage::stop()
+{
+  if (expire_timer != 0)
+    {
+      context->get_loop()->cancel_timer(expire_timer);
+      expire_timer = 0;
+    }
+}
+
+void
+BeaconStage::on_expire_timer()
+{
+  beacons.expire(std::chrono::steady_clock::now(), max_age);
+}
+
+bool
+BeaconStage::get_measured_power(const nlohmann::json &info, int8_t &power)
+{
+  auto it = info.find("ibeacon");
+  if (it != info.end())
+    {
+      power = (*it)["power"];
+      return true;
+    }
+
+  it = info.find("altbeacon");
+  if (it != info.end())
+    {
+      power = (*it)["power"];
+      return true;
+    }
+
+  it = info.find("eddystone");
+  if (it != info.end() && it->find("power") != it->end())
+    {
+      // Eddystone advertises the TX power at 0 m. Compensate for the 41 dB loss at 1 m.
+      power = static_cast<int8_t>((*it)["power"].get<int>() - 41);
+      return true;
+    }
+
+  return false;
+}
+
+ScanStage::Disposition
+BeaconStage::process(const loopp::ble::BLEScanner::ScanResult &result)
+{
+  bool created = false;
+  BeaconState *state = beacons.insert(result.bda, std::chrono::steady_clock::now(), &created, static_cast<loopp::ble::AddressType>(result.ble_addr_type));
+  if (state == nullptr)
+    {
+      return Disposition::Continue;
+    }
+
+  // The calibrated TX power only changes when the advertisement does, so
+  // avoid decoding every sample.
+  if (created || state->adv_data != result.adv_data)
+    {
+      memcpy(state->bda, result.bda, sizeof(state->bda));
+      state->adv_data = result.adv_data;
+
+      json info;
+      context->get_decoder().decode(result.adv_data, info);
+      state->has_power = get_measured_power(info, state->power);
+    }
+
+  rssi_filter.update(state->filter, result.rssi + context->get_rssi_offset());
+  state->window_samples++;
+  state->last_seen = result.timestamp;
+
+  if (proximity)
+    {
+      loopp::ble::ProximityClassifier::Zone zone = loopp::ble::ProximityClassifier::Zone::Unknown;
+      if (state->has_power)
+        {
+          zone = proximity->classify(state->zone, state->filter.estimate, state->power, state->filter.samples);
+        }
+
+      if (zone != state->zone)
+        {
+          state->zone = zone;
+          publish_proximity(*state);
+        }
+    }
+  return Disposition::Continue;
+}
+
+void
+BeaconStage::add_records(loopp::ble::ScanBatch &batch)
+{
+  beacons.for_each([this, &batch](std::uint64_t key, BeaconState &state) {
+    if (state.window_samples == 0)
+      {
+        return;
+      }
+
+    try
+      {
+        json jb = context->encode_scan_result(state.bda, static_cast<int>(std::lround(state.filter.estimate)), state.adv_data);
+        jb["rssi_filtered"] = std::round(state.filter.estimate * 10.0f) / 10.0f;
+        jb["samples"] = state.window_samples;
+        if (proximity)
+          {
+            jb["zone"] = static_cast<int>(state.zone);
+          }
+        if (state.has_power)
+          {
+            float distance = rssi_filter.estimate_distance(state.filter.estimate, state.power);
+            jb["distance"] = std::round(distance * 100.0f) / 100.0f;
+          }
+        batch.add(jb.dump(), state.last_seen);
+      }
+    catch (std::exception &e)
+      {
+        ESP_LOGE(tag, "Failed to encode filtered result: %s", e.what());
+      }
+
+    state.window_samples = 0;
+  });
+}
+
+void
+BeaconStage::add_stats(nlohmann::json &stats)
+{
+  const auto &table_stats = beacons.get_stats();
+  stats["devices"]["size"] = beacons.size();
+  stats["devices"]["private"] = beacons.private_size();
+  stats["devices"]["capacity"] = beacons.capacity();
+  stats["devices"]["inserts"] = table_stats.inserts;
+  stats["devices"]["evictions"] = table_stats.evictions;
+  stats["devices"]["private_evictions"] = table_stats.private_evictions;
+  stats["devices"]["expirations"] = table_stats.expirations;
+  beacons.reset_stats();
+}
+
+void
+BeaconStage::publish_proximity(const BeaconState &state)
+{
+  try
+    {
+      if (!context->is_connected())
+        {
+          return;
+        }
+
+      // One topic per zone, so that consumers subscribe to the zones they
+      // care about instead of evaluating every sample.
+      json jb;
+      jb["bda"] = ScanContext::base64_encode(std::string(reinterpret_cast<const char *>(state.bda), sizeof(state.bda)));
+      jb["zone"] = static_cast<int>(state.zone);
+      jb["rssi_filtered"] = std::round(state.filter.estimate * 10.0f) / 10.0f;
+      jb["time"] = context->to_wall_clock(state.last_seen);
+      context->get_mqtt()->publish(topic_proximity + loopp::ble::ProximityClassifier::zone_name(state.zone), jb.dump());
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to publish proximity change: %s", e.what());
+    }
+}
@@ -0,0 +1,89 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_BEACONSTAGE_HPP
+#define LOOPP_DRIVERS_BEACONSTAGE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "loopp/ble/DeviceTable.hpp"
+#include "loopp/ble/ProximityClassifier.hpp"
+#include "loopp/ble/RssiFilter.hpp"
+#include "loopp/core/MainLoop.hpp"
+
+#include "ScanContext.hpp"
+#include "ScanStage.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // Smooths the RSSI of every device in a table of recently seen devices
+    // and publishes one filtered record per device in each scan batch. With
+    // proximity zones configured, zone changes are also published at once on
+    // <root>/proximity/<zone>.
+    class BeaconStage
+      : public ScanStage
+      , public std::enable_shared_from_this<BeaconStage>
+    {
+    public:
+      BeaconStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config);
+
+      void set_proximity(const nlohmann::json &config);
+
+      void start() override;
+      void stop() override;
+      Disposition process(const loopp::ble::BLEScanner::ScanResult &result) override;
+      void add_records(loopp::ble::ScanBatch &batch) override;
+      void add_stats(nlohmann::json &stats) override;
+
+    private:
+      struct BeaconState
+      {
+        uint8_t bda[6];
+        loopp::ble::RssiFilter::State filter;
+        std::string adv_data;
+        int8_t power = 0;
+        bool has_power = false;
+        loopp::ble::ProximityClassifier::Zone zone = loopp::ble::ProximityClassifier::Zone::Unknown;
+        int window_samples = 0;
+        int64_t last_seen = 0;
+      };
+
+      static bool get_measured_power(const nlohmann::json &info, int8_t &power);
+      void publish_proximity(const BeaconState &state);
+      void on_expire_timer();
+
+    private:
+      std::shared_ptr<ScanContext> context;
+      std::string topic_proximity;
+      loopp::ble::RssiFilter rssi_filter;
+      loopp::ble::DeviceTable<BeaconState> beacons;
+      std::chrono::seconds max_age{ 30 };
+      loopp::core::MainLoop::timer_id expire_timer = 0;
+      std::unique_ptr<loopp::ble::ProximityClassifier> proximity;
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_BEACONSTAGE_HPP
@@ -23,10 +23,14 @@
 using namespace loopp;
 using namespace loopp::drivers;
 
-DriverContext::DriverContext(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<loopp::mqtt::MqttClient> mqtt, std::string topic_root)
+DriverContext::DriverContext(std::shared_ptr<loopp::core::MainLoop> loop,
+                             std::shared_ptr<loopp::mqtt::MqttClient> mqtt,
+                             std::string topic_root,
+                             std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync)
   : loop(loop)
   , mqtt(mqtt)
   , topic_root(topic_root)
+  , time_sync(time_sync)
 {
 }
 
@@ -48,6 +52,12 @@ DriverContext::get_topic_root() const
   return topic_root;
 }
 
+std::shared_ptr<loopp::mqtt::MqttTimeSync>
+DriverContext::get_time_sync() const
+{
+  return time_sync;
+}
+
  DriverRegistry &
 DriverRegistry::instance()
 {
@@ -0,0 +1,187 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PresenceStage.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+using namespace loopp::drivers;
+
+using json = nlohmann::json;
+
+static const char *tag = "BLE-SCANNER";
+
+PresenceStage::PresenceStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config)
+  : context(std::move(context))
+  , topic(this->context->get_topic("presence"))
+  , tracker(config)
+  , snapshot(config.value("snapshot", false))
+{
+}
+
+void
+PresenceStage::start()
+{
+  std::shared_ptr<loopp::mqtt::MqttClient> mqtt = context->get_mqtt();
+  if (snapshot && mqtt)
+    {
+      auto self = shared_from_this();
+      mqtt_connected_connection = mqtt->connected().connect(
+        loopp::core::bind_loop(context->get_loop(), [this, self](bool connected) { on_mqtt_connected(connected); }));
+    }
+}
+
+void
+PresenceStage::stop()
+{
+  mqtt_connected_connection.disconnect();
+  if (timer != 0)
+    {
+      context->get_loop()->cancel_timer(timer);
+      timer = 0;
+    }
+}
+
+ScanStage::Disposition
+PresenceStage::process(const loopp::ble::BLEScanner::ScanResult &result)
+{
+  std::vector<loopp::ble::PresenceTracker::Event> events;
+  tracker.update(result.bda, static_cast<loopp::ble::AddressType>(result.ble_addr_type), result.rssi + context->get_rssi_offset(), result.timestamp,
+                 events);
+  publish_events(events);
+  if (timer == 0)
+    {
+      schedule_timer();
+    }
+  return Disposition::Continue;
+}
+
+void
+PresenceStage::publish_events(const std::vector<loopp::ble::PresenceTracker::Event> &events)
+{
+  if (events.empty() || !context->is_connected())
+    {
+      return;
+    }
+
+  try
+    {
+      std::shared_ptr<loopp::mqtt::MqttClient> mqtt = context->get_mqtt();
+      bool membership_changed = false;
+      for (const auto &event : events)
+        {
+          json je;
+          switch (event.type)
+            {
+            case loopp::ble::PresenceTracker::EventType::Enter:
+              je["event"] = "enter";
+              membership_changed = true;
+              break;
+            case loopp::ble::PresenceTracker::EventType::Exit:
+              je["event"] = "exit";
+              je["reason"] = event.timed_out ? "timeout" : event.evicted ? "evicted" : "rssi";
+              membership_changed = true;
+              break;
+            case loopp::ble::PresenceTracker::EventType::Change:
+              je["event"] = "change";
+              break;
+            }
+          je["mac"] = ScanContext::bda_as_string(event.bda);
+          je["rssi"] = std::round(event.rssi * 10.0f) / 10.0f;
+          je["time"] = context->to_wall_clock(event.timestamp);
+          mqtt->publish(topic, je.dump());
+        }
+
+      if (snapshot && membership_changed)
+        {
+          publish_snapshot();
+        }
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to publish presence events: %s", e.what());
+    }
+}
+
+void
+PresenceStage::publish_snapshot()
+{
+  // Retained, so that a new subscriber immediately learns which devices
+  // are present.
+  json js;
+  js["time"] = context->to_wall_clock(esp_timer_get_time());
+  js["present"] = json::array();
+  tracker.for_each_present([&js](const loopp::ble::PresenceTracker::Device &device) {
+    json jd;
+    jd["mac"] = ScanContext::bda_as_string(device.bda);
+    jd["rssi"] = std::round(device.reported_rssi * 10.0f) / 10.0f;
+    js["present"].push_back(jd);
+  });
+  context->get_mqtt()->publish(topic + "/snapshot", js.dump(), loopp::mqtt::PublishOptions::Retain);
+}
+
+void
+PresenceStage::on_mqtt_connected(bool connected)
+{
+  // Events are dropped while disconnected. The snapshot brings subscribers
+  // up to date again.
+  if (connected)
+    {
+      try
+        {
+          publish_snapshot();
+        }
+      catch (std::exception &e)
+        {
+          ESP_LOGE(tag, "Failed to publish presence snapshot: %s", e.what());
+        }
+    }
+}
+
+void
+PresenceStage::schedule_timer()
+{
+  std::int64_t deadline = tracker.next_deadline();
+  if (deadline == 0)
+    {
+      return;
+    }
+
+  // Devices only time out later when they are seen again, so the timer
+  // never fires late. At worst it fires early and is rescheduled.
+  std::int64_t delay = std::max<std::int64_t>(deadline - esp_timer_get_time(), 0);
+  auto self = shared_from_this();
+  timer = context->get_loop()->add_timer(std::chrono::milliseconds(delay / 1000 + 1), [this, self]() { on_timer(); });
+}
+
+void
+PresenceStage::on_timer()
+{
+  timer = 0;
+
+  std::vector<loopp::ble::PresenceTracker::Event> events;
+  tracker.expire(esp_timer_get_time(), events);
+  publish_events(events);
+  schedule_timer();
+}
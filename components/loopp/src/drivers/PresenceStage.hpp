@@ -0,0 +1,71 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_PRESENCESTAGE_HPP
+#define LOOPP_DRIVERS_PRESENCESTAGE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "loopp/ble/PresenceTracker.hpp"
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/core/Signal.hpp"
+
+#include "ScanContext.hpp"
+#include "ScanStage.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // Publishes enter, exit and change events of nearby devices on
+    // <root>/presence and, optionally, a retained snapshot of the devices
+    // that are present on <root>/presence/snapshot.
+    class PresenceStage
+      : public ScanStage
+      , public std::enable_shared_from_this<PresenceStage>
+    {
+    public:
+      PresenceStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config);
+
+      void start() override;
+      void stop() override;
+      Disposition process(const loopp::ble::BLEScanner::ScanResult &result) override;
+
+    private:
+      void publish_events(const std::vector<loopp::ble::PresenceTracker::Event> &events);
+      void publish_snapshot();
+      void on_mqtt_connected(bool connected);
+      void schedule_timer();
+      void on_timer();
+
+    private:
+      std::shared_ptr<ScanContext> context;
+      std::string topic;
+      loopp::ble::PresenceTracker tracker;
+      bool snapshot = false;
+      loopp::core::MainLoop::timer_id timer = 0;
+      loopp::core::ScopedConnection mqtt_connected_connection;
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_PRESENCESTAGE_HPP
@@ -0,0 +1,90 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PriorityStage.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+using namespace loopp::drivers;
+
+using json = nlohmann::json;
+
+static const char *tag = "BLE-SCANNER";
+
+PriorityStage::PriorityStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config)
+  : context(std::move(context))
+  , topic(this->context->get_topic("scan/priority"))
+  , classifier(config)
+{
+}
+
+bool
+PriorityStage::matches(const loopp::ble::BLEScanner::ScanResult &result) const
+{
+  return classifier.match(reinterpret_cast<const uint8_t *>(result.adv_data.data()), result.adv_data.size());
+}
+
+ScanStage::Disposition
+PriorityStage::process(const loopp::ble::BLEScanner::ScanResult &result)
+{
+  if (!matches(result))
+    {
+      return Disposition::Continue;
+    }
+
+  publish(result);
+  return Disposition::NotBatched;
+}
+
+void
+PriorityStage::add_stats(nlohmann::json &stats)
+{
+  stats["latency_us"]["priority"] = ScanContext::latency_stats(latency);
+  latency.reset();
+}
+
+void
+PriorityStage::publish(const loopp::ble::BLEScanner::ScanResult &result)
+{
+  try
+    {
+      if (!context->is_connected())
+        {
+          return;
+        }
+
+      json jb = context->encode_scan_result(result.bda, result.rssi, result.adv_data);
+      jb["time"] = context->to_wall_clock(result.timestamp);
+
+      int64_t timestamp = result.timestamp;
+      auto self = shared_from_this();
+      context->get_mqtt()->publish(topic, jb.dump(), loopp::mqtt::PublishOptions::None, [this, self, timestamp](std::error_code ec) {
+        if (!ec)
+          {
+            latency.add(esp_timer_get_time() - timestamp);
+          }
+      });
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to publish priority scan result: %s", e.what());
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_PRIORITYSTAGE_HPP
+#define LOOPP_DRIVERS_PRIORITYSTAGE_HPP
+
+#include <memory>
+#include <string>
+
+#include "loopp/ble/PriorityClassifier.hpp"
+#include "loopp/core/LatencyHistogram.hpp"
+
+#include "ScanContext.hpp"
+#include "ScanStage.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // Publishes advertisements that match a priority rule at once on
+    // <root>/scan/priority. They still pass through the other stages, but
+    // are left out of the raw batch.
+    class PriorityStage
+      : public ScanStage
+      , public std::enable_shared_from_this<PriorityStage>
+    {
+    public:
+      PriorityStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config);
+
+      // The rules do not change after construction, so this may be called
+      // from any task.
+      bool matches(const loopp::ble::BLEScanner::ScanResult &result) const;
+
+      Disposition process(const loopp::ble::BLEScanner::ScanResult &result) override;
+      void add_stats(nlohmann::json &stats) override;
+
+    private:
+      void publish(const loopp::ble::BLEScanner::ScanResult &result);
+
+    private:
+      std::shared_ptr<ScanContext> context;
+      std::string topic;
+      loopp::ble::PriorityClassifier classifier;
+      // Time from reception until the message is written to the MQTT socket.
+      loopp::core::LatencyHistogram latency;
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_PRIORITYSTAGE_HPP
@@ -0,0 +1,183 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ScanContext.hpp"
+
+#include <cstring>
+
+#include "esp_log.h"
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/PatternDecoder.hpp"
+
+using namespace loopp::drivers;
+
+using json = nlohmann::json;
+
+static const char *tag = "BLE-SCANNER";
+
+ScanContext::ScanContext(DriverContext context, const nlohmann::json &config)
+  : loop(context.get_loop())
+  , mqtt(context.get_mqtt())
+  , time_sync(context.get_time_sync())
+  , topic_root(context.get_topic_root())
+{
+  auto it = config.find("adv_data");
+  if (it != config.end())
+    {
+      std::string mode = *it;
+
+      if (mode == "always")
+        {
+          omit_recognized_adv_data = false;
+        }
+      else if (mode == "unrecognized")
+        {
+          omit_recognized_adv_data = true;
+        }
+      else
+        {
+          throw std::runtime_error("invalid adv_data value: " + mode);
+        }
+    }
+
+  it = config.find("decoders");
+  if (it != config.end())
+    {
+      auto pattern_decoder = std::make_shared<loopp::ble::PatternDecoder>(*it);
+      decoder.add_decoder(loopp::ble::AdType::ManufacturerSpecific, pattern_decoder);
+      decoder.add_decoder(loopp::ble::AdType::ServiceData16, pattern_decoder);
+      ESP_LOGI(tag, "Compiled %d pattern decoders", static_cast<int>(pattern_decoder->size()));
+    }
+
+  rssi_offset = config.value("rssi_offset", 0);
+}
+
+std::shared_ptr<loopp::core::MainLoop>
+ScanContext::get_loop() const
+{
+  return loop;
+}
+
+std::shared_ptr<loopp::mqtt::MqttClient>
+ScanContext::get_mqtt() const
+{
+  return mqtt;
+}
+
+std::shared_ptr<loopp::mqtt::MqttTimeSync>
+ScanContext::get_time_sync() const
+{
+  return time_sync;
+}
+
+std::string
+ScanContext::get_topic(const std::string &name) const
+{
+  return topic_root + name;
+}
+
+int
+ScanContext::get_rssi_offset() const
+{
+  return rssi_offset;
+}
+
+const loopp::ble::AdvertisementDecoder &
+ScanContext::get_decoder() const
+{
+  return decoder;
+}
+
+bool
+ScanContext::is_connected() const
+{
+  return mqtt && mqtt->connected().get();
+}
+
+int64_t
+ScanContext::to_wall_clock(int64_t timestamp) const
+{
+  return loopp::mqtt::MqttTimeSync::to_wall_clock(time_sync.get(), timestamp);
+}
+
+json
+ScanContext::encode_scan_result(const uint8_t bda[6], int rssi, const std::string &adv_data) const
+{
+  json jb;
+  jb["mac"] = bda_as_string(bda);
+  jb["bda"] = base64_encode(std::string(reinterpret_cast<const char *>(bda), 6));
+  jb["rssi"] = rssi;
+
+  bool recognized = decoder.decode(adv_data, jb);
+  if (!recognized || !omit_recognized_adv_data)
+    {
+      jb["adv_data"] = base64_encode(adv_data);
+    }
+  return jb;
+}
+
+// https://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
+std::string
+ScanContext::base64_encode(const std::string &in)
+{
+  std::string out;
+
+  int val = 0, valb = -6;
+  for (char c : in)
+    {
+      val = (val << 8) + c;
+      valb += 8;
+      while (valb >= 0)
+        {
+          out.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[(val >> valb) & 0x3F]);
+          valb -= 6;
+        }
+    }
+  if (valb > -6)
+    {
+      out.push_back("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[((val << 8) >> (valb + 8)) & 0x3F]);
+    }
+  while ((out.size() % 4) != 0u)
+    {
+      out.push_back('=');
+    }
+  return out;
+}
+
+std::string
+ScanContext::bda_as_string(const uint8_t bda[6])
+{
+  loopp::ble::BLEScanner::ScanResult r;
+  memcpy(r.bda, bda, sizeof(r.bda));
+  return r.bda_as_string();
+}
+
+json
+ScanContext::latency_stats(const loopp::core::LatencyHistogram &histogram)
+{
+  json stats;
+  stats["count"] = histogram.get_count();
+  stats["p50"] = histogram.get_percentile(50);
+  stats["p90"] = histogram.get_percentile(90);
+  stats["p99"] = histogram.get_percentile(99);
+  stats["max"] = histogram.get_max();
+  return stats;
+}
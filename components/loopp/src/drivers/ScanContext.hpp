@@ -0,0 +1,79 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_SCANCONTEXT_HPP
+#define LOOPP_DRIVERS_SCANCONTEXT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/core/LatencyHistogram.hpp"
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/drivers/DriverRegistry.hpp"
+#include "loopp/mqtt/MqttClient.hpp"
+#include "loopp/mqtt/MqttTimeSync.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // State that the BLE scanner driver shares with its stages: the MQTT
+    // connection, the topics and the encoding of scan results. The decoder
+    // and encoding options do not change after construction, so results
+    // may be encoded from any task.
+    class ScanContext
+    {
+    public:
+      ScanContext(DriverContext context, const nlohmann::json &config);
+
+      std::shared_ptr<loopp::core::MainLoop> get_loop() const;
+      std::shared_ptr<loopp::mqtt::MqttClient> get_mqtt() const;
+      std::shared_ptr<loopp::mqtt::MqttTimeSync> get_time_sync() const;
+      std::string get_topic(const std::string &name) const;
+      int get_rssi_offset() const;
+      const loopp::ble::AdvertisementDecoder &get_decoder() const;
+
+      bool is_connected() const;
+      int64_t to_wall_clock(int64_t timestamp) const;
+      nlohmann::json encode_scan_result(const uint8_t bda[6], int rssi, const std::string &adv_data) const;
+
+      static std::string base64_encode(const std::string &in);
+      static std::string bda_as_string(const uint8_t bda[6]);
+      static nlohmann::json latency_stats(const loopp::core::LatencyHistogram &histogram);
+
+    private:
+      std::shared_ptr<loopp::core::MainLoop> loop;
+      std::shared_ptr<loopp::mqtt::MqttClient> mqtt;
+      std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync;
+      std::string topic_root;
+      loopp::ble::AdvertisementDecoder decoder;
+      bool omit_recognized_adv_data = false;
+      // Calibration of this scanner's receiver, added to every RSSI sample
+      // before filtering.
+      int rssi_offset = 0;
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_SCANCONTEXT_HPP
@@ -0,0 +1,76 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_SCANSTAGE_HPP
+#define LOOPP_DRIVERS_SCANSTAGE_HPP
+
+#include "loopp/ble/BLEScanner.hpp"
+#include "loopp/ble/ScanBatch.hpp"
+
+#include "loopp/utils/json.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // One optional feature of the BLE scanner driver, such as presence
+    // detection or RSSI filtering. The driver passes every scan result
+    // through its stages, in order, on the main loop. A stage owns its
+    // configuration and timers.
+    class ScanStage
+    {
+    public:
+      // What happens to a scan result after the stage processed it.
+      enum class Disposition
+      {
+        // Pass it to the next stage and publish it in the raw batch.
+        Continue,
+        // Pass it to the next stage, but do not publish it in the raw batch.
+        NotBatched,
+        // Do not pass it on.
+        Consumed,
+      };
+
+      virtual ~ScanStage() = default;
+
+      virtual void start()
+      {
+      }
+
+      virtual void stop()
+      {
+      }
+
+      virtual Disposition process(const loopp::ble::BLEScanner::ScanResult &result) = 0;
+
+      // Adds the records of the past publish period to the scan batch.
+      virtual void add_records(loopp::ble::ScanBatch &)
+      {
+      }
+
+      // Adds the statistics since the previous call to the stats message.
+      virtual void add_stats(nlohmann::json &)
+      {
+      }
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_SCANSTAGE_HPP
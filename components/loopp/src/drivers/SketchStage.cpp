@@ -0,0 +1,84 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SketchStage.hpp"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+using namespace loopp::drivers;
+
+using json = nlohmann::json;
+
+static const char *tag = "BLE-SCANNER";
+
+SketchStage::SketchStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config)
+  : context(std::move(context))
+  , topic(this->context->get_topic("scan/summary"))
+  , sketch(config)
+  , interval(config.value("window", 10))
+{
+  ESP_LOGI(tag, "Aggregating into sketches of %d bytes", static_cast<int>(sketch.memory_size()));
+}
+
+void
+SketchStage::start()
+{
+  auto self = shared_from_this();
+  timer = context->get_loop()->add_periodic_timer(interval, [this, self]() { on_timer(); });
+}
+
+void
+SketchStage::stop()
+{
+  if (timer != 0)
+    {
+      context->get_loop()->cancel_timer(timer);
+      timer = 0;
+    }
+}
+
+ScanStage::Disposition
+SketchStage::process(const loopp::ble::BLEScanner::ScanResult &result)
+{
+  // Only the summary is published in this mode.
+  sketch.add(result);
+  return Disposition::Consumed;
+}
+
+void
+SketchStage::on_timer()
+{
+  try
+    {
+      if (context->is_connected())
+        {
+          json summary = sketch.summary();
+          summary["window"] = interval.count();
+          summary["base_wall"] = context->to_wall_clock(esp_timer_get_time());
+          context->get_mqtt()->publish(topic, summary.dump());
+        }
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to publish scan summary: %s", e.what());
+    }
+  sketch.clear();
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef LOOPP_DRIVERS_SKETCHSTAGE_HPP
+#define LOOPP_DRIVERS_SKETCHSTAGE_HPP
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "loopp/ble/SketchAggregator.hpp"
+#include "loopp/core/MainLoop.hpp"
+
+#include "ScanContext.hpp"
+#include "ScanStage.hpp"
+
+namespace loopp
+{
+  namespace drivers
+  {
+    // Aggregates scan results into sketches and publishes a summary on
+    // <root>/scan/summary once per window. Results do not reach later
+    // stages or the raw batch.
+    class SketchStage
+      : public ScanStage
+      , public std::enable_shared_from_this<SketchStage>
+    {
+    public:
+      SketchStage(std::shared_ptr<ScanContext> context, const nlohmann::json &config);
+
+      void start() override;
+      void stop() override;
+      Disposition process(const loopp::ble::BLEScanner::ScanResult &result) override;
+
+    private:
+      void on_timer();
+
+    private:
+      std::shared_ptr<ScanContext> context;
+      std::string topic;
+      loopp::ble::SketchAggregator sketch;
+      std::chrono::seconds interval{ 10 };
+      loopp::core::MainLoop::timer_id timer = 0;
+    };
+  } // namespace drivers
+} // namespace loopp
+
+#endif // LOOPP_DRIVERS_SKETCHSTAGE_HPP
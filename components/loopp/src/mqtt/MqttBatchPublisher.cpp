@@ -0,0 +1,200 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/mqtt/MqttBatchPublisher.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "esp_log.h"
+
+static const char *tag = "MQTT";
+
+using namespace loopp;
+using namespace loopp::mqtt;
+
+static const char results_prefix[] = ",\"results\":[";
+static const char results_suffix[] = "]}";
+
+MqttBatchPublisher::MqttBatchPublisher(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<MqttClient> mqtt, std::string topic)
+  : loop(std::move(loop))
+  , mqtt(std::move(mqtt))
+  , topic(std::move(topic))
+{
+  max_packet_size = this->mqtt->get_max_payload_size(this->topic);
+}
+
+void
+MqttBatchPublisher::set_max_packet_size(std::size_t size)
+{
+  max_packet_size = std::min(size, mqtt->get_max_payload_size(topic));
+}
+
+std::size_t
+MqttBatchPublisher::get_max_packet_size() const
+{
+  return max_packet_size;
+}
+
+void
+MqttBatchPublisher::set_publish_options(PublishOptions options)
+{
+  this->options = options;
+}
+
+void
+MqttBatchPublisher::publish(std::vector<std::string> records, nlohmann::json header, MqttClient::publish_callback_t callback)
+{
+  auto batch = std::make_shared<Batch>();
+  batch->seq = next_seq++;
+  batch->header = std::move(header);
+  batch->records = std::move(records);
+  batch->callback = std::move(callback);
+
+  batch->part_ends = partition(batch->records, batch->header, max_packet_size);
+
+  if (!batch->part_ends.empty())
+    {
+      publish_part(batch);
+    }
+}
+
+std::size_t
+MqttBatchPublisher::get_envelope_size(const nlohmann::json &header, std::size_t parts)
+{
+  nlohmann::json envelope = header;
+  envelope["seq"] = std::numeric_limits<std::uint32_t>::max();
+  envelope["part"] = parts;
+  envelope["parts"] = parts;
+
+  return envelope.dump().size() - 1 + sizeof(results_prefix) - 1 + sizeof(results_suffix) - 1;
+}
+
+std::vector<std::size_t>
+MqttBatchPublisher::partition(std::vector<std::string> &records, const nlohmann::json &header, std::size_t max_packet_size)
+{
+  std::size_t envelope_size = get_envelope_size(header, records.size());
+
+  auto oversized = std::remove_if(records.begin(), records.end(), [max_packet_size, envelope_size](const std::string &record) {
+    return envelope_size + record.size() > max_packet_size;
+  });
+  if (oversized != records.end())
+    {
+      ESP_LOGE(tag, "Dropping %d records that exceed the maximum packet size of %d", static_cast<int>(std::distance(oversized, records.end())),
+               static_cast<int>(max_packet_size));
+      records.erase(oversized, records.end());
+    }
+
+  std::vector<std::size_t> part_ends;
+  std::size_t size = envelope_size;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < records.size(); i++)
+    {
+      std::size_t record_size = records[i].size() + (count > 0 ? 1 : 0);
+      if (count > 0 && size + record_size > max_packet_size)
+        {
+          part_ends.push_back(i);
+          size = envelope_size;
+          count = 0;
+          record_size = records[i].size();
+        }
+      size += record_size;
+      count++;
+    }
+
+  if (count > 0)
+    {
+      part_ends.push_back(records.size());
+    }
+  return part_ends;
+}
+
+std::string
+MqttBatchPublisher::encode_part(const nlohmann::json &header, std::uint32_t seq, std::size_t part, std::size_t parts,
+                                std::vector<std::string> &records, std::size_t begin, std::size_t end)
+{
+  nlohmann::json envelope = header;
+  envelope["seq"] = seq;
+  envelope["part"] = part + 1;
+  envelope["parts"] = parts;
+
+  std::string payload = envelope.dump();
+  payload.pop_back();
+
+  std::size_t size = payload.size() + sizeof(results_prefix) - 1 + sizeof(results_suffix) - 1;
+  for (std::size_t i = begin; i < end; i++)
+    {
+      size += records[i].size() + 1;
+    }
+  payload.reserve(size);
+
+  payload += results_prefix;
+  for (std::size_t i = begin; i < end; i++)
+    {
+      if (i != begin)
+        {
+          payload += ',';
+        }
+      payload += records[i];
+      std::string().swap(records[i]);
+    }
+  payload += results_suffix;
+  return payload;
+}
+
+void
+MqttBatchPublisher::publish_part(std::shared_ptr<Batch> batch)
+{
+  std::size_t begin = batch->part == 0 ? 0 : batch->part_ends[batch->part - 1];
+  std::size_t end = batch->part_ends[batch->part];
+
+  try
+    {
+      std::string payload = encode_part(batch->header, batch->seq, batch->part, batch->part_ends.size(), batch->records, begin, end);
+
+      bool last = batch->part + 1 == batch->part_ends.size();
+      mqtt->publish(topic, std::move(payload), options, last ? batch->callback : nullptr);
+    }
+  catch (std::system_error &e)
+    {
+      ESP_LOGE(tag, "Failed to publish part %d of batch %d: %s", static_cast<int>(batch->part + 1), batch->seq, e.what());
+      if (batch->callback)
+        {
+          batch->callback(e.code());
+        }
+      return;
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to publish part %d of batch %d: %s", static_cast<int>(batch->part + 1), batch->seq, e.what());
+      if (batch->callback)
+        {
+          batch->callback(std::make_error_code(std::errc::io_error));
+        }
+      return;
+    }
+
+  batch->part++;
+  if (batch->part < batch->part_ends.size())
+    {
+      auto self = shared_from_this();
+      loop->invoke([this, self, batch]() { publish_part(batch); });
+    }
+}
@@ -28,6 +28,7 @@
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 
+#include "loopp/core/RadioCoordinator.hpp"
 #include "loopp/mqtt/MqttPacket.hpp"
 #include "loopp/mqtt/MqttErrors.hpp"
 #include "loopp/net/TCPStream.hpp"
@@ -39,6 +40,8 @@ static const char *tag = "MQTT";
 using namespace loopp;
 using namespace loopp::mqtt;
 
+constexpr std::size_t MqttClient::read_chunk_size;
+
 MqttClient::MqttClient(std::shared_ptr<loopp::core::MainLoop> loop, std::string client_id, std::string host, int port)
   : loop(std::move(loop))
   , client_id(std::move(client_id))
@@ -96,6 +99,18 @@ MqttClient::set_will_retain(bool retain)
   will_retain = retain;
 }
 
+void
+MqttClient::set_max_inflight(std::size_t window)
+{
+  outbox.set_window(window);
+}
+
+void
+MqttClient::set_clean_session(bool clean)
+{
+  clean_session = clean;
+}
+
 void
 MqttClient::connect()
 {
@@ -158,36 +173,88 @@ MqttClient::disconnect()
       ping_timer = 0;
     }
 
+  session_ready = false;
   if (sock)
     {
       sock->close();
       sock.reset();
     }
+
+  // Nothing is retransmitted after an explicit disconnect.
+  for (auto &m : outbox.clear())
+    {
+      if (m.state == MqttOutbox::State::Queued)
+        {
+          send_backlog -= m.topic.size() + m.payload->size();
+        }
+      if (m.callback)
+        {
+          m.callback(MqttErrc::NotConnected);
+        }
+    }
+  unacknowledged = 0;
+  inbound_pending.clear();
 }
 
 void
-MqttClient::publish(const std::string &topic, const std::string &payload, PublishOptions options)
+MqttClient::publish(const std::string &topic, const std::string &payload, PublishOptions options, publish_callback_t callback)
+{
+  publish(topic, std::make_shared<const std::string>(payload), options, callback);
+}
+
+void
+MqttClient::publish(const std::string &topic, std::string &&payload, PublishOptions options, publish_callback_t callback)
+{
+  publish(topic, std::make_shared<const std::string>(std::move(payload)), options, callback);
+}
+
+void
+MqttClient::publish(const std::string &topic, std::shared_ptr<const std::string> payload, PublishOptions options, publish_callback_t callback)
 {
   if (!connected_property.get())
     {
       throw std::system_error(MqttErrc::NotConnected, "not connected to MQTT server");
     }
 
+  send_backlog += topic.size() + payload->size();
+
   auto self = shared_from_this();
-  loop->invoke([this, self, topic, payload, options]() { send_publish(topic, payload, options); });
+  if (options & (PublishOptions::Qos1 | PublishOptions::Qos2))
+    {
+      unacknowledged++;
+      loop->invoke([this, self, topic, payload, options, callback]() {
+        MqttOutbox::Message m;
+        m.topic = topic;
+        m.payload = payload;
+        m.qos = (options & PublishOptions::Qos2) ? 2 : 1;
+        m.retain = (options & PublishOptions::Retain) ? true : false;
+        m.callback = callback;
+        outbox.push(std::move(m));
+        send_pending();
+      });
+    }
+  else
+    {
+      loop->invoke([this, self, topic, payload, options, callback]() { send_publish(topic, payload, options, callback); });
+    }
 }
 
 void
-MqttClient::subscribe(const std::string &topic)
+MqttClient::subscribe(const std::string &topic, std::uint8_t qos)
 {
-  subscriptions.push_back(topic);
+  if (qos > 2)
+    {
+      throw std::system_error(MqttErrc::ProtocolError, "invalid QoS " + std::to_string(qos));
+    }
+
+  subscriptions.push_back(Subscription{ topic, qos });
 
   if (connected_property.get())
     {
       auto self = shared_from_this();
-      loop->invoke([this, self, topic]() {
-        std::list<std::string> topics;
-        topics.push_back(topic);
+      loop->invoke([this, self, topic, qos]() {
+        std::list<Subscription> topics;
+        topics.push_back(Subscription{ topic, qos });
         send_subscribe(topics);
       });
     }
@@ -196,7 +263,7 @@ MqttClient::subscribe(const std::string &topic)
 void
 MqttClient::unsubscribe(const std::string &topic)
 {
-  subscriptions.remove(topic);
+  subscriptions.remove_if([&topic](const Subscription &s) { return s.topic == topic; });
 
   if (connected_property.get())
     {
@@ -209,6 +276,29 @@ MqttClient::unsubscribe(const std::string &topic)
     }
 }
 
+std::size_t
+MqttClient::get_send_backlog() const
+{
+  return send_backlog.load();
+}
+
+std::size_t
+MqttClient::get_unacknowledged_count() const
+{
+  return unacknowledged.load();
+}
+
+std::size_t
+MqttClient::get_max_payload_size(const std::string &topic) const
+{
+  // Fixed header, up to 4 bytes of remaining length, the length prefixed
+  // topic and the packet id of QoS 1/2 messages.
+  std::size_t overhead = 1 + 4 + 2 + topic.size() + 2;
+  std::size_t max_size = loopp::net::StreamBuffer::DEFAULT_MAX_BUFFER_SIZE;
+
+  return overhead < max_size ? max_size - overhead : 0;
+}
+
 void
 MqttClient::set_callback(subscribe_callback_t callback)
 {
@@ -249,7 +339,10 @@ MqttClient::send_connect()
           len += will_data.size() + 2;
         }
 
-      flags |= ConnectFlags::CleanSession;
+      if (clean_session)
+        {
+          flags |= ConnectFlags::CleanSession;
+        }
 
       pkt->add_fixed_header(loopp::mqtt::PacketType::Connect, 0);
       pkt->add_length(len);
@@ -281,7 +374,10 @@ MqttClient::send_connect()
         ec = verify("send connect", bytes_transferred, pkt->size(), ec);
         if (!ec)
           {
-            async_read_control_packet();
+            // Discard what is left of a previous connection.
+            buffer.consume_commit(buffer.consume_size());
+            read_size = read_chunk_size;
+            async_read_packets();
           }
       });
     }
@@ -318,49 +414,161 @@ MqttClient::send_ping()
 }
 
 void
-MqttClient::send_publish(const std::string &topic, const std::string &payload, PublishOptions options)
+MqttClient::send_publish(const std::string &topic, std::shared_ptr<const std::string> payload, PublishOptions options, publish_callback_t callback)
+{
+  std::size_t size = topic.size() + payload->size();
+
+  BitMask<PublishFlags> flags = PublishFlags::None;
+  if (options & PublishOptions::Retain)
+    {
+      flags |= PublishFlags::Retain;
+    }
+
+  write_publish(topic, payload, flags, 0, [this, size, callback](std::error_code ec) {
+    send_backlog -= size;
+    if (callback)
+      {
+        callback(ec);
+      }
+  });
+}
+
+void
+MqttClient::send_message(const MqttOutbox::Message &message, bool duplicate)
+{
+  std::size_t size = message.topic.size() + message.payload->size();
+
+  BitMask<PublishFlags> flags = message.qos == 2 ? PublishFlags::Qos2 : PublishFlags::Qos1;
+  if (message.retain)
+    {
+      flags |= PublishFlags::Retain;
+    }
+  if (duplicate)
+    {
+      flags |= PublishFlags::Duplicate;
+    }
+
+  // On failure the message stays in flight and is retransmitted after the
+  // reconnect.
+  write_publish(message.topic, message.payload, flags, message.id, [this, size, duplicate](std::error_code ec) {
+    if (!duplicate)
+      {
+        send_backlog -= size;
+      }
+  });
+}
+
+void
+MqttClient::write_publish(const std::string &topic, const std::shared_ptr<const std::string> &payload, BitMask<PublishFlags> flags,
+                          std::uint16_t id, publish_callback_t done)
 {
   try
     {
-      std::shared_ptr<MqttPacket> pkt = std::make_shared<MqttPacket>();
+      if (!sock)
+        {
+          throw std::system_error(MqttErrc::NotConnected, "not connected to MQTT server");
+        }
+
+      // The header is encoded in place; the payload is written from the
+      // caller's buffer, which the write callback keeps alive.
+      auto header = std::make_shared<MqttPublishHeader>(topic, static_cast<uint8_t>(flags.value()), id, payload->size());
+      std::size_t expected = header->size() + payload->size();
 
-      std::size_t len = 0;
-      BitMask<PublishFlags> flags = PublishFlags::None;
+      std::vector<loopp::net::ConstBuffer> buffers;
+      buffers.push_back(loopp::net::ConstBuffer{ header->data(), header->size() });
+      buffers.push_back(loopp::net::ConstBuffer{ reinterpret_cast<const uint8_t *>(payload->data()), payload->size() });
 
-      if (options & PublishOptions::Retain)
+      // Large payloads take many air-time slots; scan with a reduced window
+      // until the write completes.
+      std::shared_ptr<loopp::core::RadioCoordinator::Lease> radio_lease;
+      if (payload->size() >= 4096)
         {
-          flags |= PublishFlags::Retain;
+          radio_lease = std::make_shared<loopp::core::RadioCoordinator::Lease>(loopp::core::RadioCoordinator::instance().request(
+            loopp::core::RadioCoordinator::Mode::Reduced, std::chrono::milliseconds(2000), "mqtt"));
         }
 
-      len += topic.size() + 2;
-      len += payload.size();
+      auto self = shared_from_this();
+      sock->write_async(std::move(buffers),
+                        [this, self, header, payload, expected, radio_lease, done](std::error_code ec, std::size_t bytes_transferred) {
+                          if (radio_lease)
+                            {
+                              radio_lease->release();
+                            }
+                          ec = verify("send publish", bytes_transferred, expected, ec);
+                          done(ec);
+                        });
+    }
+  catch (std::system_error &e)
+    {
+      handle_error(std::string("send publish: ") + e.what(), e.code());
+      done(e.code());
+    }
+}
+
+void
+MqttClient::send_ack(PacketType type, std::uint16_t id)
+{
+  try
+    {
+      std::shared_ptr<MqttPacket> pkt = std::make_shared<MqttPacket>();
 
-      pkt->add_fixed_header(loopp::mqtt::PacketType::Publish, static_cast<uint8_t>(flags.value()));
-      pkt->add_length(len);
-      pkt->add(topic);
-      pkt->append(payload);
+      // PUBREL is the only acknowledgement with reserved flag bits set.
+      pkt->add_fixed_header(type, type == PacketType::PubRel ? 0b0010u : 0);
+      pkt->add(2);
+      pkt->add(static_cast<std::uint8_t>(id >> 8));
+      pkt->add(static_cast<std::uint8_t>(id & 0xff));
 
       auto self = shared_from_this();
       sock->write_async(pkt->get_buffer(), [this, self, pkt](std::error_code ec, std::size_t bytes_transferred) {
-        verify("send publish", bytes_transferred, pkt->size(), ec);
+        verify("send ack", bytes_transferred, pkt->size(), ec);
       });
     }
   catch (std::system_error &e)
     {
-      handle_error(std::string("send publish: ") + e.what(), e.code());
+      handle_error(std::string("send ack: ") + e.what(), e.code());
     }
 }
 
 void
-MqttClient::send_subscribe(const std::list<std::string> &topics)
+MqttClient::send_pending()
+{
+  // Fill the window instead of waiting for each acknowledgement in turn.
+  while (session_ready && sock)
+    {
+      MqttOutbox::Message *m = outbox.admit();
+      if (m == nullptr)
+        {
+          break;
+        }
+      send_message(*m, false);
+    }
+}
+
+void
+MqttClient::resend_inflight()
+{
+  outbox.for_each_inflight([this](const MqttOutbox::Message &m) {
+    if (m.state == MqttOutbox::State::AwaitComp)
+      {
+        send_ack(PacketType::PubRel, m.id);
+      }
+    else
+      {
+        send_message(m, true);
+      }
+  });
+}
+
+void
+MqttClient::send_subscribe(const std::list<Subscription> &topics)
 {
   try
     {
       std::shared_ptr<MqttPacket> pkt = std::make_shared<MqttPacket>();
-      packet_id++;
+      std::uint16_t packet_id = outbox.allocate_id();
 
       std::size_t len = 2 +
-                        std::accumulate(topics.begin(), topics.end(), 0, [](int sum, const std::string &s) { return sum + s.size() + 2 + 1; });
+                        std::accumulate(topics.begin(), topics.end(), 0, [](int sum, const Subscription &s) { return sum + s.topic.size() + 2 + 1; });
 
       pkt->add_fixed_header(loopp::mqtt::PacketType::Subscribe, 0b0010u);
       pkt->add_length(len);
@@ -368,8 +576,8 @@ MqttClient::send_subscribe(const std::list<std::string> &topics)
       pkt->add(static_cast<std::uint8_t>(packet_id & 0xff));
       for (const auto &topic : topics)
         {
-          pkt->add(topic);
-          pkt->add(0);
+          pkt->add(topic.topic);
+          pkt->add(topic.qos);
         }
 
       auto self = shared_from_this();
@@ -389,7 +597,7 @@ MqttClient::send_unsubscribe(const std::list<std::string> &topics)
   try
     {
       std::shared_ptr<MqttPacket> pkt = std::make_shared<MqttPacket>();
-      packet_id++;
+      std::uint16_t packet_id = outbox.allocate_id();
 
       std::size_t len = 2 + std::accumulate(topics.begin(), topics.end(), 0, [](int sum, const std::string &s) { return sum + s.size() + 2; });
 
@@ -414,81 +622,79 @@ MqttClient::send_unsubscribe(const std::list<std::string> &topics)
 }
 
 void
-MqttClient::async_read_control_packet()
+MqttClient::async_read_packets()
 {
   auto self = shared_from_this();
-  sock->read_async(buffer, 1, [this, self](std::error_code ec, std::size_t bytes_transferred) {
-    ec = verify("fixed header", bytes_transferred, 1, ec);
+  sock->read_some_async(buffer, read_size, [this, self](std::error_code ec, std::size_t bytes_transferred) {
+    ec = verify("read", bytes_transferred, bytes_transferred, ec);
     if (!ec)
       {
-        handle_control_packet();
+        // Data that is available immediately is handled by the loop in
+        // handle_input() instead of recursing into it.
+        if (handling_input)
+          {
+            input_pending = true;
+          }
+        else
+          {
+            handle_input();
+          }
       }
   });
 }
 
 void
-MqttClient::handle_control_packet()
+MqttClient::handle_input()
 {
-  remaining_length = 0;
-  remaining_length_multiplier = 1;
-  fixed_header = *buffer.consume_data();
-  buffer.consume_commit(1);
-
-  async_read_remaining_length();
-}
-
-void
-MqttClient::async_read_remaining_length()
-{
-  auto self = shared_from_this();
-  sock->read_async(buffer, 1, [this, self](std::error_code ec, std::size_t bytes_transferred) {
-    ec = verify("remaining length", bytes_transferred, 1, ec);
-    if (!ec)
-      {
-        handle_remaining_length();
-      }
-  });
+  handling_input = true;
+  do
+    {
+      input_pending = false;
+      if (!handle_packets() || !sock)
+        {
+          break;
+        }
+      async_read_packets();
+    }
+  while (input_pending);
+  handling_input = false;
 }
 
-void
-MqttClient::handle_remaining_length()
+bool
+MqttClient::handle_packets()
 {
-  uint8_t header = *reinterpret_cast<uint8_t *>(buffer.consume_data());
-  buffer.consume_commit(1);
+  while (true)
+    {
+      MqttFrame frame;
+      auto status = MqttFrame::decode(reinterpret_cast<const uint8_t *>(buffer.consume_data()), buffer.consume_size(), frame);
 
-  remaining_length += (header & 0b01111111) * remaining_length_multiplier;
-  remaining_length_multiplier *= 128;
+      if (status == MqttFrame::Status::Invalid || frame.size() > buffer.max_size())
+        {
+          verify("fixed header", 0, 0, MqttErrc::ProtocolError);
+          return false;
+        }
 
-  if ((header & 0b10000000u) != 0u)
-    {
-      async_read_remaining_length();
-    }
-  else
-    {
-      if (remaining_length == 0)
+      if (status == MqttFrame::Status::Incomplete)
         {
-          handle_payload();
+          // Read the rest of a large packet in one go, without growing the
+          // buffer beyond its maximum size.
+          std::size_t missing = frame.header_size > 0 ? frame.size() - buffer.consume_size() : 0;
+          read_size = std::min(std::max(read_chunk_size, missing), buffer.max_size() - buffer.consume_size());
+          return true;
         }
-      else
+
+      fixed_header = frame.fixed_header;
+      remaining_length = frame.remaining_length;
+      buffer.consume_commit(frame.header_size);
+
+      std::error_code ec = handle_payload();
+      if (ec || !sock)
         {
-          async_read_payload();
+          return false;
         }
     }
 }
 
-void
-MqttClient::async_read_payload()
-{
-  auto self = shared_from_this();
-  sock->read_async(buffer, remaining_length, [this, self](std::error_code ec, std::size_t bytes_transferred) {
-    ec = verify("payload", bytes_transferred, remaining_length, ec);
-    if (!ec)
-      {
-        handle_payload();
-      }
-  });
-}
-
 std::error_code
 MqttClient::handle_payload()
 {
@@ -534,16 +740,11 @@ MqttClient::handle_payload()
         break;
 
       default:
-        verify((boost::format("invalid payload type: %1%") % (static_cast<int>(packet_type))).str(), 0, 0, MqttErrc::ProtocolError);
+        ec = verify((boost::format("invalid payload type: %1%") % (static_cast<int>(packet_type))).str(), 0, 0, MqttErrc::ProtocolError);
     }
 
   buffer.consume_commit(remaining_length);
 
-  if (!ec)
-    {
-      async_read_control_packet();
-    }
-
   return ec;
 }
 
@@ -565,6 +766,19 @@ MqttClient::handle_connect_ack()
           ESP_LOGI(tag, "Info: Connect OK");
           ping_timer = loop->add_periodic_timer(std::chrono::milliseconds(ping_interval_sec * 1000), std::bind(&MqttClient::send_ping, this));
 
+          bool session_present = (payload_buffer[0] & 0x01) != 0;
+          if (!session_present)
+            {
+              inbound_pending.clear();
+            }
+          session_ready = true;
+          if (outbox.inflight_size() > 0)
+            {
+              ESP_LOGI(tag, "Info: Retransmitting %d unacknowledged messages", static_cast<int>(outbox.inflight_size()));
+              resend_inflight();
+            }
+          send_pending();
+
           if (!subscriptions.empty())
             {
               ESP_LOGI(tag, "Info: Connect OK - Sending subscriptions");
@@ -591,17 +805,23 @@ MqttClient::handle_publish()
       BitMask<PublishFlags> flags{};
 
       flags.set(fixed_header & 0x0f);
+      BitMask<PublishFlags> qos = flags & PublishFlags::QosMask;
 
-      if ((flags & PublishFlags::QosMask) != PublishFlags::Qos0)
+      if (qos == PublishFlags::QosMask)
         {
-          throw std::system_error(MqttErrc::ProtocolError, "QoS1/2 not supported");
+          throw std::system_error(MqttErrc::ProtocolError, "invalid QoS");
         }
 
       std::size_t index = 0;
+      if (remaining_length < 2)
+        {
+          throw std::system_error(MqttErrc::ProtocolError, "short packet");
+        }
       std::uint16_t topic_len = (payload_buffer[index] << 8) + payload_buffer[index + 1];
       index += 2;
 
-      if (remaining_length - index < topic_len)
+      std::size_t id_len = qos != PublishFlags::Qos0 ? 2 : 0;
+      if (remaining_length - index < topic_len + id_len)
         {
           throw std::system_error(MqttErrc::ProtocolError, "short packet");
         }
@@ -609,19 +829,39 @@ MqttClient::handle_publish()
       std::string topic(reinterpret_cast<char *>(payload_buffer + index), topic_len);
       index += topic_len;
 
-      std::string payload(reinterpret_cast<char *>(payload_buffer + index), remaining_length - index);
+      std::uint16_t id = 0;
+      if (id_len > 0)
+        {
+          id = (payload_buffer[index] << 8) + payload_buffer[index + 1];
+          index += 2;
+        }
 
-      ESP_LOGI(tag, "Info: Received %s -> %s", topic.c_str(), payload.c_str());
-      bool matched = false;
-      for (auto kv : filters)
+      if (qos == PublishFlags::Qos1)
+        {
+          send_ack(PacketType::PubAck, id);
+        }
+      else if (qos == PublishFlags::Qos2)
         {
-          if (match_topic(topic, kv.first))
+          send_ack(PacketType::PubRec, id);
+          if (!inbound_pending.insert(id).second)
             {
-              kv.second(topic, payload);
-              matched = true;
+              // Retransmission of a message that was already delivered.
+              return ec;
             }
         }
-      if (!matched)
+
+      std::string payload(reinterpret_cast<char *>(payload_buffer + index), remaining_length - index);
+
+      ESP_LOGI(tag, "Info: Received %s -> %s", topic.c_str(), payload.c_str());
+      // Callbacks are invoked after the lookup, so that they can add or
+      // remove filters.
+      std::vector<subscribe_callback_t> callbacks;
+      filters.match(topic, callbacks);
+      for (auto &callback : callbacks)
+        {
+          callback(topic, payload);
+        }
+      if (callbacks.empty() && subscribe_callback)
         {
           subscribe_callback(topic, payload);
         }
@@ -634,31 +874,95 @@ MqttClient::handle_publish()
   return ec;
 }
 
+std::error_code
+MqttClient::read_packet_id(const char *what, std::uint16_t &id)
+{
+  std::error_code ec = verify(what, remaining_length, 2, std::error_code());
+  if (!ec)
+    {
+      auto payload_buffer = reinterpret_cast<uint8_t *>(buffer.consume_data());
+      id = (payload_buffer[0] << 8) + payload_buffer[1];
+    }
+  return ec;
+}
+
 std::error_code
 MqttClient::handle_publish_ack()
 {
-  std::error_code ec;
+  std::uint16_t id = 0;
+  std::error_code ec = read_packet_id("handle PubAck", id);
+  if (!ec)
+    {
+      MqttOutbox::Message m;
+      if (outbox.complete(id, 1, m))
+        {
+          unacknowledged--;
+          if (m.callback)
+            {
+              m.callback(std::error_code());
+            }
+          send_pending();
+        }
+      else
+        {
+          ESP_LOGW(tag, "Warning: PubAck for unknown packet %d", id);
+        }
+    }
   return ec;
 }
 
 std::error_code
 MqttClient::handle_publish_received()
 {
-  std::error_code ec;
+  std::uint16_t id = 0;
+  std::error_code ec = read_packet_id("handle PubRec", id);
+  if (!ec)
+    {
+      if (!outbox.received(id))
+        {
+          ESP_LOGW(tag, "Warning: PubRec for unknown packet %d", id);
+        }
+      // Release unknown ids too, so that the broker can discard them.
+      send_ack(PacketType::PubRel, id);
+    }
   return ec;
 }
 
 std::error_code
 MqttClient::handle_publish_release()
 {
-  std::error_code ec;
+  std::uint16_t id = 0;
+  std::error_code ec = read_packet_id("handle PubRel", id);
+  if (!ec)
+    {
+      inbound_pending.erase(id);
+      send_ack(PacketType::PubComp, id);
+    }
   return ec;
 }
 
 std::error_code
 MqttClient::handle_publish_complete()
 {
-  std::error_code ec;
+  std::uint16_t id = 0;
+  std::error_code ec = read_packet_id("handle PubComp", id);
+  if (!ec)
+    {
+      MqttOutbox::Message m;
+      if (outbox.complete(id, 2, m))
+        {
+          unacknowledged--;
+          if (m.callback)
+            {
+              m.callback(std::error_code());
+            }
+          send_pending();
+        }
+      else
+        {
+          ESP_LOGW(tag, "Warning: PubComp for unknown packet %d", id);
+        }
+    }
   return ec;
 }
 
@@ -735,6 +1039,7 @@ MqttClient::handle_error(const std::string &what, std::error_code ec)
     {
       ESP_LOGE(tag, "Error: %s %s", what.c_str(), ec.message().c_str());
       connected_property.set(false);
+      session_ready = false;
 
       if (ping_timer != 0)
         {
@@ -777,66 +1082,14 @@ MqttClient::connected()
   return connected_property;
 }
 
-bool
-MqttClient::match_topic(const std::string &topic, const std::string &filter)
-{
-  auto topic_it = topic.begin();
-  auto filter_it = filter.begin();
-
-  while (true)
-    {
-      if (filter_it == filter.end())
-        {
-          return topic_it == topic.end();
-        }
-
-      if (topic_it == topic.end()) // && filter_it != filter.end()
-        {
-          if (*filter_it == '/')
-            {
-              filter_it++;
-              if ((filter_it != filter.end()) && (*filter_it == '#'))
-                {
-                  return true;
-                }
-            }
-          return false;
-        }
-
-      if (*filter_it == '+')
-        {
-          while (*topic_it != '/' && topic_it < topic.end())
-            {
-              ++topic_it;
-            }
-          ++filter_it;
-        }
-
-      else if (*filter_it == '#')
-        {
-          return true;
-        }
-
-      else
-        {
-          if (*topic_it != *filter_it)
-            {
-              return false;
-            }
-          ++topic_it;
-          ++filter_it;
-        }
-    }
-}
-
 void
 MqttClient::add_filter(const std::string &filter, subscribe_callback_t callback)
 {
-  filters[filter] = std::move(callback);
+  filters.insert(filter, std::move(callback));
 }
 
 void
 MqttClient::remove_filter(const std::string &filter)
 {
-  filters.erase(filter);
+  filters.remove(filter);
 }
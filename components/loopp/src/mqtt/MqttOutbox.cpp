@@ -0,0 +1,153 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/mqtt/MqttOutbox.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::mqtt;
+
+MqttOutbox::MqttOutbox(std::size_t window)
+{
+  set_window(window);
+}
+
+void
+MqttOutbox::set_window(std::size_t window)
+{
+  // Packet ids are 16 bits and 0 is reserved.
+  if (window == 0 || window > 0xffff)
+    {
+      throw std::runtime_error("invalid MQTT in-flight window: " + std::to_string(window));
+    }
+  this->window = window;
+}
+
+std::size_t
+MqttOutbox::get_window() const
+{
+  return window;
+}
+
+void
+MqttOutbox::push(Message message)
+{
+  message.state = State::Queued;
+  message.id = 0;
+  queue.push_back(std::move(message));
+}
+
+MqttOutbox::Message *
+MqttOutbox::admit()
+{
+  if (queue.empty() || inflight.size() >= window)
+    {
+      return nullptr;
+    }
+
+  inflight.push_back(std::move(queue.front()));
+  queue.pop_front();
+
+  Message &m = inflight.back();
+  m.id = allocate_id();
+  m.state = m.qos == 2 ? State::AwaitRec : State::AwaitAck;
+  return &m;
+}
+
+MqttOutbox::Message *
+MqttOutbox::find(std::uint16_t id)
+{
+  auto it = std::find_if(inflight.begin(), inflight.end(), [id](const Message &m) { return m.id == id; });
+  return it != inflight.end() ? &*it : nullptr;
+}
+
+bool
+MqttOutbox::complete(std::uint16_t id, std::uint8_t qos, Message &message)
+{
+  State expected = qos == 2 ? State::AwaitComp : State::AwaitAck;
+  auto it = std::find_if(inflight.begin(), inflight.end(), [id, expected](const Message &m) { return m.id == id && m.state == expected; });
+  if (it == inflight.end())
+    {
+      return false;
+    }
+
+  message = std::move(*it);
+  inflight.erase(it);
+  return true;
+}
+
+bool
+MqttOutbox::received(std::uint16_t id)
+{
+  Message *m = find(id);
+  if (m == nullptr || m->qos != 2)
+    {
+      return false;
+    }
+
+  // A duplicate PUBREC after a retransmitted PUBREL is harmless.
+  m->state = State::AwaitComp;
+  return true;
+}
+
+std::uint16_t
+MqttOutbox::allocate_id()
+{
+  // The window is smaller than the id space, so this terminates.
+  while (true)
+    {
+      std::uint16_t id = next_id++;
+      if (next_id == 0)
+        {
+          next_id = 1;
+        }
+      if (find(id) == nullptr)
+        {
+          return id;
+        }
+    }
+}
+
+std::vector<MqttOutbox::Message>
+MqttOutbox::clear()
+{
+  std::vector<Message> messages;
+  messages.reserve(inflight.size() + queue.size());
+  std::move(inflight.begin(), inflight.end(), std::back_inserter(messages));
+  std::move(queue.begin(), queue.end(), std::back_inserter(messages));
+  inflight.clear();
+  queue.clear();
+  return messages;
+}
+
+std::size_t
+MqttOutbox::inflight_size() const
+{
+  return inflight.size();
+}
+
+std::size_t
+MqttOutbox::queued_size() const
+{
+  return queue.size();
+}
@@ -20,9 +20,13 @@
 
 #include "loopp/mqtt/MqttPacket.hpp"
 
+#include <cstring>
+
 using namespace loopp;
 using namespace loopp::mqtt;
 
+constexpr std::size_t MqttPublishHeader::inline_size;
+
 MqttPacket::MqttPacket()
   : stream(&buffer)
 {
@@ -85,3 +89,95 @@ MqttPacket::size() const noexcept
 {
   return buffer.consume_size();
 }
+
+MqttPublishHeader::MqttPublishHeader(const std::string &topic, std::uint8_t flags, std::uint16_t id, std::size_t payload_size)
+{
+  std::size_t id_size = id != 0 ? 2 : 0;
+  std::size_t remaining_length = 2 + topic.size() + id_size + payload_size;
+  std::size_t max_size = 1 + 4 + 2 + topic.size() + id_size;
+
+  std::uint8_t *p = inline_data.data();
+  if (max_size > inline_size)
+    {
+      overflow_data.resize(max_size);
+      p = overflow_data.data();
+    }
+
+  std::uint8_t *start = p;
+  *p++ = (static_cast<std::uint8_t>(PacketType::Publish) << 4) | (flags & 0x0f);
+  do
+    {
+      std::uint8_t b = remaining_length % 128;
+      remaining_length >>= 7;
+      if (remaining_length > 0)
+        {
+          b |= 128;
+        }
+      *p++ = b;
+    }
+  while (remaining_length > 0);
+
+  *p++ = static_cast<std::uint8_t>(topic.size() >> 8);
+  *p++ = static_cast<std::uint8_t>(topic.size() & 0xff);
+  std::memcpy(p, topic.data(), topic.size());
+  p += topic.size();
+
+  if (id_size > 0)
+    {
+      *p++ = static_cast<std::uint8_t>(id >> 8);
+      *p++ = static_cast<std::uint8_t>(id & 0xff);
+    }
+
+  length = p - start;
+}
+
+const std::uint8_t *
+MqttPublishHeader::data() const noexcept
+{
+  return overflow_data.empty() ? inline_data.data() : overflow_data.data();
+}
+
+std::size_t
+MqttPublishHeader::size() const noexcept
+{
+  return length;
+}
+
+MqttFrame::Status
+MqttFrame::decode(const std::uint8_t *data, std::size_t size, MqttFrame &frame)
+{
+  frame = MqttFrame();
+  if (size < 2)
+    {
+      return Status::Incomplete;
+    }
+
+  std::size_t length = 0;
+  std::size_t multiplier = 1;
+  std::size_t index = 1;
+  while (true)
+    {
+      if (index > 4)
+        {
+          return Status::Invalid;
+        }
+      if (index >= size)
+        {
+          return Status::Incomplete;
+        }
+
+      std::uint8_t b = data[index++];
+      length += (b & 0b01111111u) * multiplier;
+      multiplier *= 128;
+      if ((b & 0b10000000u) == 0u)
+        {
+          break;
+        }
+    }
+
+  frame.fixed_header = data[0];
+  frame.header_size = index;
+  frame.remaining_length = length;
+
+  return size >= frame.size() ? Status::Complete : Status::Incomplete;
+}
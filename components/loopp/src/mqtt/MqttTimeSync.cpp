@@ -0,0 +1,191 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/mqtt/MqttTimeSync.hpp"
+
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "loopp/utils/json.hpp"
+
+static const char *tag = "MQTT";
+
+using namespace loopp;
+using namespace loopp::mqtt;
+
+constexpr int MqttTimeSync::initial_fast_requests;
+constexpr int MqttTimeSync::fast_interval_ms;
+
+MqttTimeSync::MqttTimeSync(std::shared_ptr<loopp::core::MainLoop> loop, std::shared_ptr<MqttClient> mqtt, std::string request_topic, std::string response_topic)
+  : loop(std::move(loop))
+  , mqtt(std::move(mqtt))
+  , request_topic(std::move(request_topic))
+  , response_topic(std::move(response_topic))
+{
+}
+
+MqttTimeSync::~MqttTimeSync()
+{
+  stop();
+}
+
+void
+MqttTimeSync::set_interval(std::chrono::seconds interval)
+{
+  this->interval = interval;
+}
+
+void
+MqttTimeSync::start()
+{
+  stop();
+
+  // The filter runs synchronously while the MQTT client handles the
+  // response, so the receive time is not delayed by the main loop queue.
+  std::weak_ptr<MqttTimeSync> weak = shared_from_this();
+  mqtt->add_filter(response_topic, [weak](const std::string &topic, const std::string &payload) {
+    int64_t received = esp_timer_get_time();
+    auto self = weak.lock();
+    if (self)
+      {
+        self->on_response(payload, received);
+      }
+  });
+  mqtt->subscribe(response_topic);
+
+  fast_requests = initial_fast_requests;
+  send_request();
+}
+
+void
+MqttTimeSync::stop()
+{
+  if (request_timer != 0)
+    {
+      loop->cancel_timer(request_timer);
+      request_timer = 0;
+    }
+  request_pending = false;
+  mqtt->remove_filter(response_topic);
+}
+
+bool
+MqttTimeSync::is_synchronized() const
+{
+  return clock.is_synchronized();
+}
+
+int64_t
+MqttTimeSync::to_wall_clock(int64_t timestamp) const
+{
+  return to_wall_clock(this, timestamp);
+}
+
+int64_t
+MqttTimeSync::to_wall_clock(const MqttTimeSync *time_sync, int64_t timestamp)
+{
+  if (time_sync != nullptr && time_sync->clock.is_synchronized())
+    {
+      return time_sync->clock.to_reference(timestamp);
+    }
+
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  int64_t now = static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+  return now - (esp_timer_get_time() - timestamp);
+}
+
+const loopp::core::ClockSync &
+MqttTimeSync::get_clock() const
+{
+  return clock;
+}
+
+void
+MqttTimeSync::schedule_request()
+{
+  std::chrono::milliseconds delay = interval;
+  if (fast_requests > 0)
+    {
+      fast_requests--;
+      delay = std::chrono::milliseconds(fast_interval_ms);
+    }
+
+  auto self = shared_from_this();
+  request_timer = loop->add_timer(delay, [this, self]() {
+    request_timer = 0;
+    send_request();
+  });
+}
+
+void
+MqttTimeSync::send_request()
+{
+  try
+    {
+      if (mqtt->connected().get())
+        {
+          // An unanswered request is simply superseded; its late response
+          // no longer matches the request id.
+          request_id++;
+          request_pending = true;
+
+          nlohmann::json request;
+          request["id"] = request_id;
+          request["reply"] = response_topic;
+
+          request_time = esp_timer_get_time();
+          mqtt->publish(request_topic, request.dump());
+        }
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Failed to send time request: %s", e.what());
+    }
+
+  schedule_request();
+}
+
+void
+MqttTimeSync::on_response(const std::string &payload, int64_t received)
+{
+  try
+    {
+      auto response = nlohmann::json::parse(payload);
+      if (!request_pending || response.at("id").get<uint32_t>() != request_id)
+        {
+          return;
+        }
+      request_pending = false;
+
+      int64_t t2 = response.at("t2").get<int64_t>();
+      int64_t t3 = response.at("t3").get<int64_t>();
+      clock.add_sample(request_time, t2, t3, received);
+
+      ESP_LOGD(tag, "Time sync: offset %lld us, delay %lld us, drift %.2f ppm", static_cast<long long>(clock.get_offset(received)),
+               static_cast<long long>(clock.get_delay()), clock.get_drift_ppm());
+    }
+  catch (std::exception &e)
+    {
+      ESP_LOGE(tag, "Invalid time response: %s", e.what());
+    }
+}
@@ -0,0 +1,217 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "loopp/mqtt/MqttTopicTrie.hpp"
+
+#include <stdexcept>
+
+using namespace loopp;
+using namespace loopp::mqtt;
+
+namespace
+{
+  // Returns the end of the level that starts at 'pos'.
+  std::size_t level_end(const std::string &s, std::size_t pos)
+  {
+    std::size_t slash = s.find('/', pos);
+    return slash == std::string::npos ? s.size() : slash;
+  }
+} // namespace
+
+bool
+MqttTopicTrie::is_valid_filter(const std::string &filter)
+{
+  std::size_t pos = 0;
+  while (true)
+    {
+      std::size_t end = level_end(filter, pos);
+      std::string::size_type wildcard = filter.find_first_of("+#", pos);
+      if (wildcard < end)
+        {
+          // A wildcard must be the whole level, and '#' the last level.
+          if (end - pos != 1 || (filter[pos] == '#' && end != filter.size()))
+            {
+              return false;
+            }
+        }
+      if (end == filter.size())
+        {
+          return true;
+        }
+      pos = end + 1;
+    }
+}
+
+void
+MqttTopicTrie::insert(const std::string &filter, callback_t callback)
+{
+  if (!is_valid_filter(filter))
+    {
+      throw std::runtime_error("invalid topic filter: " + filter);
+    }
+
+  Node *node = &root;
+  std::size_t pos = 0;
+  while (true)
+    {
+      std::size_t end = level_end(filter, pos);
+      std::string name = filter.substr(pos, end - pos);
+
+      if (name == "#")
+        {
+          if (!node->multi_level_callback)
+            {
+              count++;
+            }
+          node->multi_level_callback = std::move(callback);
+          return;
+        }
+
+      std::unique_ptr<Node> &child = name == "+" ? node->single_level : node->children[name];
+      if (!child)
+        {
+          child.reset(new Node);
+        }
+      node = child.get();
+
+      if (end == filter.size())
+        {
+          break;
+        }
+      pos = end + 1;
+    }
+
+  if (!node->callback)
+    {
+      count++;
+    }
+  node->callback = std::move(callback);
+}
+
+bool
+MqttTopicTrie::remove(const std::string &filter)
+{
+  return remove(root, filter, 0, false);
+}
+
+bool
+MqttTopicTrie::remove(Node &node, const std::string &filter, std::size_t pos, bool end)
+{
+  if (end)
+    {
+      if (!node.callback)
+        {
+          return false;
+        }
+      node.callback = nullptr;
+      count--;
+      return true;
+    }
+
+  std::size_t next = level_end(filter, pos);
+  std::string name = filter.substr(pos, next - pos);
+  bool last = next == filter.size();
+
+  if (name == "#")
+    {
+      if (!last || !node.multi_level_callback)
+        {
+          return false;
+        }
+      node.multi_level_callback = nullptr;
+      count--;
+      return true;
+    }
+
+  bool removed = false;
+  if (name == "+")
+    {
+      if (node.single_level)
+        {
+          removed = remove(*node.single_level, filter, next + 1, last);
+          if (removed && node.single_level->empty())
+            {
+              node.single_level.reset();
+            }
+        }
+    }
+  else
+    {
+      auto it = node.children.find(name);
+      if (it != node.children.end())
+        {
+          removed = remove(*it->second, filter, next + 1, last);
+          if (removed && it->second->empty())
+            {
+              node.children.erase(it);
+            }
+        }
+    }
+  return removed;
+}
+
+void
+MqttTopicTrie::match(const std::string &topic, std::vector<callback_t> &callbacks) const
+{
+  match(root, topic, 0, false, callbacks);
+}
+
+void
+MqttTopicTrie::match(const Node &node, const std::string &topic, std::size_t pos, bool end, std::vector<callback_t> &callbacks) const
+{
+  if (node.multi_level_callback)
+    {
+      callbacks.push_back(node.multi_level_callback);
+    }
+
+  if (end)
+    {
+      if (node.callback)
+        {
+          callbacks.push_back(node.callback);
+        }
+      return;
+    }
+
+  std::size_t next = level_end(topic, pos);
+  bool last = next == topic.size();
+
+  if (!node.children.empty())
+    {
+      // Reuses the capacity of a single string for all lookups.
+      level.assign(topic, pos, next - pos);
+      auto it = node.children.find(level);
+      if (it != node.children.end())
+        {
+          match(*it->second, topic, next + 1, last, callbacks);
+        }
+    }
+
+  if (node.single_level)
+    {
+      match(*node.single_level, topic, next + 1, last, callbacks);
+    }
+}
+
+std::size_t
+MqttTopicTrie::size() const
+{
+  return count;
+}
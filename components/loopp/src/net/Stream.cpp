@@ -20,6 +20,7 @@
 
 #include "loopp/net/Stream.hpp"
 
+#include <algorithm>
 #include <string>
 #include <system_error>
 
@@ -175,12 +176,83 @@ Stream::write_async(StreamBuffer &buffer, const io_callback_t &callback)
     }
 }
 
+void
+Stream::write_async(std::vector<ConstBuffer> buffers, const io_callback_t &callback)
+{
+  if (!connected_property.get())
+    {
+      callback(NetworkErrc::ConnectionClosed, 0);
+    }
+  else
+    {
+      auto self = shared_from_this();
+
+      loop->invoke([this, self, buffers = std::move(buffers), callback]() {
+        write_op_queue.emplace_back(buffers, callback);
+        if (write_op_queue.size() == 1)
+          {
+            do_write_async();
+          }
+      });
+    }
+}
+
 void
 Stream::read_async(StreamBuffer &buffer, std::size_t count, const io_callback_t &callback)
 {
   do_read_async(buffer, count, 0, callback);
 }
 
+void
+Stream::read_some_async(StreamBuffer &buffer, std::size_t count, const io_callback_t &callback)
+{
+  auto self = shared_from_this();
+  std::error_code ec;
+
+  if (!connected_property.get())
+    {
+      ec = NetworkErrc::ConnectionClosed;
+    }
+  else
+    {
+      auto data = reinterpret_cast<uint8_t *>(buffer.produce_data(count));
+      int ret = socket_read(data, count);
+
+      if (ret > 0)
+        {
+          buffer.produce_commit(ret);
+          callback(ec, ret);
+          return;
+        }
+      else if (ret == 0)
+        {
+          ESP_LOGI(tag, "Connection closed");
+          connected_property.set(false);
+          ec = NetworkErrc::ConnectionClosed;
+        }
+      else if (ret == -EAGAIN)
+        {
+          loop->notify_read(sock, [this, self, &buffer, count, callback](std::error_code ec) {
+            if (!ec)
+              {
+                read_some_async(buffer, count, callback);
+              }
+            else
+              {
+                callback(ec, 0);
+              }
+          });
+          return;
+        }
+      else
+        {
+          ec = NetworkErrc::ReadError;
+        }
+    }
+
+  callback(ec, 0);
+}
+
 void
 Stream::read_until_async(StreamBuffer &buffer, const std::string &until, const io_callback_t &callback)
 {
@@ -195,11 +267,19 @@ Stream::do_write_async()
   std::error_code ec;
   do
     {
-      int ret = socket_write(reinterpret_cast<uint8_t *>(write_op.buffer().consume_data()), write_op.buffer().consume_size());
+      int ret = 0;
+      if (write_op.buffer() != nullptr)
+        {
+          ret = socket_write(reinterpret_cast<uint8_t *>(write_op.buffer()->consume_data()), write_op.buffer()->consume_size());
+        }
+      else
+        {
+          ret = socket_writev(write_op.buffers(), write_op.buffer_count());
+        }
 
       if (ret > 0)
         {
-          write_op.buffer().consume_commit(ret);
+          write_op.commit(ret);
         }
       else if (ret == -EAGAIN)
         {
@@ -211,13 +291,20 @@ Stream::do_write_async()
           ec = NetworkErrc::WriteError;
         }
     }
-  while (!ec && write_op.buffer().consume_size() > 0);
+  while (!ec && !write_op.done());
 
-  write_op.call(ec, write_op.buffer().consume_size());
+  write_op.call(ec, write_op.result());
   write_op_queue.pop_front();
   do_wait_write_async();
 }
 
+int
+Stream::socket_writev(const ConstBuffer *buffers, std::size_t count)
+{
+  (void)count;
+  return socket_write(const_cast<uint8_t *>(buffers[0].data), buffers[0].size);
+}
+
 void
 Stream::do_wait_write_async()
 {
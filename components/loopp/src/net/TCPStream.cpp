@@ -20,6 +20,7 @@
 
 #include "loopp/net/TCPStream.hpp"
 
+#include <algorithm>
 #include <string>
 
 #include "lwip/sockets.h"
@@ -28,6 +29,8 @@
 using namespace loopp;
 using namespace loopp::net;
 
+constexpr std::size_t TCPStream::max_iov;
+
 TCPStream::TCPStream(std::shared_ptr<loopp::core::MainLoop> loop)
   : Stream(std::move(loop))
 {
@@ -59,6 +62,27 @@ TCPStream::socket_write(uint8_t *buffer, std::size_t count)
   return ret;
 }
 
+int
+TCPStream::socket_writev(const ConstBuffer *buffers, std::size_t count)
+{
+  struct iovec iov[max_iov];
+  int iovcnt = static_cast<int>(std::min(count, max_iov));
+  for (int i = 0; i < iovcnt; i++)
+    {
+      iov[i].iov_base = const_cast<uint8_t *>(buffers[i].data);
+      iov[i].iov_len = buffers[i].size;
+    }
+
+  int ret = writev(get_socket(), iov, iovcnt);
+
+  if (ret == -1)
+    {
+      ret = -errno;
+    }
+
+  return ret;
+}
+
 void
 TCPStream::socket_close()
 {
@@ -40,6 +40,7 @@ extern "C"
 }
 
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char *tag = "NET";
 
@@ -169,12 +170,24 @@ TLSStream::socket_close()
 }
 
 void
-TLSStream::socket_on_connected(const std::string &host, const connect_callback_t &callback)
+TLSStream::socket_on_connected(const std::string &host, const connect_callback_t &connected_callback)
 {
   ESP_LOGD(tag, "Connected. Starting handshake");
 
   server_fd.fd = get_socket();
 
+  // The handshake is a burst of round trips that suffers most from sharing
+  // the radio with the BLE scanner. Pause scanning until it completes.
+  int64_t start = esp_timer_get_time();
+  radio_lease = loopp::core::RadioCoordinator::instance().request(loopp::core::RadioCoordinator::Mode::Paused,
+                                                                  std::chrono::milliseconds(3000),
+                                                                  "tls");
+  connect_callback_t callback = [this, start, connected_callback](std::error_code ec) {
+    radio_lease.release();
+    ESP_LOGI(tag, "TLS handshake %s after %d ms", ec ? "failed" : "done", static_cast<int>((esp_timer_get_time() - start) / 1000));
+    connected_callback(ec);
+  };
+
   try
     {
       int ret = mbedtls_ssl_set_hostname(&ssl, host.c_str());
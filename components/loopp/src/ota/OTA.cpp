@@ -27,6 +27,7 @@
 
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "loopp/ota/OTAErrors.hpp"
 
@@ -73,6 +74,12 @@ OTA::upgrade_async(const std::string &url, std::chrono::seconds timeout_duration
   try
     {
       this->callback = callback;
+      start_time = esp_timer_get_time();
+
+      // Scan with a reduced window while downloading. A pause would exceed
+      // the pause budget long before the download completes.
+      std::chrono::milliseconds max_duration = timeout_duration != std::chrono::seconds(0) ? timeout_duration : std::chrono::minutes(5);
+      radio_lease = loopp::core::RadioCoordinator::instance().request(loopp::core::RadioCoordinator::Mode::Reduced, max_duration, "ota");
 
       if (timeout_duration != std::chrono::seconds(0))
         {
@@ -99,7 +106,7 @@ OTA::upgrade_async(const std::string &url, std::chrono::seconds timeout_duration
   catch (const std::system_error &ex)
     {
       ESP_LOGD(tag, "upgrade_async exception %d %s", ex.code().value(), ex.what());
-      callback(ex.code());
+      finish(ex.code());
     }
 }
 
@@ -111,7 +118,7 @@ OTA::on_http_response(std::error_code ec, const loopp::http::Response &response)
       ESP_LOGI(tag, "Status %03d: %s", response.status_code(), response.status_message().c_str());
       if (response.status_code() != 200)
         {
-          this->callback(OTAErrc::InternalError);
+          finish(OTAErrc::InternalError);
         }
       else
         {
@@ -122,7 +129,7 @@ OTA::on_http_response(std::error_code ec, const loopp::http::Response &response)
   else
     {
       ESP_LOGE(tag, "Failed to request firmware");
-      this->callback(ec);
+      finish(ec);
     }
 }
 
@@ -159,17 +166,25 @@ OTA::retrieve_body()
                                 else
                                   {
                                     ESP_LOGD(tag, "OTA ready");
-                                    callback(std::error_code());
+                                    finish(std::error_code());
                                   }
                               }
                             catch (const std::system_error &ex)
                               {
                                 ESP_LOGE(tag, "upgrade_async exception %d %s", ex.code().value(), ex.what());
-                                callback(ex.code());
+                                finish(ex.code());
                               }
                           }));
 }
 
+void
+OTA::finish(std::error_code ec)
+{
+  radio_lease.release();
+  ESP_LOGI(tag, "Download %s after %d ms", ec ? "failed" : "done", static_cast<int>((esp_timer_get_time() - start_time) / 1000));
+  callback(ec);
+}
+
 void
 OTA::commit()
 {
@@ -0,0 +1,117 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "unity.h"
+
+#include "loopp/ble/AdaptiveScanController.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::AdaptiveScanController;
+
+namespace
+{
+  AdaptiveScanController::Observation observe(float ambient_rate, float duplicate_ratio, const AdaptiveScanController &controller)
+  {
+    AdaptiveScanController::Observation observation;
+    observation.adv_rate = ambient_rate * controller.get_duty_cycle();
+    observation.duplicate_ratio = duplicate_ratio;
+    return observation;
+  }
+} // namespace
+
+TEST_CASE("Adaptive scan backs off in a quiet area", "[ble]")
+{
+  AdaptiveScanController controller(json::object());
+  TEST_ASSERT_EQUAL(80, controller.get_decision().scan_interval);
+  TEST_ASSERT_EQUAL(80, controller.get_decision().scan_window);
+
+  for (int i = 0; i < 20; i++)
+    {
+      controller.update(observe(1.0f, 0.0f, controller));
+    }
+
+  TEST_ASSERT_TRUE(controller.get_state() == AdaptiveScanController::State::Quiet);
+  TEST_ASSERT_EQUAL(800, controller.get_decision().scan_interval);
+  TEST_ASSERT_EQUAL(80, controller.get_decision().scan_window);
+  TEST_ASSERT_EQUAL(10000, controller.get_decision().publish_period);
+  // The estimate is corrected for the reduced duty cycle.
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 1.0f, controller.get_ambient_rate());
+}
+
+TEST_CASE("Adaptive scan wakes up when new devices appear", "[ble]")
+{
+  AdaptiveScanController controller(json::object());
+  for (int i = 0; i < 20; i++)
+    {
+      controller.update(observe(1.0f, 0.0f, controller));
+    }
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.1f, controller.get_duty_cycle());
+
+  int restarts = 0;
+  for (int i = 0; i < 10; i++)
+    {
+      restarts += controller.update(observe(200.0f, 0.2f, controller)) ? 1 : 0;
+    }
+  TEST_ASSERT_TRUE(controller.get_state() == AdaptiveScanController::State::Discovering);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, controller.get_duty_cycle());
+  TEST_ASSERT_LESS_THAN(6, restarts);
+  // About 100 records per batch at 200 adv/s.
+  TEST_ASSERT_EQUAL(1000, controller.get_decision().publish_period);
+}
+
+TEST_CASE("Adaptive scan keeps its parameters in a steady area", "[ble]")
+{
+  AdaptiveScanController controller(json::parse(R"({ "min_period": 100 })"));
+  controller.update(observe(50.0f, 0.7f, controller));
+  for (int i = 0; i < 10; i++)
+    {
+      TEST_ASSERT_FALSE(controller.update(observe(50.0f, 0.7f, controller)));
+    }
+  TEST_ASSERT_TRUE(controller.get_state() == AdaptiveScanController::State::Steady);
+  TEST_ASSERT_EQUAL(2000, controller.get_decision().publish_period);
+}
+
+TEST_CASE("Adaptive scan reduces load while the uplink is congested", "[ble]")
+{
+  AdaptiveScanController controller(json::parse(R"({ "max_backlog": 1000 })"));
+  AdaptiveScanController::Observation observation = observe(500.0f, 0.7f, controller);
+  controller.update(observation);
+  uint32_t period = controller.get_decision().publish_period;
+
+  observation.send_backlog = 5000;
+  TEST_ASSERT_TRUE(controller.update(observation));
+  TEST_ASSERT_TRUE(controller.get_state() == AdaptiveScanController::State::Congested);
+  TEST_ASSERT_EQUAL(2 * period, controller.get_decision().publish_period);
+  TEST_ASSERT_TRUE(controller.get_duty_cycle() < 0.6f);
+}
+
+TEST_CASE("Adaptive scan rejects invalid bounds", "[ble]")
+{
+  bool thrown = false;
+  try
+    {
+      AdaptiveScanController controller(json::parse(R"({ "min_duty": 0.5, "max_duty": 0.2 })"));
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+}
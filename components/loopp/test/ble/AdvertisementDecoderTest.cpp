@@ -0,0 +1,173 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "unity.h"
+
+#include "esp_timer.h"
+
+#include "TestUtils.hpp"
+
+#include "loopp/ble/AdStructure.hpp"
+#include "loopp/ble/AdvertisementDecoder.hpp"
+
+using json = nlohmann::json;
+using loopp::test::from_hex;
+
+// Representative advertisements as seen by a scanner in an office environment.
+static const char *corpus[] = {
+  "0201061aff4c000215e2c56db5dffb48d2b060d0f5a71096e000010002c5", // iBeacon
+  "02011a0aff4c001005011c1c4d3b",                                 // Apple Nearby (phone)
+  "12ff0600010920020b5a3f4a1e6c2d0a9b1c7e",                       // Microsoft CDP
+  "0201060303aafe1716aafe00eb8b0ca750e7a74e14bd990000000000010000", // Eddystone-UID
+  "020106050954657374020a04",                                     // Local name + TX power
+  "0201061aff4c000215e2c56d",                                     // Truncated iBeacon
+  "020106000000",                                                 // Zero padded
+  "0201060303aafe0e16aafe10eb016578616d706c6507",                 // Eddystone-URL
+  "0201060303aafe1116aafe20000bb81880000004d200008ca0",           // Eddystone-TLM
+  "0201061bff1801beace2c56db5dffb48d2b060d0f5a71096e000050007bc00", // AltBeacon
+};
+
+static std::vector<loopp::ble::AdStructure>
+parse(const std::string &adv_data)
+{
+  std::vector<loopp::ble::AdStructure> ads;
+  for (const auto &ad : loopp::ble::AdParser(adv_data))
+    {
+      ads.push_back(ad);
+    }
+  return ads;
+}
+
+TEST_CASE("AD parser walks all structures", "[ble]")
+{
+  std::string adv = from_hex(corpus[0]);
+  auto ads = parse(adv);
+
+  TEST_ASSERT_EQUAL(2, ads.size());
+  TEST_ASSERT(ads[0].is(loopp::ble::AdType::Flags));
+  TEST_ASSERT_EQUAL(1, ads[0].size);
+  TEST_ASSERT(ads[1].is(loopp::ble::AdType::ManufacturerSpecific));
+  TEST_ASSERT_EQUAL(25, ads[1].size);
+  TEST_ASSERT(ads[1].data == reinterpret_cast<const uint8_t *>(adv.data()) + 5);
+}
+
+TEST_CASE("AD parser stops at truncated structure and padding", "[ble]")
+{
+  auto truncated = parse(from_hex(corpus[5]));
+  TEST_ASSERT_EQUAL(1, truncated.size());
+
+  auto padded = parse(from_hex(corpus[6]));
+  TEST_ASSERT_EQUAL(1, padded.size());
+
+  auto empty = parse(std::string());
+  TEST_ASSERT_EQUAL(0, empty.size());
+}
+
+TEST_CASE("iBeacon decoder only matches iBeacon frames", "[ble]")
+{
+  loopp::ble::AdvertisementDecoder decoder;
+
+  json info;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(corpus[0]), info));
+  TEST_ASSERT_EQUAL_STRING("e2c56db5-dffb-48d2-b060-d0f5a71096e0", info["ibeacon"]["uuid"].get<std::string>().c_str());
+  TEST_ASSERT_EQUAL(1, info["ibeacon"]["major"].get<int>());
+  TEST_ASSERT_EQUAL(2, info["ibeacon"]["minor"].get<int>());
+  TEST_ASSERT_EQUAL(-59, info["ibeacon"]["power"].get<int>());
+
+  for (std::size_t i = 1; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+    {
+      json other;
+      decoder.decode(from_hex(corpus[i]), other);
+      TEST_ASSERT(other.find("ibeacon") == other.end());
+    }
+
+  json unrecognized;
+  TEST_ASSERT_FALSE(decoder.decode(from_hex(corpus[1]), unrecognized));
+}
+
+TEST_CASE("Eddystone frames are decoded", "[ble]")
+{
+  loopp::ble::AdvertisementDecoder decoder;
+
+  json uid;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(corpus[3]), uid));
+  TEST_ASSERT_EQUAL_STRING("uid", uid["eddystone"]["frame"].get<std::string>().c_str());
+  TEST_ASSERT_EQUAL_STRING("8b0ca750e7a74e14bd99", uid["eddystone"]["namespace"].get<std::string>().c_str());
+  TEST_ASSERT_EQUAL_STRING("000000000001", uid["eddystone"]["instance"].get<std::string>().c_str());
+  TEST_ASSERT_EQUAL(-21, uid["eddystone"]["power"].get<int>());
+
+  json url;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(corpus[7]), url));
+  TEST_ASSERT_EQUAL_STRING("https://www.example.com", url["eddystone"]["url"].get<std::string>().c_str());
+
+  json tlm;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(corpus[8]), tlm));
+  TEST_ASSERT_EQUAL(3000, tlm["eddystone"]["battery"].get<int>());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 24.5, tlm["eddystone"]["temperature"].get<double>());
+  TEST_ASSERT_EQUAL(1234, tlm["eddystone"]["adv_count"].get<int>());
+  TEST_ASSERT_EQUAL(3600, tlm["eddystone"]["uptime"].get<int>());
+}
+
+TEST_CASE("AltBeacon frames are decoded", "[ble]")
+{
+  loopp::ble::AdvertisementDecoder decoder;
+
+  json info;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(corpus[9]), info));
+  TEST_ASSERT_EQUAL(0x0118, info["altbeacon"]["company_id"].get<int>());
+  TEST_ASSERT_EQUAL_STRING("e2c56db5-dffb-48d2-b060-d0f5a71096e0", info["altbeacon"]["uuid"].get<std::string>().c_str());
+  TEST_ASSERT_EQUAL(5, info["altbeacon"]["major"].get<int>());
+  TEST_ASSERT_EQUAL(7, info["altbeacon"]["minor"].get<int>());
+  TEST_ASSERT_EQUAL(-68, info["altbeacon"]["power"].get<int>());
+}
+
+TEST_CASE("Advertisement decode throughput", "[ble][benchmark]")
+{
+  const int iterations = 1000;
+  const int corpus_size = sizeof(corpus) / sizeof(corpus[0]);
+
+  loopp::ble::AdvertisementDecoder decoder;
+  std::vector<std::string> advs;
+  for (int i = 0; i < corpus_size; i++)
+    {
+      advs.push_back(from_hex(corpus[i]));
+    }
+
+  int recognized = 0;
+  int64_t start = esp_timer_get_time();
+  for (int n = 0; n < iterations; n++)
+    {
+      for (const auto &adv : advs)
+        {
+          json info;
+          recognized += decoder.decode(adv, info) ? 1 : 0;
+        }
+    }
+  int64_t duration = esp_timer_get_time() - start;
+
+  int decoded = iterations * corpus_size;
+  std::cout << "Decoded " << decoded << " advertisements in " << duration << " us ("
+            << (decoded * 1000000LL / (duration > 0 ? duration : 1)) << " adv/s)" << std::endl;
+  TEST_ASSERT_EQUAL(5 * iterations, recognized);
+}
@@ -0,0 +1,134 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <map>
+#include <random>
+
+#include "unity.h"
+
+#include "loopp/ble/DeviceTable.hpp"
+#include "loopp/ble/LoadGenerator.hpp"
+
+using json = nlohmann::json;
+using Table = loopp::ble::DeviceTable<int>;
+
+TEST_CASE("Device table matches a map under random inserts and erases", "[ble]")
+{
+  Table table(64);
+  std::map<std::uint64_t, int> reference;
+  std::mt19937 rng(7);
+  auto now = Table::clock::now();
+
+  for (int i = 0; i < 20000; i++)
+    {
+      uint8_t bda[6] = { 0xc0, 0, 0, 0, 0, static_cast<uint8_t>(rng() % 48) };
+      std::uint64_t key = Table::make_key(bda);
+      if (rng() % 3 == 0)
+        {
+          table.erase(bda);
+          reference.erase(key);
+        }
+      else
+        {
+          int *value = table.insert(bda, now);
+          TEST_ASSERT_NOT_NULL(value);
+          *value = i;
+          reference[key] = i;
+        }
+      TEST_ASSERT_EQUAL(reference.size(), table.size());
+    }
+
+  table.for_each([&reference](std::uint64_t key, int &value) { TEST_ASSERT_EQUAL(reference[key], value); });
+  TEST_ASSERT_EQUAL(0, table.get_stats().evictions);
+}
+
+TEST_CASE("Device table keys include the address type", "[ble]")
+{
+  Table table(8);
+  auto now = Table::clock::now();
+  uint8_t bda[6] = { 0x40, 1, 2, 3, 4, 5 };
+
+  bool created = false;
+  table.insert(bda, now, &created, loopp::ble::AddressType::Public);
+  TEST_ASSERT_TRUE(created);
+  table.insert(bda, now, &created, loopp::ble::AddressType::Random);
+  TEST_ASSERT_TRUE(created);
+  TEST_ASSERT_EQUAL(2, table.size());
+  TEST_ASSERT_EQUAL(1, table.private_size());
+
+  uint8_t static_bda[6] = { 0xc0, 1, 2, 3, 4, 5 };
+  TEST_ASSERT_FALSE(Table::is_private(static_bda, loopp::ble::AddressType::Random));
+  TEST_ASSERT_TRUE(Table::is_private(bda, loopp::ble::AddressType::Random));
+}
+
+TEST_CASE("Device table soak with 10k rotating devices", "[ble][soak]")
+{
+  // 50 stationary iBeacons amid 10000 phones rotating their address every
+  // two minutes, for 10 simulated minutes.
+  loopp::ble::LoadGenerator generator(json::parse(R"({
+    "seed": 3,
+    "ibeacons": { "count": 50, "interval_ms": 1000 },
+    "phones": { "count": 10000, "interval_ms": 2000, "rotate_s": 120 }
+  })"));
+
+  const std::size_t capacity = 256;
+  Table table(capacity);
+  table.set_private_limit(capacity / 2);
+
+  const int64_t duration = 10 * 60 * 1000000LL;
+  auto epoch = Table::clock::now();
+  generator.start(0);
+
+  std::map<std::uint64_t, int> beacon_inserts;
+  loopp::ble::BLEScanner::ScanResult result;
+  std::uint64_t advertisements = 0;
+  std::size_t max_size = 0;
+
+  while (generator.next_time() < duration)
+    {
+      generator.next(result);
+      advertisements++;
+
+      auto type = static_cast<loopp::ble::AddressType>(result.ble_addr_type);
+      auto now = epoch + std::chrono::microseconds(result.timestamp);
+      bool created = false;
+      TEST_ASSERT_NOT_NULL(table.insert(result.bda, now, &created, type));
+      if (created && type == loopp::ble::AddressType::Public)
+        {
+          beacon_inserts[Table::make_key(result.bda)]++;
+        }
+      max_size = std::max(max_size, table.size());
+    }
+
+  const auto &stats = table.get_stats();
+  std::cout << advertisements << " advertisements, " << stats.inserts << " inserts, " << stats.evictions << " evictions ("
+            << stats.evictions * 1000000LL / duration << "/s, " << stats.private_evictions << " private)" << std::endl;
+
+  TEST_ASSERT_EQUAL(50 + capacity / 2, max_size);
+  TEST_ASSERT_EQUAL(capacity / 2, table.private_size());
+  // Every beacon was inserted once and never evicted by the crowd.
+  TEST_ASSERT_EQUAL(50, beacon_inserts.size());
+  for (const auto &kv : beacon_inserts)
+    {
+      TEST_ASSERT_EQUAL(1, kv.second);
+    }
+  TEST_ASSERT_EQUAL(stats.evictions, stats.private_evictions);
+}
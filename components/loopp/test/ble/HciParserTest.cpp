@@ -0,0 +1,235 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "unity.h"
+#include "esp_timer.h"
+
+#include "loopp/ble/HciParser.hpp"
+#include "loopp/ble/HciReader.hpp"
+
+using loopp::ble::BLEScanner;
+using loopp::ble::HciParser;
+
+namespace
+{
+  const uint8_t address[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+  const uint8_t adv_data[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0xaa, 0xfe };
+
+  // H4 LE Advertising Report event with 'count' reports.
+  std::vector<uint8_t> legacy_report(int count, int8_t rssi)
+  {
+    std::vector<uint8_t> params = { 0x02, static_cast<uint8_t>(count) };
+    for (int i = 0; i < count; i++)
+      {
+        params.push_back(0x00);
+        params.push_back(0x01);
+        for (int j = 5; j >= 0; j--)
+          {
+            params.push_back(static_cast<uint8_t>(address[j] + i));
+          }
+        params.push_back(sizeof(adv_data));
+        params.insert(params.end(), adv_data, adv_data + sizeof(adv_data));
+        params.push_back(static_cast<uint8_t>(rssi));
+      }
+
+    std::vector<uint8_t> packet = { 0x04, 0x3e, static_cast<uint8_t>(params.size()) };
+    packet.insert(packet.end(), params.begin(), params.end());
+    return packet;
+  }
+
+  std::vector<uint8_t> extended_report(uint16_t event_type, int8_t rssi)
+  {
+    std::vector<uint8_t> params = { 0x0d, 1, static_cast<uint8_t>(event_type), static_cast<uint8_t>(event_type >> 8), 0x00 };
+    for (int j = 5; j >= 0; j--)
+      {
+        params.push_back(address[j]);
+      }
+    const uint8_t rest[] = { 0x01, 0x00, 0xff, 0x7f, static_cast<uint8_t>(rssi), 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    params.insert(params.end(), rest, rest + sizeof(rest));
+    params.push_back(sizeof(adv_data));
+    params.insert(params.end(), adv_data, adv_data + sizeof(adv_data));
+
+    std::vector<uint8_t> packet = { 0x04, 0x3e, static_cast<uint8_t>(params.size()) };
+    packet.insert(packet.end(), params.begin(), params.end());
+    return packet;
+  }
+
+  void append(std::vector<uint8_t> &stream, const std::vector<uint8_t> &packet)
+  {
+    stream.insert(stream.end(), packet.begin(), packet.end());
+  }
+} // namespace
+
+TEST_CASE("HCI parser extracts advertising reports", "[ble]")
+{
+  std::vector<uint8_t> stream;
+  // Command complete event and an ACL packet in between are skipped.
+  append(stream, { 0x04, 0x0e, 0x04, 0x01, 0x0c, 0x20, 0x00 });
+  append(stream, legacy_report(2, -70));
+  append(stream, { 0x02, 0x40, 0x00, 0x02, 0x00, 0xaa, 0xbb });
+  append(stream, extended_report(0x0013, -50));
+
+  HciParser parser;
+  std::vector<BLEScanner::ScanResult> results;
+  parser.feed(stream.data(), stream.size(), 1234, results);
+
+  TEST_ASSERT_EQUAL(3, results.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(address, results[0].bda, 6);
+  TEST_ASSERT_EQUAL(0x67, results[1].bda[5]);
+  TEST_ASSERT_EQUAL(1, results[0].ble_addr_type);
+  TEST_ASSERT_EQUAL(-70, results[0].rssi);
+  TEST_ASSERT_EQUAL(1234, results[0].timestamp);
+  TEST_ASSERT_TRUE(results[0].adv_data == std::string(reinterpret_cast<const char *>(adv_data), sizeof(adv_data)));
+  TEST_ASSERT_EQUAL(-50, results[2].rssi);
+  TEST_ASSERT_EQUAL(0, results[2].ble_addr_type);
+
+  TEST_ASSERT_EQUAL(4, parser.get_stats().packets);
+  TEST_ASSERT_EQUAL(3, parser.get_stats().reports);
+  TEST_ASSERT_EQUAL(0, parser.get_stats().malformed);
+}
+
+TEST_CASE("HCI parser reassembles packets split across chunks", "[ble]")
+{
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < 10; i++)
+    {
+      append(stream, legacy_report(3, static_cast<int8_t>(-40 - i)));
+    }
+
+  HciParser parser;
+  std::vector<BLEScanner::ScanResult> results;
+  for (std::size_t pos = 0; pos < stream.size(); pos += 7)
+    {
+      parser.feed(stream.data() + pos, std::min<std::size_t>(7, stream.size() - pos), 0, results);
+    }
+
+  TEST_ASSERT_EQUAL(30, results.size());
+  TEST_ASSERT_EQUAL(-49, results[29].rssi);
+}
+
+TEST_CASE("HCI parser resynchronizes and rejects malformed events", "[ble]")
+{
+  std::vector<uint8_t> stream = { 0xff, 0x00 };
+  append(stream, legacy_report(1, -60));
+
+  // Claims two reports but only carries one.
+  std::vector<uint8_t> truncated = legacy_report(1, -60);
+  truncated[4] = 2;
+  append(stream, truncated);
+
+  // Chained fragment of an extended advertisement.
+  append(stream, extended_report(0x0020, -60));
+
+  HciParser parser;
+  std::vector<BLEScanner::ScanResult> results;
+  parser.feed(stream.data(), stream.size(), 0, results);
+
+  TEST_ASSERT_EQUAL(1, results.size());
+  TEST_ASSERT_EQUAL(2, parser.get_stats().resyncs);
+  TEST_ASSERT_EQUAL(1, parser.get_stats().malformed);
+}
+
+#ifdef __linux__
+TEST_CASE("HCI reader reads btsnoop captures", "[ble]")
+{
+  char path[] = "/tmp/hci-XXXXXX";
+  int fd = mkstemp(path);
+  TEST_ASSERT_TRUE(fd >= 0);
+
+  std::vector<uint8_t> file = { 'b', 't', 's', 'n', 'o', 'o', 'p', 0, 0, 0, 0, 1, 0, 0, 0x03, 0xea };
+  for (int i = 0; i < 3; i++)
+    {
+      std::vector<uint8_t> packet = legacy_report(1, -60);
+      uint32_t length = static_cast<uint32_t>(packet.size());
+      uint32_t flags = 3;
+      uint64_t timestamp = 0x00dcddb30f2f8000ULL + i * 1000;
+      uint8_t header[24] = {};
+      for (int b = 0; b < 4; b++)
+        {
+          header[3 - b] = static_cast<uint8_t>(length >> (8 * b));
+          header[7 - b] = static_cast<uint8_t>(length >> (8 * b));
+          header[11 - b] = static_cast<uint8_t>(flags >> (8 * b));
+        }
+      for (int b = 0; b < 8; b++)
+        {
+          header[23 - b] = static_cast<uint8_t>(timestamp >> (8 * b));
+        }
+      file.insert(file.end(), header, header + sizeof(header));
+      file.insert(file.end(), packet.begin(), packet.end());
+    }
+  TEST_ASSERT_EQUAL(static_cast<ssize_t>(file.size()), write(fd, file.data(), file.size()));
+  close(fd);
+
+  loopp::ble::HciReader reader(path);
+  BLEScanner::ScanResult result;
+  int count = 0;
+  int64_t first = 0;
+  while (reader.next(result))
+    {
+      if (count == 0)
+        {
+          first = result.timestamp;
+        }
+      count++;
+    }
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL(2000, result.timestamp - first);
+
+  reader.rewind();
+  TEST_ASSERT_TRUE(reader.next(result));
+  unlink(path);
+}
+#endif
+
+TEST_CASE("HCI parser throughput", "[ble][benchmark]")
+{
+  const int events = 2000;
+  std::vector<uint8_t> stream;
+  for (int i = 0; i < events; i++)
+    {
+      append(stream, legacy_report(4, -60));
+    }
+
+  HciParser parser;
+  std::vector<BLEScanner::ScanResult> results;
+  results.reserve(events * 4);
+
+  int64_t start = esp_timer_get_time();
+  // Feed in UART sized chunks.
+  for (std::size_t pos = 0; pos < stream.size(); pos += 256)
+    {
+      parser.feed(stream.data() + pos, std::min<std::size_t>(256, stream.size() - pos), 0, results);
+    }
+  int64_t elapsed = std::max<int64_t>(esp_timer_get_time() - start, 1);
+
+  TEST_ASSERT_EQUAL(events * 4, results.size());
+  printf("HCI parser: %d adv/s, %d KB/s\n", static_cast<int>(results.size() * 1000000LL / elapsed),
+         static_cast<int>(stream.size() * 1000000LL / 1024 / elapsed));
+}
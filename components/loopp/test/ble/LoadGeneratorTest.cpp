@@ -0,0 +1,115 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <iostream>
+#include <set>
+#include <string>
+
+#include "unity.h"
+#include "esp_timer.h"
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/ble/LoadGenerator.hpp"
+
+using json = nlohmann::json;
+
+static json
+crowd_config()
+{
+  return json::parse(R"({
+    "seed": 42,
+    "ibeacons": { "count": 50, "interval_ms": 100 },
+    "phones": { "count": 100, "interval_ms": 250, "rotate_s": 60 },
+    "crowds": { "count": 200, "interval_ms": 200, "period_s": 60, "duration_s": 10 }
+  })");
+}
+
+TEST_CASE("Load generator produces the configured population", "[ble]")
+{
+  const int64_t duration = 120 * 1000000LL;
+
+  loopp::ble::LoadGenerator generator(crowd_config());
+  TEST_ASSERT_EQUAL(350, generator.get_device_count());
+  generator.start(0);
+
+  std::set<std::uint64_t> ibeacons;
+  std::set<std::uint64_t> others;
+  loopp::ble::BLEScanner::ScanResult result;
+  int64_t last = 0;
+  int count = 0;
+  bool ordered = true;
+  bool rssi_in_range = true;
+
+  while (generator.next_time() < duration)
+    {
+      generator.next(result);
+      count++;
+      ordered = ordered && result.timestamp >= last;
+      rssi_in_range = rssi_in_range && result.rssi <= -20 && result.rssi >= -100;
+      last = result.timestamp;
+
+      std::uint64_t key = 0;
+      for (int i = 0; i < 6; i++)
+        {
+          key = (key << 8) | result.bda[i];
+        }
+      (result.bda[0] == 0xc0 ? ibeacons : others).insert(key);
+    }
+
+  double expected = generator.get_nominal_rate() * 120.0;
+  std::cout << "Generated " << count << " advertisements (nominal " << static_cast<int>(expected) << "), " << ibeacons.size() << " iBeacons, "
+            << others.size() << " random addresses" << std::endl;
+
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_TRUE(rssi_in_range);
+  TEST_ASSERT_FLOAT_WITHIN(expected * 0.05, expected, static_cast<double>(count));
+  TEST_ASSERT_EQUAL(50, ibeacons.size());
+  // 100 phones rotate twice in 120 s; 200 crowd devices appear twice.
+  TEST_ASSERT_GREATER_OR_EQUAL(650, others.size());
+}
+
+TEST_CASE("Load generator decode and encode throughput", "[ble][benchmark]")
+{
+  loopp::ble::LoadGenerator generator(crowd_config());
+  generator.start(0);
+
+  std::vector<loopp::ble::BLEScanner::ScanResult> results(20000);
+  for (auto &result : results)
+    {
+      generator.next(result);
+    }
+
+  loopp::ble::AdvertisementDecoder decoder;
+  std::size_t bytes = 0;
+  int64_t start = esp_timer_get_time();
+  for (const auto &result : results)
+    {
+      json jb;
+      jb["rssi"] = result.rssi;
+      jb["dt"] = result.timestamp;
+      decoder.decode(result.adv_data, jb);
+      bytes += jb.dump().size();
+    }
+  int64_t elapsed = esp_timer_get_time() - start;
+
+  std::cout << "Decoded and encoded " << results.size() << " advertisements (" << bytes << " bytes) in " << elapsed << " us ("
+            << (results.size() * 1000000LL / (elapsed > 0 ? elapsed : 1)) << " adv/s)" << std::endl;
+  TEST_ASSERT_GREATER_THAN(0, static_cast<int>(bytes));
+}
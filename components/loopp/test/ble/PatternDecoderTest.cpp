@@ -0,0 +1,174 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "unity.h"
+
+#include "esp_timer.h"
+
+#include "TestUtils.hpp"
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/ble/PatternDecoder.hpp"
+
+using json = nlohmann::json;
+using loopp::test::from_hex;
+
+static const char *ruuvi_adv = "0201061bff99040512fc5394c37c0004fffc040cac364200cdcbb8334c884f";
+static const char *atc_adv = "02010610161a18a4c138aabbcc00f530570b8611";
+
+static json
+site_decoders()
+{
+  return json::parse(R"([
+    {
+      "name": "ruuvi",
+      "company_id": 1177,
+      "match": [ { "offset": 0, "value": "05" } ],
+      "fields": [
+        { "name": "temperature", "offset": 1, "width": 2, "endian": "big", "signed": true, "scale": 0.005 },
+        { "name": "humidity", "offset": 3, "width": 2, "endian": "big", "scale": 0.0025 },
+        { "name": "pressure", "offset": 5, "width": 2, "endian": "big", "bias": 50000 }
+      ]
+    },
+    {
+      "name": "atc",
+      "service_uuid": "181a",
+      "fields": [
+        { "name": "temperature", "offset": 6, "width": 2, "endian": "big", "signed": true, "scale": 0.1 },
+        { "name": "humidity", "offset": 8 },
+        { "name": "battery", "offset": 10, "width": 2, "endian": "big" }
+      ]
+    }
+  ])");
+}
+
+TEST_CASE("Pattern decoder extracts fields", "[ble]")
+{
+  auto pattern_decoder = std::make_shared<loopp::ble::PatternDecoder>(site_decoders());
+  loopp::ble::AdvertisementDecoder decoder;
+  decoder.add_decoder(loopp::ble::AdType::ManufacturerSpecific, pattern_decoder);
+  decoder.add_decoder(loopp::ble::AdType::ServiceData16, pattern_decoder);
+
+  json ruuvi;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(ruuvi_adv), ruuvi));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 24.3, ruuvi["ruuvi"]["temperature"].get<double>());
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 53.49, ruuvi["ruuvi"]["humidity"].get<double>());
+  TEST_ASSERT_FLOAT_WITHIN(0.5, 100044, ruuvi["ruuvi"]["pressure"].get<double>());
+
+  json atc;
+  TEST_ASSERT_TRUE(decoder.decode(from_hex(atc_adv), atc));
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 24.5, atc["atc"]["temperature"].get<double>());
+  TEST_ASSERT_EQUAL(48, atc["atc"]["humidity"].get<int>());
+  TEST_ASSERT_EQUAL(2950, atc["atc"]["battery"].get<int>());
+}
+
+TEST_CASE("Pattern decoder rejects mismatching and short payloads", "[ble]")
+{
+  loopp::ble::AdvertisementDecoder decoder;
+  decoder.add_decoder(loopp::ble::AdType::ManufacturerSpecific, std::make_shared<loopp::ble::PatternDecoder>(site_decoders()));
+
+  // Ruuvi format 3 instead of 5.
+  std::string other_format = from_hex(ruuvi_adv);
+  other_format[7] = 0x03;
+  json info;
+  TEST_ASSERT_FALSE(decoder.decode(other_format, info));
+
+  // Truncated after the format byte.
+  std::string truncated = from_hex("02010605ff99040512");
+  TEST_ASSERT_FALSE(decoder.decode(truncated, info));
+  TEST_ASSERT(info.find("ruuvi") == info.end());
+}
+
+TEST_CASE("Pattern decoder rejects out of range fields", "[ble]")
+{
+  // Each of these would wrap around when narrowed.
+  const char *definitions[] = {
+    R"([ { "name": "t", "company_id": 1, "fields": [ { "name": "f", "offset": 0, "width": 257 } ] } ])",
+    R"([ { "name": "t", "company_id": 1, "fields": [ { "name": "f", "offset": -1 } ] } ])",
+    R"([ { "name": "t", "company_id": 1, "fields": [ { "name": "f", "offset": 65536 } ] } ])",
+    R"([ { "name": "t", "company_id": 1, "match": [ { "offset": -2, "value": "05" } ], "fields": [] } ])",
+  };
+
+  for (const char *definition : definitions)
+    {
+      bool thrown = false;
+      try
+        {
+          loopp::ble::PatternDecoder decoder(json::parse(definition));
+        }
+      catch (std::runtime_error &)
+        {
+          thrown = true;
+        }
+      TEST_ASSERT_TRUE(thrown);
+    }
+}
+
+TEST_CASE("Pattern decoder throughput with 50 patterns", "[ble][benchmark]")
+{
+  const int iterations = 1000;
+
+  json config = site_decoders();
+  for (int i = 0; i < 48; i++)
+    {
+      json pattern;
+      pattern["name"] = "tag" + std::to_string(i);
+      pattern["company_id"] = 0x1000 + i;
+      pattern["match"] = json::array({ { { "offset", 0 }, { "mask", "f0" }, { "value", "a0" } } });
+      pattern["fields"] = json::array({ { { "name", "value" }, { "offset", 1 }, { "width", 2 } } });
+      config.push_back(pattern);
+    }
+
+  auto pattern_decoder = std::make_shared<loopp::ble::PatternDecoder>(config);
+  TEST_ASSERT_EQUAL(50, pattern_decoder->size());
+
+  loopp::ble::AdvertisementDecoder decoder;
+  decoder.add_decoder(loopp::ble::AdType::ManufacturerSpecific, pattern_decoder);
+  decoder.add_decoder(loopp::ble::AdType::ServiceData16, pattern_decoder);
+
+  std::vector<std::string> advs = {
+    from_hex(ruuvi_adv),
+    from_hex(atc_adv),
+    from_hex("0201061aff4c000215e2c56db5dffb48d2b060d0f5a71096e000010002c5"),
+    from_hex("02011a0aff4c001005011c1c4d3b"),
+    from_hex("02010606ff2010a1b2c3"),
+  };
+
+  int recognized = 0;
+  int64_t start = esp_timer_get_time();
+  for (int n = 0; n < iterations; n++)
+    {
+      for (const auto &adv : advs)
+        {
+          json info;
+          recognized += decoder.decode(adv, info) ? 1 : 0;
+        }
+    }
+  int64_t duration = esp_timer_get_time() - start;
+
+  int decoded = iterations * advs.size();
+  std::cout << "Decoded " << decoded << " advertisements against " << pattern_decoder->size() << " patterns in " << duration << " us ("
+            << (decoded * 1000000LL / (duration > 0 ? duration : 1)) << " adv/s)" << std::endl;
+  TEST_ASSERT_EQUAL(4 * iterations, recognized);
+}
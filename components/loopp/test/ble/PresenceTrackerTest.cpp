@@ -0,0 +1,169 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/ble/PresenceTracker.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::AddressType;
+using loopp::ble::PresenceTracker;
+
+namespace
+{
+  const std::int64_t second = 1000000;
+
+  json make_config()
+  {
+    json config;
+    config["type"] = "ema";
+    config["alpha"] = 0.5;
+    config["enter_rssi"] = -70;
+    config["exit_rssi"] = -80;
+    config["change"] = 6;
+    config["min_samples"] = 2;
+    config["timeout"] = 10;
+    return config;
+  }
+} // namespace
+
+TEST_CASE("Presence enters once and stays quiet while stationary", "[ble]")
+{
+  PresenceTracker tracker(make_config());
+  const uint8_t bda[6] = { 0xc0, 1, 2, 3, 4, 5 };
+  std::vector<PresenceTracker::Event> events;
+
+  for (int i = 0; i < 100; i++)
+    {
+      tracker.update(bda, AddressType::Public, -60 + (i % 3) - 1, i * second, events);
+    }
+
+  TEST_ASSERT_EQUAL(1, events.size());
+  TEST_ASSERT_TRUE(events[0].type == PresenceTracker::EventType::Enter);
+  TEST_ASSERT_EQUAL(1, events[0].timestamp / second);
+  TEST_ASSERT_EQUAL(1, tracker.present_count());
+}
+
+TEST_CASE("Presence does not flap between the thresholds", "[ble]")
+{
+  PresenceTracker tracker(make_config());
+  const uint8_t bda[6] = { 0xc0, 1, 2, 3, 4, 5 };
+  std::vector<PresenceTracker::Event> events;
+
+  // Hovering between exit and enter never enters.
+  for (int i = 0; i < 50; i++)
+    {
+      tracker.update(bda, AddressType::Public, (i % 2) ? -72 : -78, i * second, events);
+    }
+  TEST_ASSERT_EQUAL(0, events.size());
+
+  for (int i = 50; i < 60; i++)
+    {
+      tracker.update(bda, AddressType::Public, -60, i * second, events);
+    }
+  TEST_ASSERT_GREATER_OR_EQUAL(1, events.size());
+  TEST_ASSERT_TRUE(events[0].type == PresenceTracker::EventType::Enter);
+
+  // Once present, hovering in the same band does not exit. The drop from
+  // -60 is reported as a few changes.
+  events.clear();
+  for (int i = 60; i < 110; i++)
+    {
+      tracker.update(bda, AddressType::Public, (i % 2) ? -72 : -78, i * second, events);
+    }
+  TEST_ASSERT_GREATER_OR_EQUAL(1, events.size());
+  TEST_ASSERT_LESS_THAN(4, events.size());
+  for (const auto &event : events)
+    {
+      TEST_ASSERT_TRUE(event.type == PresenceTracker::EventType::Change);
+    }
+
+  events.clear();
+  for (int i = 110; i < 120; i++)
+    {
+      tracker.update(bda, AddressType::Public, -95, i * second, events);
+    }
+  TEST_ASSERT_EQUAL(1, events.size());
+  TEST_ASSERT_TRUE(events[0].type == PresenceTracker::EventType::Exit);
+  TEST_ASSERT_FALSE(events[0].timed_out);
+}
+
+TEST_CASE("Presence times out absent devices", "[ble]")
+{
+  PresenceTracker tracker(make_config());
+  const uint8_t near[6] = { 0xc0, 1, 2, 3, 4, 5 };
+  const uint8_t far[6] = { 0xc0, 1, 2, 3, 4, 6 };
+  std::vector<PresenceTracker::Event> events;
+
+  TEST_ASSERT_EQUAL(0, tracker.next_deadline());
+
+  tracker.update(near, AddressType::Public, -60, 0, events);
+  tracker.update(near, AddressType::Public, -60, 1 * second, events);
+  tracker.update(far, AddressType::Public, -95, 2 * second, events);
+  TEST_ASSERT_EQUAL(1, events.size());
+  TEST_ASSERT_EQUAL(11 * second, tracker.next_deadline());
+
+  events.clear();
+  tracker.expire(5 * second, events);
+  TEST_ASSERT_EQUAL(0, events.size());
+
+  tracker.expire(11 * second, events);
+  TEST_ASSERT_EQUAL(1, events.size());
+  TEST_ASSERT_TRUE(events[0].type == PresenceTracker::EventType::Exit);
+  TEST_ASSERT_TRUE(events[0].timed_out);
+  TEST_ASSERT_EQUAL(0, tracker.present_count());
+  TEST_ASSERT_EQUAL(12 * second, tracker.next_deadline());
+
+  // A device that never entered disappears without an event.
+  events.clear();
+  tracker.expire(12 * second, events);
+  TEST_ASSERT_EQUAL(0, events.size());
+  TEST_ASSERT_EQUAL(0, tracker.next_deadline());
+}
+
+TEST_CASE("Presence reports an exit for evicted devices", "[ble]")
+{
+  json config = make_config();
+  config["capacity"] = 4;
+  PresenceTracker tracker(config);
+  std::vector<PresenceTracker::Event> events;
+
+  for (uint8_t i = 0; i < 4; i++)
+    {
+      const uint8_t bda[6] = { 0xc0, 1, 2, 3, 4, i };
+      tracker.update(bda, AddressType::Public, -60, 0, events);
+      tracker.update(bda, AddressType::Public, -60, 1 * second, events);
+    }
+  TEST_ASSERT_EQUAL(4, events.size());
+  TEST_ASSERT_EQUAL(4, tracker.present_count());
+
+  // A new device in a full table evicts a present one, which is reported
+  // as an exit.
+  events.clear();
+  const uint8_t bda[6] = { 0xc0, 1, 2, 3, 4, 4 };
+  tracker.update(bda, AddressType::Public, -60, 2 * second, events);
+  TEST_ASSERT_EQUAL(1, events.size());
+  TEST_ASSERT_TRUE(events[0].type == PresenceTracker::EventType::Exit);
+  TEST_ASSERT_TRUE(events[0].evicted);
+  TEST_ASSERT_FALSE(events[0].timed_out);
+  TEST_ASSERT_EQUAL(3, tracker.present_count());
+}
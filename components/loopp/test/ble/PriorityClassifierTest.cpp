@@ -0,0 +1,95 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+
+#include "unity.h"
+
+#include "TestUtils.hpp"
+
+#include "loopp/ble/PriorityClassifier.hpp"
+
+using json = nlohmann::json;
+using loopp::test::from_hex;
+
+static bool
+match(const loopp::ble::PriorityClassifier &classifier, const char *adv_hex)
+{
+  std::string adv_data = from_hex(adv_hex);
+  return classifier.match(reinterpret_cast<const uint8_t *>(adv_data.data()), adv_data.size());
+}
+
+// iBeacon with major 1, minor 2.
+static const char *ibeacon_adv = "0201061aff4c000215f7826da64fa24e988024bc5b71e0893e00010002c5";
+static const char *phone_adv = "02011a0aff4c0010050b1c6f2a9e";
+
+TEST_CASE("Priority classifier without rules matches nothing", "[ble]")
+{
+  loopp::ble::PriorityClassifier classifier;
+  TEST_ASSERT_TRUE(classifier.empty());
+  TEST_ASSERT_FALSE(match(classifier, ibeacon_adv));
+}
+
+TEST_CASE("Priority classifier matches iBeacon UUID, major and minor", "[ble]")
+{
+  loopp::ble::PriorityClassifier by_uuid(json::parse(R"([ { "ibeacon_uuid": "f7826da6-4fa2-4e98-8024-bc5b71e0893e" } ])"));
+  TEST_ASSERT_TRUE(match(by_uuid, ibeacon_adv));
+  TEST_ASSERT_FALSE(match(by_uuid, phone_adv));
+
+  loopp::ble::PriorityClassifier by_major(json::parse(R"([ { "ibeacon_uuid": "f7826da6-4fa2-4e98-8024-bc5b71e0893e", "major": 1 } ])"));
+  TEST_ASSERT_TRUE(match(by_major, ibeacon_adv));
+
+  loopp::ble::PriorityClassifier by_minor(
+    json::parse(R"([ { "ibeacon_uuid": "f7826da6-4fa2-4e98-8024-bc5b71e0893e", "major": 1, "minor": 3 } ])"));
+  TEST_ASSERT_FALSE(match(by_minor, ibeacon_adv));
+
+  loopp::ble::PriorityClassifier other(json::parse(R"([ { "ibeacon_uuid": "00000000-4fa2-4e98-8024-bc5b71e0893e" } ])"));
+  TEST_ASSERT_FALSE(match(other, ibeacon_adv));
+}
+
+TEST_CASE("Priority classifier matches manufacturer flags", "[ble]")
+{
+  loopp::ble::PriorityClassifier by_company(json::parse(R"([ { "company_id": "004c" } ])"));
+  TEST_ASSERT_TRUE(match(by_company, phone_adv));
+  TEST_ASSERT_TRUE(match(by_company, ibeacon_adv));
+
+  loopp::ble::PriorityClassifier flag_set(json::parse(R"([ { "company_id": 76, "offset": 2, "mask": 8, "value": 8 } ])"));
+  TEST_ASSERT_TRUE(match(flag_set, phone_adv));
+
+  loopp::ble::PriorityClassifier flag_clear(json::parse(R"([ { "company_id": 76, "offset": 2, "mask": 4, "value": 4 } ])"));
+  TEST_ASSERT_FALSE(match(flag_clear, phone_adv));
+
+  loopp::ble::PriorityClassifier past_end(json::parse(R"([ { "company_id": 76, "offset": 40, "value": 0 } ])"));
+  TEST_ASSERT_FALSE(match(past_end, phone_adv));
+}
+
+TEST_CASE("Priority classifier rejects invalid rules", "[ble]")
+{
+  bool thrown = false;
+  try
+    {
+      loopp::ble::PriorityClassifier classifier(json::parse(R"([ { "major": 1 } ])"));
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+}
@@ -0,0 +1,78 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdexcept>
+
+#include "unity.h"
+
+#include "loopp/ble/ProximityClassifier.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::ProximityClassifier;
+using Zone = ProximityClassifier::Zone;
+
+// With the defaults, 0.5 m and 3 m correspond to a path loss of -6 dB and
+// 9.5 dB relative to the measured power at 1 m.
+static const int power = -59;
+
+TEST_CASE("Proximity zones from path loss", "[ble]")
+{
+  ProximityClassifier classifier(json::object());
+
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Unknown, -50.0f, power, 5) == Zone::Immediate);
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Unknown, -60.0f, power, 5) == Zone::Near);
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Unknown, -75.0f, power, 5) == Zone::Far);
+
+  // Too few samples to trust the estimate.
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Unknown, -50.0f, power, 2) == Zone::Unknown);
+  TEST_ASSERT_EQUAL_STRING("near", ProximityClassifier::zone_name(Zone::Near));
+}
+
+TEST_CASE("Proximity zones use hysteresis", "[ble]")
+{
+  ProximityClassifier classifier(json::object());
+
+  // 11 dB of path loss is far for a new beacon, but not far enough beyond
+  // the 3 m boundary to leave the near zone.
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Unknown, -70.0f, power, 5) == Zone::Far);
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Near, -70.0f, power, 5) == Zone::Near);
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Near, -73.0f, power, 5) == Zone::Far);
+
+  // And back.
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Far, -67.0f, power, 5) == Zone::Far);
+  TEST_ASSERT_TRUE(classifier.classify(Zone::Far, -65.0f, power, 5) == Zone::Near);
+
+  ProximityClassifier exact(json{ { "hysteresis", 0 } });
+  TEST_ASSERT_TRUE(exact.classify(Zone::Near, -70.0f, power, 5) == Zone::Far);
+}
+
+TEST_CASE("Proximity classifier rejects invalid zones", "[ble]")
+{
+  bool thrown = false;
+  try
+    {
+      ProximityClassifier classifier(json{ { "immediate", 2.0 }, { "near", 1.0 } });
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cmath>
+#include <stdexcept>
+
+#include "unity.h"
+
+#include "loopp/ble/RssiFilter.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::RssiFilter;
+
+TEST_CASE("RSSI filter EMA", "[ble]")
+{
+  RssiFilter filter(json{ { "type", "ema" }, { "alpha", 0.5 } });
+  RssiFilter::State state;
+
+  // The first sample initializes the estimate.
+  filter.update(state, -60);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -60.0f, state.estimate);
+  filter.update(state, -70);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -65.0f, state.estimate);
+  float estimate = filter.update(state, -80);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -72.5f, estimate);
+  TEST_ASSERT_EQUAL(3, state.samples);
+
+  // Converges to a constant signal.
+  for (int i = 0; i < 30; i++)
+    {
+      filter.update(state, -50);
+    }
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -50.0f, state.estimate);
+}
+
+TEST_CASE("RSSI filter Kalman", "[ble]")
+{
+  RssiFilter filter(json{ { "type", "kalman" }, { "process_noise", 0.05 }, { "measurement_noise", 4.0 } });
+  RssiFilter::State state;
+
+  filter.update(state, -60);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -60.0f, state.estimate);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 4.0f, state.error);
+
+  // p = 4.05, k = 4.05 / 8.05
+  float k = 4.05f / 8.05f;
+  filter.update(state, -70);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -60.0f - 10.0f * k, state.estimate);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, (1.0f - k) * 4.05f, state.error);
+
+  // The gain drops as the estimate settles, so a single outlier moves it
+  // less than it moves the EMA.
+  for (int i = 0; i < 50; i++)
+    {
+      filter.update(state, -60);
+    }
+  float settled = state.estimate;
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, -60.0f, settled);
+  filter.update(state, -90);
+  TEST_ASSERT_TRUE(std::fabs(state.estimate - settled) < 30.0f * 0.25f);
+}
+
+TEST_CASE("RSSI filter distance estimate", "[ble]")
+{
+  RssiFilter filter(json::object());
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, filter.estimate_distance(-59.0f, -59));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, filter.estimate_distance(-79.0f, -59));
+
+  RssiFilter indoor(json{ { "path_loss_exponent", 4.0 } });
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 10.0f, indoor.estimate_distance(-99.0f, -59));
+}
+
+TEST_CASE("RSSI filter rejects invalid configuration", "[ble]")
+{
+  bool thrown = false;
+  try
+    {
+      RssiFilter filter(json{ { "type", "median" } });
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+
+  thrown = false;
+  try
+    {
+      RssiFilter filter(json{ { "alpha", 0.0 } });
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/ble/ScanBatch.hpp"
+#include "loopp/utils/json.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::ScanBatch;
+
+TEST_CASE("Scan batch offsets are relative to the earliest record", "[ble]")
+{
+  ScanBatch batch;
+  TEST_ASSERT_TRUE(batch.empty());
+
+  // Filtered records carry the last time a device was seen, which may be
+  // before the first result that reached the main loop in this period.
+  batch.add(json{ { "mac", "a" } }.dump(), 5000);
+  batch.add(json{ { "mac", "b" } }.dump(), 1000);
+  batch.add(json{ { "mac", "c" } }.dump(), 9000);
+  TEST_ASSERT_EQUAL(3, batch.size());
+  TEST_ASSERT_EQUAL(1000, batch.get_base_time());
+
+  std::vector<std::int64_t> timestamps = batch.get_timestamps();
+  std::vector<std::string> records = batch.take_records();
+  TEST_ASSERT_EQUAL(3, records.size());
+  TEST_ASSERT_TRUE(batch.empty());
+
+  const char *macs[] = { "a", "b", "c" };
+  for (std::size_t i = 0; i < records.size(); i++)
+    {
+      json jr = json::parse(records[i]);
+      TEST_ASSERT_EQUAL_STRING(macs[i], jr["mac"].get<std::string>().c_str());
+      std::int64_t dt = jr["dt"].get<std::int64_t>();
+      TEST_ASSERT_TRUE(dt >= 0);
+      TEST_ASSERT_EQUAL(timestamps[i], 1000 + dt);
+    }
+}
+
+TEST_CASE("Scan batch appends the offset to an empty record", "[ble]")
+{
+  ScanBatch batch;
+  batch.add("{}", 42);
+  std::vector<std::string> records = batch.take_records();
+  TEST_ASSERT_EQUAL_STRING("{\"dt\":0}", records[0].c_str());
+}
@@ -0,0 +1,111 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "unity.h"
+
+#include "loopp/ble/ScanCoverage.hpp"
+
+static const std::int64_t second = 1000000;
+
+TEST_CASE("Scan coverage of a continuous scan", "[ble]")
+{
+  loopp::ble::ScanCoverage coverage;
+  coverage.reset(0);
+  coverage.scan_started(5000);
+
+  loopp::ble::ScanCoverage::Report report = coverage.take_report(10 * second + 5000);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 99.95f, report.duty_cycle);
+  TEST_ASSERT_EQUAL(0, report.restarts);
+
+  report = coverage.take_report(70 * second);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, report.duty_cycle);
+  TEST_ASSERT_EQUAL(0, static_cast<int>(report.max_gap_us));
+}
+
+TEST_CASE("Scan coverage of bounded scans with restart gaps", "[ble]")
+{
+  loopp::ble::ScanCoverage coverage;
+  coverage.reset(0);
+
+  // Ten 30 s scans, each followed by a 15 ms gap until the controller
+  // reports that scanning restarted. One restart takes 120 ms.
+  std::int64_t now = 0;
+  std::int64_t off = 0;
+  for (int i = 0; i < 10; i++)
+    {
+      coverage.scan_started(now);
+      now += 30 * second;
+      coverage.scan_stopped(now);
+      std::int64_t gap = (i == 4) ? 120000 : 15000;
+      now += gap;
+      off += gap;
+    }
+  coverage.scan_started(now);
+
+  loopp::ble::ScanCoverage::Report report = coverage.take_report(now);
+  float expected = 100.0f * static_cast<float>(now - off) / static_cast<float>(now);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, expected, report.duty_cycle);
+  TEST_ASSERT_EQUAL(10, report.restarts);
+  TEST_ASSERT_EQUAL(15000, static_cast<int>(report.last_gap_us));
+  TEST_ASSERT_EQUAL(120000, static_cast<int>(report.max_gap_us));
+
+  // The next period only reports its own restarts.
+  coverage.scan_stopped(now + second);
+  coverage.scan_started(now + second + 2000);
+  report = coverage.take_report(now + 2 * second);
+  TEST_ASSERT_EQUAL(1, report.restarts);
+  TEST_ASSERT_EQUAL(2000, static_cast<int>(report.max_gap_us));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 99.9f, report.duty_cycle);
+}
+
+TEST_CASE("Scan coverage ignores explicit stop and start", "[ble]")
+{
+  loopp::ble::ScanCoverage coverage;
+  coverage.reset(0);
+  coverage.scan_started(0);
+  coverage.scan_stopped(second);
+
+  coverage.reset(5 * second);
+  coverage.scan_started(5 * second);
+  loopp::ble::ScanCoverage::Report report = coverage.take_report(6 * second);
+  TEST_ASSERT_EQUAL(0, report.restarts);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, report.duty_cycle);
+}
+
+TEST_CASE("Scan coverage reset keeps the scan state", "[ble]")
+{
+  loopp::ble::ScanCoverage coverage;
+  coverage.reset(0);
+  coverage.scan_started(0);
+
+  // Still scanning: on time counts from the reset.
+  coverage.reset(10 * second);
+  TEST_ASSERT_TRUE(coverage.is_scanning());
+  coverage.scan_stopped(15 * second);
+  loopp::ble::ScanCoverage::Report report = coverage.take_report(20 * second);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 50.0f, report.duty_cycle);
+
+  // Not scanning: a reset does not start counting.
+  coverage.reset(20 * second);
+  TEST_ASSERT_FALSE(coverage.is_scanning());
+  report = coverage.take_report(30 * second);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, report.duty_cycle);
+  TEST_ASSERT_EQUAL(0, report.restarts);
+}
@@ -0,0 +1,95 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+
+#include "unity.h"
+
+#include "TestUtils.hpp"
+
+#include "loopp/ble/ScanFilter.hpp"
+
+using json = nlohmann::json;
+using loopp::test::from_hex;
+
+static bool
+accept(const loopp::ble::ScanFilter &filter, const uint8_t bda[6], int rssi, const std::string &adv_data)
+{
+  return filter.accept(bda, rssi, reinterpret_cast<const uint8_t *>(adv_data.data()), adv_data.size());
+}
+
+static const uint8_t tag_bda[6] = { 0xc4, 0x7c, 0x8d, 0x6a, 0x01, 0x02 };
+static const uint8_t phone_bda[6] = { 0x5a, 0x11, 0x22, 0x33, 0x44, 0x55 };
+static const char *ibeacon_adv = "0201061aff4c000215f7826da64fa24e988024bc5b71e0893e00010002c5";
+static const char *phone_adv = "02011a0aff4c0010050b1c6f2a9e";
+
+TEST_CASE("Scan filter without rules accepts everything", "[ble]")
+{
+  loopp::ble::ScanFilter filter;
+  TEST_ASSERT_TRUE(accept(filter, phone_bda, -100, from_hex(phone_adv)));
+
+  loopp::ble::ScanFilter strong(json::parse(R"({ "min_rssi": -80 })"));
+  TEST_ASSERT_TRUE(accept(strong, phone_bda, -80, from_hex(phone_adv)));
+  TEST_ASSERT_FALSE(accept(strong, phone_bda, -81, from_hex(phone_adv)));
+}
+
+TEST_CASE("Scan filter allow rules", "[ble]")
+{
+  loopp::ble::ScanFilter by_mac(json::parse(R"({ "allow": { "mac": [ "c4:7c:8d:6a:01:02" ] } })"));
+  TEST_ASSERT_TRUE(accept(by_mac, tag_bda, -60, from_hex(phone_adv)));
+  TEST_ASSERT_FALSE(accept(by_mac, phone_bda, -60, from_hex(ibeacon_adv)));
+
+  loopp::ble::ScanFilter by_prefix(json::parse(R"({ "allow": { "mac_prefix": [ "c4:7c:8d" ] } })"));
+  TEST_ASSERT_TRUE(accept(by_prefix, tag_bda, -60, ""));
+  TEST_ASSERT_FALSE(accept(by_prefix, phone_bda, -60, ""));
+
+  loopp::ble::ScanFilter by_uuid(json::parse(R"({ "allow": { "ibeacon_uuid": [ "f7826da6-4fa2-4e98-8024-bc5b71e0893e" ] } })"));
+  TEST_ASSERT_TRUE(accept(by_uuid, phone_bda, -60, from_hex(ibeacon_adv)));
+  TEST_ASSERT_FALSE(accept(by_uuid, phone_bda, -60, from_hex(phone_adv)));
+
+  loopp::ble::ScanFilter by_company(json::parse(R"({ "allow": { "company_id": [ "004c" ] } })"));
+  TEST_ASSERT_TRUE(accept(by_company, phone_bda, -60, from_hex(phone_adv)));
+  TEST_ASSERT_FALSE(accept(by_company, phone_bda, -60, from_hex("020106")));
+}
+
+TEST_CASE("Scan filter deny rules take precedence", "[ble]")
+{
+  loopp::ble::ScanFilter filter(json::parse(R"({
+    "allow": { "company_id": [ 76 ] },
+    "deny": { "mac": [ "5a:11:22:33:44:55" ] }
+  })"));
+
+  TEST_ASSERT_TRUE(accept(filter, tag_bda, -60, from_hex(phone_adv)));
+  TEST_ASSERT_FALSE(accept(filter, phone_bda, -60, from_hex(ibeacon_adv)));
+}
+
+TEST_CASE("Scan filter rejects invalid configuration", "[ble]")
+{
+  bool thrown = false;
+  try
+    {
+      loopp::ble::ScanFilter filter(json::parse(R"({ "allow": { "mac": [ "c4:7c:8d" ] } })"));
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+}
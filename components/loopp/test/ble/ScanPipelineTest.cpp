@@ -0,0 +1,230 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "unity.h"
+#include "esp_timer.h"
+
+#include "loopp/ble/AdvertisementDecoder.hpp"
+#include "loopp/ble/LoadGenerator.hpp"
+#include "loopp/ble/ScanPipeline.hpp"
+#include "loopp/core/Semaphore.hpp"
+
+using json = nlohmann::json;
+using loopp::ble::BLEScanner;
+using loopp::ble::ScanPipeline;
+
+namespace
+{
+  std::string to_hex(const std::string &data)
+  {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (unsigned char c : data)
+      {
+        out += digits[c >> 4];
+        out += digits[c & 0x0f];
+      }
+    return out;
+  }
+
+  // Roughly the work BLEScannerDriver does per advertisement.
+  bool encode(const loopp::ble::AdvertisementDecoder &decoder, const BLEScanner::ScanResult &result, std::string &record)
+  {
+    json jb;
+    jb["mac"] = to_hex(std::string(reinterpret_cast<const char *>(result.bda), sizeof(result.bda)));
+    jb["rssi"] = result.rssi;
+    decoder.decode(result.adv_data, jb);
+    jb["adv_data"] = to_hex(result.adv_data);
+    record = jb.dump();
+    return true;
+  }
+
+  std::vector<BLEScanner::ScanResult> generate(std::size_t count)
+  {
+    loopp::ble::LoadGenerator generator(json::parse(R"({
+      "seed": 1,
+      "ibeacons": { "count": 50, "interval_ms": 100 },
+      "phones": { "count": 100, "interval_ms": 250 }
+    })"));
+    generator.start(0);
+
+    std::vector<BLEScanner::ScanResult> results(count);
+    for (auto &r : results)
+      {
+        generator.next(r);
+      }
+    return results;
+  }
+
+  void wait_for(ScanPipeline &pipeline, std::vector<ScanPipeline::Record> &records, std::size_t count)
+  {
+    int64_t deadline = esp_timer_get_time() + 5000000;
+    while (records.size() < count && esp_timer_get_time() < deadline)
+      {
+        pipeline.drain(records);
+      }
+  }
+} // namespace
+
+TEST_CASE("Scan pipeline delivers records in order", "[ble]")
+{
+  loopp::ble::AdvertisementDecoder decoder;
+  ScanPipeline pipeline(64, [&decoder](const BLEScanner::ScanResult &result, std::string &record) { return encode(decoder, result, record); });
+  pipeline.start(loopp::core::Task::CoreId::CPU1);
+
+  std::vector<BLEScanner::ScanResult> results = generate(50);
+  for (const auto &r : results)
+    {
+      TEST_ASSERT_TRUE(pipeline.capture(r));
+    }
+
+  std::vector<ScanPipeline::Record> records;
+  wait_for(pipeline, records, results.size());
+  pipeline.stop();
+
+  TEST_ASSERT_EQUAL(results.size(), records.size());
+  for (std::size_t i = 0; i < records.size(); i++)
+    {
+      TEST_ASSERT_EQUAL(results[i].timestamp, records[i].timestamp);
+      TEST_ASSERT_EQUAL(results[i].rssi, json::parse(records[i].data)["rssi"].get<int>());
+    }
+
+  ScanPipeline::Stats stats = pipeline.take_stats();
+  TEST_ASSERT_EQUAL(50, stats.capture.processed);
+  TEST_ASSERT_EQUAL(50, stats.decode.processed);
+  TEST_ASSERT_EQUAL(50, stats.published);
+  TEST_ASSERT_EQUAL(0, stats.capture.dropped);
+}
+
+TEST_CASE("Scan pipeline can be stopped and started again", "[ble]")
+{
+  ScanPipeline pipeline(64, [](const BLEScanner::ScanResult &result, std::string &record) {
+    record = std::to_string(result.timestamp);
+    return true;
+  });
+  std::vector<BLEScanner::ScanResult> results = generate(30);
+
+  pipeline.start(loopp::core::Task::CoreId::CPU1);
+  pipeline.stop();
+  pipeline.start(loopp::core::Task::CoreId::CPU1);
+
+  for (std::size_t i = 0; i < 20; i++)
+    {
+      TEST_ASSERT_TRUE(pipeline.capture(results[i]));
+    }
+  std::vector<ScanPipeline::Record> records;
+  wait_for(pipeline, records, 20);
+  pipeline.stop();
+
+  TEST_ASSERT_EQUAL(20, records.size());
+  for (std::size_t i = 0; i < records.size(); i++)
+    {
+      TEST_ASSERT_EQUAL(results[i].timestamp, records[i].timestamp);
+    }
+
+  // Nothing is decoded after stop() returned.
+  for (std::size_t i = 20; i < results.size(); i++)
+    {
+      TEST_ASSERT_TRUE(pipeline.capture(results[i]));
+    }
+  int64_t until = esp_timer_get_time() + 50000;
+  while (esp_timer_get_time() < until)
+    {
+    }
+  records.clear();
+  TEST_ASSERT_EQUAL(0, pipeline.drain(records));
+}
+
+TEST_CASE("Scan pipeline drops when a stage falls behind", "[ble]")
+{
+  ScanPipeline pipeline(16, [](const BLEScanner::ScanResult &, std::string &record) {
+    record = "{}";
+    return true;
+  });
+
+  // Not started, so nothing is decoded.
+  std::vector<BLEScanner::ScanResult> results = generate(20);
+  int accepted = 0;
+  for (const auto &r : results)
+    {
+      accepted += pipeline.capture(r) ? 1 : 0;
+    }
+  TEST_ASSERT_EQUAL(16, accepted);
+
+  ScanPipeline::Stats stats = pipeline.take_stats();
+  TEST_ASSERT_EQUAL(16, stats.capture.processed);
+  TEST_ASSERT_EQUAL(4, stats.capture.dropped);
+  TEST_ASSERT_EQUAL(16, stats.capture.depth);
+  TEST_ASSERT_EQUAL(16, stats.capture.max_depth);
+}
+
+// Compares the advertisement rate of the single loop design, where one task
+// copies, decodes, serializes and batches every advertisement, against the
+// pipeline, where a producer task stands in for the Bluetooth task.
+TEST_CASE("Scan pipeline throughput", "[ble][benchmark]")
+{
+  const std::size_t count = 20000;
+  std::vector<BLEScanner::ScanResult> results = generate(count);
+  loopp::ble::AdvertisementDecoder decoder;
+
+  int64_t start = esp_timer_get_time();
+  std::vector<std::string> batch;
+  batch.reserve(count);
+  for (const auto &r : results)
+    {
+      BLEScanner::ScanResult copy = r;
+      std::string record;
+      encode(decoder, copy, record);
+      batch.push_back(std::move(record));
+    }
+  int64_t single_us = esp_timer_get_time() - start;
+
+  ScanPipeline pipeline(256, [&decoder](const BLEScanner::ScanResult &result, std::string &record) { return encode(decoder, result, record); });
+  pipeline.start(loopp::core::Task::CoreId::CPU1);
+
+  loopp::core::Semaphore done(1, 0);
+  start = esp_timer_get_time();
+  loopp::core::Task producer("bench_capture",
+                             [&pipeline, &results, &done]() {
+                               for (const auto &r : results)
+                                 {
+                                   while (!pipeline.capture(r))
+                                     {
+                                     }
+                                 }
+                               done.give();
+                             },
+                             loopp::core::Task::CoreId::CPU0);
+
+  std::vector<ScanPipeline::Record> records;
+  records.reserve(count);
+  wait_for(pipeline, records, count);
+  int64_t pipeline_us = esp_timer_get_time() - start;
+  done.take();
+  pipeline.stop();
+
+  TEST_ASSERT_EQUAL(count, records.size());
+  printf("single loop: %d adv/s, pipeline: %d adv/s\n", static_cast<int>(count * 1000000LL / single_us),
+         static_cast<int>(count * 1000000LL / pipeline_us));
+}
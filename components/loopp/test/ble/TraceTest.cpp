@@ -0,0 +1,201 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "unity.h"
+
+#include "loopp/ble/TraceReader.hpp"
+#include "loopp/ble/TraceRecorder.hpp"
+#include "loopp/ble/TraceReplay.hpp"
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/core/Signal.hpp"
+
+using loopp::ble::BLEScanner;
+
+#ifdef __linux__
+namespace
+{
+  const int record_count = 5;
+
+  BLEScanner::ScanResult make_result(int i)
+  {
+    BLEScanner::ScanResult result;
+    for (int b = 0; b < 6; b++)
+      {
+        result.bda[b] = static_cast<uint8_t>(0x10 * b + i);
+      }
+    result.ble_addr_type = static_cast<uint8_t>(i % 2);
+    result.rssi = -40 - i;
+    result.timestamp = 1000000 + i * 1000;
+    result.adv_data = std::string(static_cast<std::size_t>(3 + i), static_cast<char>('a' + i));
+    return result;
+  }
+
+  // Records 'record_count' results into a new temporary trace and returns
+  // its size.
+  long record_trace(char *path)
+  {
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    close(fd);
+    // The recorder only writes a header to an empty file.
+    TEST_ASSERT_EQUAL(0, truncate(path, 0));
+
+    loopp::ble::TraceRecorder recorder(path);
+    for (int i = 0; i < record_count; i++)
+      {
+        recorder.record(make_result(i));
+      }
+    recorder.flush();
+    TEST_ASSERT_EQUAL(record_count, recorder.get_count());
+
+    long size = static_cast<long>(loopp::ble::TraceRecorder::header_size);
+    for (int i = 0; i < record_count; i++)
+      {
+        size += static_cast<long>(loopp::ble::TraceRecorder::record_header_size + make_result(i).adv_data.size());
+      }
+    return size;
+  }
+
+  void assert_equal_result(const BLEScanner::ScanResult &expected, const BLEScanner::ScanResult &actual)
+  {
+    TEST_ASSERT_EQUAL_MEMORY(expected.bda, actual.bda, sizeof(expected.bda));
+    TEST_ASSERT_EQUAL(expected.ble_addr_type, actual.ble_addr_type);
+    TEST_ASSERT_EQUAL(expected.rssi, actual.rssi);
+    TEST_ASSERT_EQUAL(expected.timestamp, actual.timestamp);
+    TEST_ASSERT_TRUE(expected.adv_data == actual.adv_data);
+  }
+} // namespace
+
+TEST_CASE("Trace reader reads back recorded results", "[ble]")
+{
+  char path[] = "/tmp/trace-XXXXXX";
+  record_trace(path);
+
+  loopp::ble::TraceReader reader(path);
+  BLEScanner::ScanResult result;
+  for (int i = 0; i < record_count; i++)
+    {
+      TEST_ASSERT_TRUE(reader.next(result));
+      assert_equal_result(make_result(i), result);
+    }
+  TEST_ASSERT_FALSE(reader.next(result));
+
+  reader.rewind();
+  TEST_ASSERT_TRUE(reader.next(result));
+  assert_equal_result(make_result(0), result);
+  unlink(path);
+}
+
+TEST_CASE("Trace reader ignores a truncated final record", "[ble]")
+{
+  char path[] = "/tmp/trace-XXXXXX";
+  long size = record_trace(path);
+
+  // Cut the last record in its advertising data, as after a power loss.
+  TEST_ASSERT_EQUAL(0, truncate(path, size - 2));
+
+  loopp::ble::TraceReader reader(path);
+  BLEScanner::ScanResult result;
+  int count = 0;
+  while (reader.next(result))
+    {
+      assert_equal_result(make_result(count), result);
+      count++;
+    }
+  TEST_ASSERT_EQUAL(record_count - 1, count);
+  unlink(path);
+}
+
+TEST_CASE("Trace recorder appends only to a valid trace", "[ble]")
+{
+  char path[] = "/tmp/trace-XXXXXX";
+  record_trace(path);
+
+  {
+    loopp::ble::TraceRecorder recorder(path);
+    recorder.record(make_result(record_count));
+  }
+  loopp::ble::TraceReader reader(path);
+  BLEScanner::ScanResult result;
+  int count = 0;
+  while (reader.next(result))
+    {
+      assert_equal_result(make_result(count), result);
+      count++;
+    }
+  TEST_ASSERT_EQUAL(record_count + 1, count);
+
+  // Change the version.
+  FILE *file = fopen(path, "r+b");
+  TEST_ASSERT_TRUE(file != nullptr);
+  fseek(file, 4, SEEK_SET);
+  fputc(1, file);
+  fclose(file);
+
+  bool thrown = false;
+  try
+    {
+      loopp::ble::TraceRecorder recorder(path);
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+  unlink(path);
+}
+
+TEST_CASE("Trace replay emits every recorded result", "[ble]")
+{
+  char path[] = "/tmp/trace-XXXXXX";
+  record_trace(path);
+
+  auto loop = std::make_shared<loopp::core::MainLoop>();
+  loopp::core::Signal<void(const BLEScanner::ScanResult &)> signal;
+  std::vector<BLEScanner::ScanResult> replayed;
+  loopp::core::ScopedConnection connection = signal.connect([&replayed](const BLEScanner::ScanResult &result) { replayed.push_back(result); });
+
+  auto replay = std::make_shared<loopp::ble::TraceReplay>(loop, std::make_shared<loopp::ble::TraceReader>(path), signal);
+  replay->set_speed(0.0);
+  replay->start([loop]() { loop->terminate(); });
+  loop->run();
+
+  TEST_ASSERT_EQUAL(record_count, replay->get_count());
+  TEST_ASSERT_EQUAL(record_count, replayed.size());
+  for (int i = 0; i < record_count; i++)
+    {
+      // Timestamps are rebased to the time of replay.
+      BLEScanner::ScanResult expected = make_result(i);
+      expected.timestamp = replayed[i].timestamp;
+      assert_equal_result(expected, replayed[i]);
+    }
+  unlink(path);
+}
+#endif
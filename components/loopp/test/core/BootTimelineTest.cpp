@@ -0,0 +1,52 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/core/BootTimeline.hpp"
+
+using loopp::core::BootTimeline;
+
+TEST_CASE("Boot timeline keeps the first mark of each phase", "[core]")
+{
+  BootTimeline timeline;
+  std::vector<std::string> signalled;
+  loopp::core::ScopedConnection connection =
+    timeline.phase_signal().connect([&signalled](std::string phase) { signalled.push_back(phase); });
+
+  TEST_ASSERT_TRUE(timeline.mark("nvs", 1000));
+  TEST_ASSERT_TRUE(timeline.mark("bt_ready", 5000));
+  TEST_ASSERT_TRUE(timeline.mark("wifi_connected", 3000));
+  TEST_ASSERT_FALSE(timeline.mark("nvs", 9000));
+
+  TEST_ASSERT_EQUAL(1000, timeline.get("nvs"));
+  TEST_ASSERT_EQUAL(-1, timeline.get("scan_published"));
+
+  std::vector<BootTimeline::Phase> phases = timeline.get_phases();
+  TEST_ASSERT_EQUAL(3, phases.size());
+  TEST_ASSERT_EQUAL_STRING("bt_ready", phases[1].name.c_str());
+  TEST_ASSERT_EQUAL(3000, phases[2].time_us);
+
+  TEST_ASSERT_EQUAL(3, signalled.size());
+  TEST_ASSERT_EQUAL_STRING("wifi_connected", signalled[2].c_str());
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "unity.h"
+
+#include "loopp/core/ClockSync.hpp"
+
+namespace
+{
+  // Stand-in for the time server. Its clock is offset by offset_us and runs
+  // drift_ppm slower than the local clock. Each direction of an exchange
+  // takes a base latency plus exponentially distributed queuing delay.
+  class SimulatedServer
+  {
+  public:
+    SimulatedServer(std::int64_t offset_us, double drift_ppm, double jitter_us)
+      : offset_us(offset_us)
+      , drift_ppm(drift_ppm)
+      , jitter(1.0 / jitter_us)
+    {
+    }
+
+    std::int64_t reference_time(std::int64_t local) const
+    {
+      return local + offset_us - static_cast<std::int64_t>(static_cast<double>(local) * drift_ppm / 1e6);
+    }
+
+    void exchange(std::int64_t t1, std::int64_t &t2, std::int64_t &t3, std::int64_t &t4)
+    {
+      std::int64_t up = 4000 + static_cast<std::int64_t>(jitter(rng));
+      std::int64_t down = 4000 + static_cast<std::int64_t>(jitter(rng));
+      std::int64_t processing = 200;
+
+      t2 = reference_time(t1 + up);
+      t3 = reference_time(t1 + up + processing);
+      t4 = t1 + up + processing + down;
+    }
+
+  private:
+    std::int64_t offset_us;
+    double drift_ppm;
+    std::mt19937 rng{ 1234 };
+    std::exponential_distribution<double> jitter;
+  };
+
+  std::int64_t
+  run(loopp::core::ClockSync &sync, SimulatedServer &server, std::int64_t now, int exchanges, std::int64_t interval)
+  {
+    for (int i = 0; i < exchanges; i++)
+      {
+        std::int64_t t2, t3, t4;
+        server.exchange(now, t2, t3, t4);
+        sync.add_sample(now, t2, t3, t4);
+        now += interval;
+      }
+    return now;
+  }
+
+  std::int64_t
+  max_residual(const loopp::core::ClockSync &sync, const SimulatedServer &server, std::int64_t from, std::int64_t to)
+  {
+    std::int64_t worst = 0;
+    for (std::int64_t t = from; t < to; t += 1000000)
+      {
+        worst = std::max<std::int64_t>(worst, std::llabs(sync.to_reference(t) - server.reference_time(t)));
+      }
+    return worst;
+  }
+} // namespace
+
+TEST_CASE("Clock sync estimates offset", "[core]")
+{
+  loopp::core::ClockSync sync;
+  TEST_ASSERT_FALSE(sync.is_synchronized());
+
+  SimulatedServer server(1538000000LL * 1000000LL, 0.0, 20000.0);
+  std::int64_t now = run(sync, server, 1000000, 8, 2000000);
+
+  TEST_ASSERT_TRUE(sync.is_synchronized());
+  std::int64_t residual = max_residual(sync, server, now, now + 10000000);
+  std::cout << "Offset only: residual " << residual << " us, delay " << sync.get_delay() << " us" << std::endl;
+  TEST_ASSERT_LESS_THAN(2000, static_cast<int>(residual));
+}
+
+TEST_CASE("Clock sync tracks drift with delay jitter", "[core]")
+{
+  // 40 ppm is a typical crystal tolerance; up to tens of milliseconds of
+  // queuing delay in each direction.
+  loopp::core::ClockSync sync;
+  SimulatedServer server(-250000, 40.0, 20000.0);
+
+  std::int64_t now = run(sync, server, 1000000, 8, 2000000);
+  now = run(sync, server, now, 60, 16000000);
+
+  std::int64_t residual = max_residual(sync, server, now, now + 60000000);
+  std::cout << "Drift " << sync.get_drift_ppm() << " ppm (actual 40), residual over next minute " << residual << " us" << std::endl;
+  TEST_ASSERT_FLOAT_WITHIN(10.0, 40.0, sync.get_drift_ppm());
+  TEST_ASSERT_LESS_THAN(3000, static_cast<int>(residual));
+
+  // Without drift compensation the offset would be 38 ms off after a 16
+  // minute outage of the time server.
+  residual = max_residual(sync, server, now + 16 * 60 * 1000000LL, now + 17 * 60 * 1000000LL);
+  std::cout << "Residual after 16 minutes without samples " << residual << " us" << std::endl;
+  TEST_ASSERT_LESS_THAN(10000, static_cast<int>(residual));
+}
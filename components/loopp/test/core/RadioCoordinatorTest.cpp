@@ -0,0 +1,126 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <vector>
+
+#include "unity.h"
+
+#include "esp_timer.h"
+
+#include "loopp/core/RadioCoordinator.hpp"
+
+using loopp::core::RadioCoordinator;
+using Mode = RadioCoordinator::Mode;
+
+TEST_CASE("Radio coordinator follows the strongest active lease", "[core]")
+{
+  RadioCoordinator radio;
+  std::vector<Mode> modes;
+  loopp::core::ScopedConnection connection = radio.mode_signal().connect([&modes](Mode mode) { modes.push_back(mode); });
+
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Normal);
+
+  RadioCoordinator::Lease reduced = radio.request(Mode::Reduced, std::chrono::milliseconds(10000), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Reduced);
+
+  {
+    RadioCoordinator::Lease paused = radio.request(Mode::Paused, std::chrono::milliseconds(1000), "test");
+    TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+  }
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Reduced);
+
+  reduced.release();
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Normal);
+
+  // Releasing twice is harmless.
+  reduced.release();
+
+  TEST_ASSERT_EQUAL(4, modes.size());
+  TEST_ASSERT_TRUE(modes[0] == Mode::Reduced);
+  TEST_ASSERT_TRUE(modes[1] == Mode::Paused);
+  TEST_ASSERT_TRUE(modes[2] == Mode::Reduced);
+  TEST_ASSERT_TRUE(modes[3] == Mode::Normal);
+
+  RadioCoordinator::Stats stats = radio.take_stats();
+  TEST_ASSERT_EQUAL(2, stats.requests);
+  TEST_ASSERT_EQUAL(0, stats.downgraded);
+}
+
+TEST_CASE("Radio coordinator expires leases that are not released", "[core]")
+{
+  RadioCoordinator radio;
+  int64_t now = esp_timer_get_time();
+
+  RadioCoordinator::Lease lease = radio.request(Mode::Paused, std::chrono::milliseconds(500), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+
+  radio.update(now + 400000);
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+
+  radio.update(now + 600000);
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Normal);
+
+  RadioCoordinator::Stats stats = radio.take_stats();
+  TEST_ASSERT_TRUE(stats.paused_us >= 400000);
+}
+
+TEST_CASE("Radio coordinator limits pauses to the budget", "[core]")
+{
+  RadioCoordinator radio;
+  radio.configure(true, std::chrono::milliseconds(1000), std::chrono::seconds(10));
+  int64_t now = esp_timer_get_time();
+
+  RadioCoordinator::Lease lease = radio.request(Mode::Paused, std::chrono::milliseconds(5000), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+
+  // The budget refills at 10% while pausing, so it lasts about 1.1 s.
+  radio.update(now + 1000000);
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+  radio.update(now + 1500000);
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Reduced);
+
+  // Another pause is downgraded while the budget is spent.
+  RadioCoordinator::Lease second = radio.request(Mode::Paused, std::chrono::milliseconds(5000), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Reduced);
+
+  RadioCoordinator::Stats stats = radio.take_stats();
+  TEST_ASSERT_EQUAL(2, stats.requests);
+  TEST_ASSERT_EQUAL(1, stats.downgraded);
+  TEST_ASSERT_INT_WITHIN(50000, 1110000, static_cast<int>(stats.paused_us));
+
+  lease.release();
+  second.release();
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Normal);
+
+  // After a full budget window the budget is back.
+  radio.update(now + 12000000);
+  RadioCoordinator::Lease third = radio.request(Mode::Paused, std::chrono::milliseconds(500), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Paused);
+}
+
+TEST_CASE("Disabled radio coordinator grants nothing", "[core]")
+{
+  RadioCoordinator radio;
+  radio.configure(false, std::chrono::milliseconds(5000), std::chrono::seconds(60));
+
+  RadioCoordinator::Lease lease = radio.request(Mode::Paused, std::chrono::milliseconds(1000), "test");
+  TEST_ASSERT_TRUE(radio.get_mode() == Mode::Normal);
+  TEST_ASSERT_EQUAL(0, radio.take_stats().requests);
+}
@@ -0,0 +1,118 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cmath>
+#include <map>
+#include <random>
+
+#include "unity.h"
+
+#include "loopp/core/CountMinSketch.hpp"
+#include "loopp/core/Hash.hpp"
+#include "loopp/core/HyperLogLog.hpp"
+#include "loopp/core/TopK.hpp"
+
+using namespace loopp::core;
+
+TEST_CASE("HyperLogLog estimates distinct keys within a few percent", "[core]")
+{
+  const std::uint64_t counts[] = { 100, 10000, 100000 };
+  for (std::uint64_t n : counts)
+    {
+      HyperLogLog hll(10);
+      for (std::uint64_t i = 0; i < n; i++)
+        {
+          // Every key is added twice; duplicates must not be counted.
+          hll.add(mix64(i));
+          hll.add(mix64(i));
+        }
+      double error = std::fabs(static_cast<double>(hll.estimate()) - n) / n;
+      TEST_ASSERT_LESS_THAN(10, static_cast<int>(error * 100));
+    }
+}
+
+TEST_CASE("HyperLogLog uses fixed memory", "[core]")
+{
+  HyperLogLog hll(10);
+  std::size_t size = hll.memory_size();
+  for (std::uint64_t i = 0; i < 50000; i++)
+    {
+      hll.add(mix64(i));
+    }
+  TEST_ASSERT_EQUAL(size, hll.memory_size());
+  hll.clear();
+  TEST_ASSERT_EQUAL(0, hll.estimate());
+}
+
+TEST_CASE("CountMinSketch never undercounts", "[core]")
+{
+  CountMinSketch cms(256, 4);
+  std::map<std::uint64_t, std::uint32_t> exact;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> keys(0, 2000);
+
+  for (int i = 0; i < 20000; i++)
+    {
+      std::uint64_t key = mix64(keys(rng));
+      cms.add(key);
+      exact[key]++;
+    }
+
+  TEST_ASSERT_EQUAL(20000, cms.total());
+  for (const auto &kv : exact)
+    {
+      TEST_ASSERT_GREATER_OR_EQUAL(kv.second, cms.estimate(kv.first));
+    }
+}
+
+TEST_CASE("TopK finds the heavy hitters of a skewed stream", "[core]")
+{
+  CountMinSketch cms(256, 4);
+  TopK top(5);
+  std::mt19937 rng(7);
+
+  // Zipf-like: key i has weight 1 / (i + 1).
+  std::vector<double> weights;
+  for (int i = 0; i < 1000; i++)
+    {
+      weights.push_back(1.0 / (i + 1));
+    }
+  std::discrete_distribution<int> keys(weights.begin(), weights.end());
+
+  for (int i = 0; i < 50000; i++)
+    {
+      std::uint64_t key = mix64(keys(rng));
+      bool inserted;
+      top.offer(key, cms.add(key), inserted);
+    }
+
+  std::vector<TopK::Item> items = top.sorted();
+  TEST_ASSERT_EQUAL(5, items.size());
+  for (int i = 0; i < 3; i++)
+    {
+      bool found = false;
+      for (const auto &item : items)
+        {
+          found = found || item.key == mix64(i);
+        }
+      TEST_ASSERT_TRUE(found);
+    }
+  TEST_ASSERT_EQUAL(mix64(0), items[0].key);
+}
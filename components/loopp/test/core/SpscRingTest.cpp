@@ -0,0 +1,140 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string>
+
+#include "unity.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "loopp/core/Semaphore.hpp"
+#include "loopp/core/SpscRing.hpp"
+#include "loopp/core/Task.hpp"
+
+using loopp::core::SpscRing;
+
+namespace
+{
+  struct Counted
+  {
+    Counted() = default;
+    Counted(const Counted &other)
+      : value(other.value)
+    {
+      copies++;
+    }
+    Counted &operator=(const Counted &other)
+    {
+      value = other.value;
+      copies++;
+      return *this;
+    }
+
+    int value = 0;
+    static int copies;
+  };
+
+  int Counted::copies = 0;
+} // namespace
+
+TEST_CASE("SPSC ring does not copy rejected values", "[core]")
+{
+  SpscRing<Counted> ring(2);
+  Counted c;
+  TEST_ASSERT_TRUE(ring.try_push(c));
+  TEST_ASSERT_TRUE(ring.try_push(c));
+
+  Counted::copies = 0;
+  TEST_ASSERT_FALSE(ring.try_push(c));
+  TEST_ASSERT_EQUAL(0, Counted::copies);
+}
+
+TEST_CASE("SPSC ring is a bounded FIFO", "[core]")
+{
+  SpscRing<int> ring(5);
+  TEST_ASSERT_EQUAL(8, ring.capacity());
+
+  int value = 0;
+  TEST_ASSERT_FALSE(ring.try_pop(value));
+
+  // Wrap around a few times.
+  int next_push = 0;
+  int next_pop = 0;
+  for (int round = 0; round < 10; round++)
+    {
+      while (ring.try_push(next_push))
+        {
+          next_push++;
+        }
+      TEST_ASSERT_EQUAL(8, ring.size());
+
+      for (int i = 0; i < 5; i++)
+        {
+          TEST_ASSERT_TRUE(ring.try_pop(value));
+          TEST_ASSERT_EQUAL(next_pop++, value);
+        }
+      TEST_ASSERT_EQUAL(3, ring.size());
+    }
+}
+
+TEST_CASE("SPSC ring moves values", "[core]")
+{
+  SpscRing<std::string> ring(4);
+  std::string s(100, 'x');
+  TEST_ASSERT_TRUE(ring.try_push(std::move(s)));
+
+  std::string out;
+  TEST_ASSERT_TRUE(ring.try_pop(out));
+  TEST_ASSERT_EQUAL(100, out.size());
+}
+
+TEST_CASE("SPSC ring between two tasks", "[core]")
+{
+  const int count = 200000;
+  SpscRing<int> ring(64);
+  loopp::core::Semaphore done(1, 0);
+
+  loopp::core::Task producer("ring_producer",
+                             [&ring, &done]() {
+                               for (int i = 0; i < count; i++)
+                                 {
+                                   while (!ring.try_push(i))
+                                     {
+                                     }
+                                 }
+                               done.give();
+                             },
+                             loopp::core::Task::CoreId::CPU1);
+
+  bool ordered = true;
+  int value = 0;
+  for (int expected = 0; expected < count;)
+    {
+      if (ring.try_pop(value))
+        {
+          ordered = ordered && value == expected;
+          expected++;
+        }
+    }
+  done.take();
+  TEST_ASSERT_TRUE(ordered);
+  TEST_ASSERT_EQUAL(0, ring.size());
+}
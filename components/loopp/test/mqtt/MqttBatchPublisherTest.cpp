@@ -0,0 +1,147 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/core/MainLoop.hpp"
+#include "loopp/mqtt/MqttBatchPublisher.hpp"
+#include "loopp/mqtt/MqttClient.hpp"
+
+using loopp::mqtt::MqttBatchPublisher;
+
+namespace
+{
+  std::vector<std::string> make_records(int count, std::size_t padding)
+  {
+    std::vector<std::string> records;
+    for (int i = 0; i < count; i++)
+      {
+        nlohmann::json jr;
+        jr["i"] = i;
+        jr["pad"] = std::string(padding, 'x');
+        records.push_back(jr.dump());
+      }
+    return records;
+  }
+
+  // Encodes every part and checks the envelope. Returns the records in the
+  // order they were published.
+  std::vector<int> encode_parts(const nlohmann::json &header, std::uint32_t seq, std::vector<std::string> &records,
+                                const std::vector<std::size_t> &part_ends, std::size_t max_packet_size)
+  {
+    std::vector<int> published;
+    std::size_t begin = 0;
+    for (std::size_t part = 0; part < part_ends.size(); part++)
+      {
+        std::string payload = MqttBatchPublisher::encode_part(header, seq, part, part_ends.size(), records, begin, part_ends[part]);
+        TEST_ASSERT_TRUE(payload.size() <= max_packet_size);
+
+        nlohmann::json envelope = nlohmann::json::parse(payload);
+        TEST_ASSERT_EQUAL(seq, envelope["seq"].get<std::uint32_t>());
+        TEST_ASSERT_EQUAL(part + 1, envelope["part"].get<std::size_t>());
+        TEST_ASSERT_EQUAL(part_ends.size(), envelope["parts"].get<std::size_t>());
+        TEST_ASSERT_EQUAL(1234, envelope["base_time"].get<int>());
+        for (const auto &jr : envelope["results"])
+          {
+            published.push_back(jr["i"].get<int>());
+          }
+        begin = part_ends[part];
+      }
+    return published;
+  }
+} // namespace
+
+TEST_CASE("Batch publisher splits records into numbered parts", "[mqtt]")
+{
+  const std::size_t max_packet_size = 400;
+  nlohmann::json header;
+  header["base_time"] = 1234;
+  std::vector<std::string> records = make_records(20, 60);
+
+  std::vector<std::size_t> part_ends = MqttBatchPublisher::partition(records, header, max_packet_size);
+  TEST_ASSERT_TRUE(part_ends.size() > 1);
+  TEST_ASSERT_EQUAL(20, part_ends.back());
+
+  std::vector<int> published = encode_parts(header, 7, records, part_ends, max_packet_size);
+  TEST_ASSERT_EQUAL(20, published.size());
+  for (int i = 0; i < 20; i++)
+    {
+      TEST_ASSERT_EQUAL(i, published[i]);
+    }
+}
+
+TEST_CASE("Batch publisher sends a small batch as one part", "[mqtt]")
+{
+  nlohmann::json header;
+  header["base_time"] = 1234;
+  std::vector<std::string> records = make_records(3, 10);
+
+  std::vector<std::size_t> part_ends = MqttBatchPublisher::partition(records, header, 4096);
+  TEST_ASSERT_EQUAL(1, part_ends.size());
+
+  std::vector<int> published = encode_parts(header, 0, records, part_ends, 4096);
+  TEST_ASSERT_EQUAL(3, published.size());
+}
+
+TEST_CASE("Batch publisher drops records larger than a packet", "[mqtt]")
+{
+  const std::size_t max_packet_size = 400;
+  nlohmann::json header;
+  header["base_time"] = 1234;
+  std::vector<std::string> records = make_records(5, 60);
+  records[2] = make_records(3, 500)[2];
+
+  std::vector<std::size_t> part_ends = MqttBatchPublisher::partition(records, header, max_packet_size);
+  TEST_ASSERT_EQUAL(4, records.size());
+
+  std::vector<int> published = encode_parts(header, 1, records, part_ends, max_packet_size);
+  TEST_ASSERT_EQUAL(4, published.size());
+  for (int i : published)
+    {
+      TEST_ASSERT_TRUE(i != 2);
+    }
+
+  // Nothing is left to publish when the only record is too large.
+  records = make_records(1, 500);
+  part_ends = MqttBatchPublisher::partition(records, header, max_packet_size);
+  TEST_ASSERT_TRUE(part_ends.empty());
+  TEST_ASSERT_TRUE(records.empty());
+}
+
+TEST_CASE("Batch publisher packet size is limited by the client", "[mqtt]")
+{
+  const std::string topic = "beacon/30aea4cc2c2a/scan";
+  auto loop = std::make_shared<loopp::core::MainLoop>();
+  auto mqtt = std::make_shared<loopp::mqtt::MqttClient>(loop, "test", "localhost", 1883);
+  auto publisher = std::make_shared<MqttBatchPublisher>(loop, mqtt, topic);
+
+  std::size_t limit = mqtt->get_max_payload_size(topic);
+  TEST_ASSERT_EQUAL(limit, publisher->get_max_packet_size());
+
+  publisher->set_max_packet_size(limit * 2);
+  TEST_ASSERT_EQUAL(limit, publisher->get_max_packet_size());
+
+  publisher->set_max_packet_size(1024);
+  TEST_ASSERT_EQUAL(1024, publisher->get_max_packet_size());
+}
@@ -0,0 +1,122 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "unity.h"
+
+#include "loopp/mqtt/MqttPacket.hpp"
+#include "loopp/net/StreamBuffer.hpp"
+
+using loopp::mqtt::MqttFrame;
+using loopp::mqtt::MqttPublishHeader;
+using loopp::net::StreamBuffer;
+
+namespace
+{
+  std::string make_publish(const std::string &topic, const std::string &payload)
+  {
+    MqttPublishHeader header(topic, 0, 0, payload.size());
+    return std::string(reinterpret_cast<const char *>(header.data()), header.size()) + payload;
+  }
+
+  MqttFrame::Status decode(const std::string &data, MqttFrame &frame)
+  {
+    return MqttFrame::decode(reinterpret_cast<const std::uint8_t *>(data.data()), data.size(), frame);
+  }
+} // namespace
+
+TEST_CASE("Frame decoder finds packet boundaries", "[mqtt]")
+{
+  MqttFrame frame;
+  std::string small = make_publish("a/b", "hello");
+  std::string large = make_publish("a/b", std::string(300, 'x'));
+
+  TEST_ASSERT_TRUE(decode(small, frame) == MqttFrame::Status::Complete);
+  TEST_ASSERT_EQUAL(0x30, frame.fixed_header);
+  TEST_ASSERT_EQUAL(2, frame.header_size);
+  TEST_ASSERT_EQUAL(small.size(), frame.size());
+
+  TEST_ASSERT_TRUE(decode(large, frame) == MqttFrame::Status::Complete);
+  TEST_ASSERT_EQUAL(3, frame.header_size);
+  TEST_ASSERT_EQUAL(2 + 3 + 300, frame.remaining_length);
+
+  TEST_ASSERT_TRUE(decode(large.substr(0, 2), frame) == MqttFrame::Status::Incomplete);
+  TEST_ASSERT_EQUAL(0, frame.header_size);
+  TEST_ASSERT_TRUE(decode(large.substr(0, 100), frame) == MqttFrame::Status::Incomplete);
+  TEST_ASSERT_EQUAL(large.size(), frame.size());
+
+  TEST_ASSERT_TRUE(decode(std::string("\xd0\x00", 2), frame) == MqttFrame::Status::Complete);
+  TEST_ASSERT_EQUAL(0, frame.remaining_length);
+
+  TEST_ASSERT_TRUE(decode(std::string("\x30\xff\xff\xff\xff\x01", 6), frame) == MqttFrame::Status::Invalid);
+}
+
+TEST_CASE("Frame decoder throughput with a flood of small publishes", "[mqtt][benchmark]")
+{
+  const std::size_t chunk_size = 512;
+  const int count = 200000;
+
+  std::string packet = make_publish("beacon/30aea4cc2c2a/cmd", "{\"on\":1}");
+  std::string stream;
+  for (int i = 0; i < count; i++)
+    {
+      stream += packet;
+    }
+
+  StreamBuffer buffer;
+  std::size_t offset = 0;
+  int packets = 0;
+  int reads = 0;
+  std::size_t payload_bytes = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  while (offset < stream.size())
+    {
+      // One socket read per wakeup, followed by all complete packets.
+      std::size_t n = std::min(chunk_size, stream.size() - offset);
+      std::copy(stream.data() + offset, stream.data() + offset + n, buffer.produce_data(n));
+      buffer.produce_commit(n);
+      offset += n;
+      reads++;
+
+      MqttFrame frame;
+      while (MqttFrame::decode(reinterpret_cast<const std::uint8_t *>(buffer.consume_data()), buffer.consume_size(), frame) ==
+             MqttFrame::Status::Complete)
+        {
+          buffer.consume_commit(frame.header_size);
+          payload_bytes += frame.remaining_length;
+          buffer.consume_commit(frame.remaining_length);
+          packets++;
+        }
+    }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%d packets of %d bytes in %d us: %d packets/s, %.3f reads/packet (was 3)\n", packets, static_cast<int>(packet.size()),
+         static_cast<int>(us), static_cast<int>(us > 0 ? packets * 1000000.0 / us : 0), static_cast<double>(reads) / packets);
+
+  TEST_ASSERT_EQUAL(count, packets);
+  TEST_ASSERT_EQUAL(count * (packet.size() - 2), payload_bytes);
+  TEST_ASSERT_EQUAL(0, buffer.consume_size());
+}
@@ -0,0 +1,185 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <cstdint>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/mqtt/MqttOutbox.hpp"
+
+using loopp::mqtt::MqttOutbox;
+
+namespace
+{
+  MqttOutbox::Message make_message(const std::string &topic, std::uint8_t qos = 1)
+  {
+    MqttOutbox::Message m;
+    m.topic = topic;
+    m.payload = std::make_shared<const std::string>("payload");
+    m.qos = qos;
+    return m;
+  }
+
+  // Number of broker round trips needed until 'count' QoS 1 messages are
+  // acknowledged. Every round trip the client fills the window and the
+  // broker acknowledges everything that was sent.
+  int simulate_round_trips(std::size_t window, int count)
+  {
+    MqttOutbox outbox(window);
+    int completed = 0;
+    for (int i = 0; i < count; i++)
+      {
+        MqttOutbox::Message m = make_message("t");
+        m.callback = [&completed](std::error_code) { completed++; };
+        outbox.push(std::move(m));
+      }
+
+    int round_trips = 0;
+    while (completed < count)
+      {
+        std::vector<std::uint16_t> sent;
+        while (MqttOutbox::Message *m = outbox.admit())
+          {
+            sent.push_back(m->id);
+          }
+        for (auto id : sent)
+          {
+            MqttOutbox::Message done;
+            outbox.complete(id, 1, done);
+            done.callback(std::error_code());
+          }
+        round_trips++;
+      }
+    return round_trips;
+  }
+} // namespace
+
+TEST_CASE("Outbox admits messages up to the window", "[mqtt]")
+{
+  MqttOutbox outbox(2);
+  outbox.push(make_message("a"));
+  outbox.push(make_message("b", 2));
+  outbox.push(make_message("c"));
+
+  MqttOutbox::Message *a = outbox.admit();
+  MqttOutbox::Message *b = outbox.admit();
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+  TEST_ASSERT_NULL(outbox.admit());
+  TEST_ASSERT_EQUAL(2, outbox.inflight_size());
+  TEST_ASSERT_EQUAL(1, outbox.queued_size());
+
+  TEST_ASSERT_TRUE(a->state == MqttOutbox::State::AwaitAck);
+  TEST_ASSERT_TRUE(b->state == MqttOutbox::State::AwaitRec);
+  TEST_ASSERT_TRUE(a->id != b->id);
+  TEST_ASSERT_TRUE(outbox.find(b->id) == b);
+
+  MqttOutbox::Message done;
+  std::uint16_t id = a->id;
+  TEST_ASSERT_FALSE(outbox.complete(id, 2, done));
+  TEST_ASSERT_TRUE(outbox.complete(id, 1, done));
+  TEST_ASSERT_EQUAL_STRING("a", done.topic.c_str());
+  TEST_ASSERT_FALSE(outbox.complete(id, 1, done));
+
+  MqttOutbox::Message *c = outbox.admit();
+  TEST_ASSERT_NOT_NULL(c);
+  TEST_ASSERT_EQUAL_STRING("c", c->topic.c_str());
+  TEST_ASSERT_EQUAL(0, outbox.queued_size());
+}
+
+TEST_CASE("Outbox walks QoS 2 messages through PUBREC and PUBCOMP", "[mqtt]")
+{
+  MqttOutbox outbox;
+  outbox.push(make_message("a", 2));
+  std::uint16_t id = outbox.admit()->id;
+
+  MqttOutbox::Message done;
+  TEST_ASSERT_FALSE(outbox.complete(id, 2, done));
+  TEST_ASSERT_TRUE(outbox.received(id));
+  TEST_ASSERT_TRUE(outbox.find(id)->state == MqttOutbox::State::AwaitComp);
+  TEST_ASSERT_FALSE(outbox.received(id + 1));
+  TEST_ASSERT_TRUE(outbox.complete(id, 2, done));
+  TEST_ASSERT_EQUAL(0, outbox.inflight_size());
+}
+
+TEST_CASE("Outbox packet ids skip zero and ids in flight", "[mqtt]")
+{
+  MqttOutbox outbox(4);
+  outbox.push(make_message("a"));
+  std::uint16_t held = outbox.admit()->id;
+
+  std::set<std::uint16_t> seen;
+  for (int i = 0; i < 0x10000; i++)
+    {
+      std::uint16_t id = outbox.allocate_id();
+      TEST_ASSERT_TRUE(id != 0);
+      TEST_ASSERT_TRUE(id != held);
+      seen.insert(id);
+    }
+  TEST_ASSERT_EQUAL(0xffff - 1, seen.size());
+}
+
+TEST_CASE("Outbox clear returns in-flight messages first", "[mqtt]")
+{
+  MqttOutbox outbox(1);
+  outbox.push(make_message("a"));
+  outbox.push(make_message("b"));
+  outbox.admit();
+
+  std::vector<MqttOutbox::Message> messages = outbox.clear();
+  TEST_ASSERT_EQUAL(2, messages.size());
+  TEST_ASSERT_EQUAL_STRING("a", messages[0].topic.c_str());
+  TEST_ASSERT_TRUE(messages[1].state == MqttOutbox::State::Queued);
+  TEST_ASSERT_EQUAL(0, outbox.inflight_size() + outbox.queued_size());
+}
+
+TEST_CASE("Outbox rejects an invalid window", "[mqtt]")
+{
+  MqttOutbox outbox;
+  bool thrown = false;
+  try
+    {
+      outbox.set_window(0);
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+  TEST_ASSERT_EQUAL(8, outbox.get_window());
+}
+
+TEST_CASE("Outbox window throughput with simulated round trips", "[mqtt][benchmark]")
+{
+  const int count = 256;
+  int serial = simulate_round_trips(1, count);
+  int window8 = simulate_round_trips(8, count);
+  int window32 = simulate_round_trips(32, count);
+
+  printf("round trips for %d messages: window 1: %d, window 8: %d, window 32: %d\n", count, serial, window8, window32);
+
+  TEST_ASSERT_EQUAL(count, serial);
+  TEST_ASSERT_EQUAL(count / 8, window8);
+  TEST_ASSERT_EQUAL(count / 32, window32);
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "unity.h"
+
+#include "loopp/mqtt/MqttPacket.hpp"
+
+using loopp::mqtt::MqttPacket;
+using loopp::mqtt::MqttPublishHeader;
+using loopp::mqtt::PacketType;
+
+namespace
+{
+  // Reference encoding through the stream based packet builder.
+  std::string encode_packet(const std::string &topic, std::uint8_t flags, std::uint16_t id, const std::string &payload)
+  {
+    MqttPacket pkt;
+    std::size_t id_size = id != 0 ? 2 : 0;
+    pkt.add_fixed_header(PacketType::Publish, flags);
+    pkt.add_length(topic.size() + 2 + id_size + payload.size());
+    pkt.add(topic);
+    if (id_size > 0)
+      {
+        pkt.add(static_cast<std::uint8_t>(id >> 8));
+        pkt.add(static_cast<std::uint8_t>(id & 0xff));
+      }
+    pkt.append(payload);
+    return std::string(pkt.get_buffer().consume_data(), pkt.size());
+  }
+
+  std::string encode_header(const std::string &topic, std::uint8_t flags, std::uint16_t id, const std::string &payload)
+  {
+    MqttPublishHeader header(topic, flags, id, payload.size());
+    return std::string(reinterpret_cast<const char *>(header.data()), header.size()) + payload;
+  }
+} // namespace
+
+TEST_CASE("Publish header matches the packet encoding", "[mqtt]")
+{
+  std::string payload(5000, 'x');
+  std::string long_topic(300, 't');
+
+  TEST_ASSERT_TRUE(encode_packet("a/b", 0, 0, "") == encode_header("a/b", 0, 0, ""));
+  TEST_ASSERT_TRUE(encode_packet("a/b", 0x01, 0, "hello") == encode_header("a/b", 0x01, 0, "hello"));
+  TEST_ASSERT_TRUE(encode_packet("beacon/scan", 0x0a, 0x1234, payload) == encode_header("beacon/scan", 0x0a, 0x1234, payload));
+  TEST_ASSERT_TRUE(encode_packet(long_topic, 0x02, 7, payload) == encode_header(long_topic, 0x02, 7, payload));
+
+  MqttPublishHeader header("beacon/scan", 0, 0, 5000);
+  TEST_ASSERT_EQUAL(1 + 2 + 2 + 11, header.size());
+}
+
+TEST_CASE("Publish header copies only the header bytes", "[mqtt][benchmark]")
+{
+  const std::string topic = "beacon/30aea4cc2c2a/scan";
+  const std::string payload(5 * 1024, 'x');
+  const int iterations = 2000;
+
+  std::size_t packet_copied = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    {
+      MqttPacket pkt;
+      pkt.add_fixed_header(PacketType::Publish, 0);
+      pkt.add_length(topic.size() + 2 + payload.size());
+      pkt.add(topic);
+      pkt.append(payload);
+      packet_copied += pkt.size();
+    }
+  auto packet_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  std::size_t header_copied = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    {
+      MqttPublishHeader header(topic, 0, 0, payload.size());
+      header_copied += header.size();
+    }
+  auto header_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+  printf("bytes copied per %d byte publish: packet %d, header %d; %d us vs %d us for %d publishes\n", static_cast<int>(payload.size()),
+         static_cast<int>(packet_copied / iterations), static_cast<int>(header_copied / iterations), static_cast<int>(packet_us),
+         static_cast<int>(header_us), iterations);
+
+  TEST_ASSERT_TRUE(packet_copied / iterations > payload.size());
+  TEST_ASSERT_TRUE(header_copied / iterations < 64);
+}
@@ -0,0 +1,158 @@
+// Copyright (C) 2018 Rob Caelers <rob.caelers@gmail.com>
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "unity.h"
+
+#include "loopp/mqtt/MqttTopicTrie.hpp"
+
+using loopp::mqtt::MqttTopicTrie;
+
+namespace
+{
+  // Inserts a filter whose callback records its name.
+  void add(MqttTopicTrie &trie, const std::string &filter, std::vector<std::string> &hits)
+  {
+    trie.insert(filter, [&hits, filter](const std::string &, const std::string &) { hits.push_back(filter); });
+  }
+
+  int count_matches(const MqttTopicTrie &trie, const std::string &topic)
+  {
+    std::vector<MqttTopicTrie::callback_t> callbacks;
+    trie.match(topic, callbacks);
+    return static_cast<int>(callbacks.size());
+  }
+} // namespace
+
+TEST_CASE("Topic trie matches literal and wildcard filters", "[mqtt]")
+{
+  MqttTopicTrie trie;
+  std::vector<std::string> hits;
+  add(trie, "a/b/c", hits);
+  add(trie, "a/+/c", hits);
+  add(trie, "a/#", hits);
+  add(trie, "+/+", hits);
+  add(trie, "#", hits);
+  add(trie, "a/b/", hits);
+  TEST_ASSERT_EQUAL(6, trie.size());
+
+  TEST_ASSERT_EQUAL(4, count_matches(trie, "a/b/c"));
+  TEST_ASSERT_EQUAL(3, count_matches(trie, "a/x/c"));
+  TEST_ASSERT_EQUAL(3, count_matches(trie, "a/b"));
+  TEST_ASSERT_EQUAL(2, count_matches(trie, "a"));
+  TEST_ASSERT_EQUAL(3, count_matches(trie, "a/b/"));
+  TEST_ASSERT_EQUAL(2, count_matches(trie, "x/y"));
+  TEST_ASSERT_EQUAL(1, count_matches(trie, "x/y/z"));
+  TEST_ASSERT_EQUAL(1, count_matches(trie, "ab/b/c"));
+
+  std::vector<MqttTopicTrie::callback_t> callbacks;
+  trie.match("a/b/c", callbacks);
+  for (auto &callback : callbacks)
+    {
+      callback("a/b/c", "");
+    }
+  TEST_ASSERT_EQUAL(4, hits.size());
+}
+
+TEST_CASE("Topic trie removes filters and replaces callbacks", "[mqtt]")
+{
+  MqttTopicTrie trie;
+  std::vector<std::string> hits;
+  add(trie, "a/+/c", hits);
+  add(trie, "a/+/c", hits);
+  add(trie, "a/b/#", hits);
+  TEST_ASSERT_EQUAL(2, trie.size());
+
+  TEST_ASSERT_FALSE(trie.remove("a/+"));
+  TEST_ASSERT_FALSE(trie.remove("a/b/c"));
+  TEST_ASSERT_TRUE(trie.remove("a/+/c"));
+  TEST_ASSERT_FALSE(trie.remove("a/+/c"));
+  TEST_ASSERT_EQUAL(1, count_matches(trie, "a/b/c"));
+  TEST_ASSERT_TRUE(trie.remove("a/b/#"));
+  TEST_ASSERT_EQUAL(0, count_matches(trie, "a/b/c"));
+  TEST_ASSERT_EQUAL(0, trie.size());
+}
+
+TEST_CASE("Topic trie rejects misplaced wildcards", "[mqtt]")
+{
+  TEST_ASSERT_TRUE(MqttTopicTrie::is_valid_filter("a/+/#"));
+  TEST_ASSERT_TRUE(MqttTopicTrie::is_valid_filter("+"));
+  TEST_ASSERT_FALSE(MqttTopicTrie::is_valid_filter("a/#/b"));
+  TEST_ASSERT_FALSE(MqttTopicTrie::is_valid_filter("a/b+"));
+  TEST_ASSERT_FALSE(MqttTopicTrie::is_valid_filter("a#"));
+
+  MqttTopicTrie trie;
+  bool thrown = false;
+  try
+    {
+      trie.insert("a/#/b", nullptr);
+    }
+  catch (std::runtime_error &)
+    {
+      thrown = true;
+    }
+  TEST_ASSERT_TRUE(thrown);
+  TEST_ASSERT_EQUAL(0, trie.size());
+}
+
+TEST_CASE("Topic trie dispatch with 1, 100 and 1000 filters", "[mqtt][benchmark]")
+{
+  const int lookups = 100000;
+  const int filter_counts[] = { 1, 100, 1000 };
+
+  for (int filter_count : filter_counts)
+    {
+      // Per-beacon command topics, like the GPIO driver's per-pin filters.
+      MqttTopicTrie trie;
+      int calls = 0;
+      for (int i = 0; i < filter_count; i++)
+        {
+          trie.insert("beacon/" + std::to_string(i) + "/cmd", [&calls](const std::string &, const std::string &) { calls++; });
+        }
+      trie.insert("beacon/+/config", [&calls](const std::string &, const std::string &) { calls++; });
+
+      std::vector<std::string> topics;
+      for (int i = 0; i < 16; i++)
+        {
+          topics.push_back("beacon/" + std::to_string(i * 7919 % filter_count) + "/cmd");
+        }
+
+      std::vector<MqttTopicTrie::callback_t> callbacks;
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < lookups; i++)
+        {
+          callbacks.clear();
+          trie.match(topics[i % topics.size()], callbacks);
+          for (auto &callback : callbacks)
+            {
+              callback("", "");
+            }
+        }
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+      printf("%4d filters: %d ns per dispatch\n", filter_count, static_cast<int>(us * 1000 / lookups));
+      TEST_ASSERT_EQUAL(lookups, calls);
+    }
+}
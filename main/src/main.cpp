@@ -26,11 +26,13 @@
 #include <functional>
 
 #include "loopp/ble/BLEScanner.hpp"
+#include "loopp/core/BootTimeline.hpp"
 #include "loopp/core/MainLoop.hpp"
 #include "loopp/core/Task.hpp"
 #include "loopp/drivers/DriverRegistry.hpp"
 
 #include "loopp/mqtt/MqttClient.hpp"
+#include "loopp/mqtt/MqttTimeSync.hpp"
 #include "loopp/net/Wifi.hpp"
 #include "loopp/ota/OTA.hpp"
 #include "loopp/utils/hexdump.hpp"
@@ -81,19 +83,20 @@ class Main
 {
 public:
   Main()
-    : ble_scanner(loopp::ble::BLEScanner::instance())
-    , wifi(loopp::net::Wifi::instance())
+    : wifi(loopp::net::Wifi::instance())
   {
 
     std::string mac = wifi.get_mac();
     topic_root = std::string(CONFIG_MQTT_TOPIC_PREFIX) + "/" + mac + "/";
     topic_command = topic_root + "command";
     topic_configuration = topic_root + "configuration";
+    topic_boot = topic_root + "boot";
 
     std::string client_id = std::string(CONFIG_MQTT_CLIENTID_PREFIX) + mac;
 
     loop = std::make_shared<loopp::core::MainLoop>();
     mqtt = std::make_shared<loopp::mqtt::MqttClient>(loop, client_id, CONFIG_MQTT_HOST, CONFIG_MQTT_PORT);
+    time_sync = std::make_shared<loopp::mqtt::MqttTimeSync>(loop, mqtt, std::string(CONFIG_MQTT_TOPIC_PREFIX) + "/time/request", topic_root + "time/response");
     task = std::make_shared<loopp::core::Task>("main_task", std::bind(&Main::main_task, this));
   }
 
@@ -135,11 +138,13 @@ private:
     if (connected)
       {
         ESP_LOGI(tag, "-> Wifi connected");
+        loopp::core::BootTimeline::instance().mark("wifi_connected");
         wifi_fail_count = 0;
 
         loop->cancel_timer(wifi_timeout_timer);
         mqtt->set_username(CONFIG_MQTT_USER);
         mqtt->set_password(CONFIG_MQTT_PASSWORD);
+        mqtt->set_max_inflight(CONFIG_MQTT_MAX_INFLIGHT);
 
 #ifdef CONFIG_MQTT_TLS
 #ifdef CONFIG_EMBEDDED_CERTIFICATES
@@ -166,6 +171,10 @@ private:
     if (connected)
       {
         ESP_LOGI(tag, "-> MQTT connected");
+        if (loopp::core::BootTimeline::instance().mark("mqtt_connected"))
+          {
+            publish_boot_timeline();
+          }
         ESP_LOGI(tag, "-> Subscribing to configuration at %s", topic_configuration.c_str());
         mqtt->subscribe(topic_configuration);
         mqtt->add_filter(topic_configuration,
@@ -174,10 +183,11 @@ private:
         mqtt->subscribe(topic_command);
         mqtt->add_filter(topic_command,
                          loopp::core::bind_loop(loop, [this](std::string topic, std::string payload) { on_remote_command(payload); }));
+        time_sync->start();
 
 #ifdef CONFIG_DEFAULT_BLE_SCANNER
         std::string name = "ble-scanner";
-        loopp::drivers::DriverContext context(loop, mqtt, topic_root);
+        loopp::drivers::DriverContext context(loop, mqtt, topic_root, time_sync);
         json config;
         std::shared_ptr<loopp::drivers::IDriver> driver = loopp::drivers::DriverRegistry::instance().create(name, context, config);
         if (driver)
@@ -191,9 +201,32 @@ private:
     else
       {
         ESP_LOGI(tag, "-> MQTT disconnected");
+        time_sync->stop();
+      }
+  }
+
+  void on_boot_phase(const std::string &phase)
+  {
+    // The timeline published on first connect cannot include the first
+    // scan, so publish it again once that is out.
+    if (phase == "scan_published")
+      {
+        publish_boot_timeline();
       }
   }
 
+  void publish_boot_timeline()
+  {
+    json timeline;
+    timeline["version"] = current_version;
+    timeline["phases"] = json::array();
+    for (const auto &phase : loopp::core::BootTimeline::instance().get_phases())
+      {
+        timeline["phases"].push_back({ { "phase", phase.name }, { "us", phase.time_us } });
+      }
+    mqtt->publish(topic_boot, timeline.dump(), loopp::mqtt::PublishOptions::Retain);
+  }
+
   void on_mqtt_data(const std::string &topic, const std::string &payload)
   {
     ESP_LOGI(tag, "-> MQTT %s -> %s (free %d)", topic.c_str(), payload.c_str(), heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
@@ -255,7 +288,7 @@ private:
         // Some drivers may have pending notifications that will keep it in memory
         // So invoke the next step asynchronously and give drivers a chance to close down.
         loop->invoke([this, top]() {
-          loopp::drivers::DriverContext context(loop, mqtt, topic_root);
+          loopp::drivers::DriverContext context(loop, mqtt, topic_root, time_sync);
           for (auto device_config : top.at("devices"))
             {
               std::string name = device_config["name"].get<std::string>();
@@ -399,7 +432,16 @@ private:
     wifi.system_event_signal().connect(loopp::core::bind_loop(loop, std::bind(&Main::on_wifi_system_event, this, std::placeholders::_1)));
     wifi.connected().connect(loopp::core::bind_loop(loop, std::bind(&Main::on_wifi_connected, this, std::placeholders::_1)));
     wifi_timeout_timer = loop->add_timer(std::chrono::milliseconds(5000), std::bind(&Main::on_wifi_timeout, this));
+    loopp::core::BootTimeline::instance().phase_signal().connect(
+      loopp::core::bind_loop(loop, std::bind(&Main::on_boot_phase, this, std::placeholders::_1)));
     wifi.connect();
+    loopp::core::BootTimeline::instance().mark("wifi_started");
+
+#ifdef CONFIG_BLE_EARLY_INIT
+    // Bluetooth init takes several hundred milliseconds; overlap it with
+    // WiFi association instead of delaying the first scan.
+    loopp::ble::BLEScanner::instance().prepare();
+#endif
 
     ESP_LOGI(tag, "Main::main_task memory free %d", heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
     heap_caps_print_heap_info(MALLOC_CAP_DEFAULT);
@@ -415,10 +457,10 @@ private:
   using Leds = loopp::led::LedStrip<loopp::led::WS28xxDriver, loopp::led::GridLayout, loopp::led::CurrentLimiter>;
 #endif
 
-  loopp::ble::BLEScanner &ble_scanner;
   loopp::net::Wifi &wifi;
   std::shared_ptr<loopp::core::MainLoop> loop;
   std::shared_ptr<loopp::mqtt::MqttClient> mqtt;
+  std::shared_ptr<loopp::mqtt::MqttTimeSync> time_sync;
   std::shared_ptr<loopp::core::Task> task;
 #ifdef LEDTEST
   std::shared_ptr<Leds> leds;
@@ -430,12 +472,14 @@ private:
   std::string topic_root;
   std::string topic_command;
   std::string topic_configuration;
+  std::string topic_boot;
   int count = 20;
 };
 
 extern "C" void
 app_main()
 {
+  loopp::core::BootTimeline::instance().mark("app_main");
   esp_err_t ret = nvs_flash_init();
   if (ret == ESP_ERR_NVS_NO_FREE_PAGES)
     {
@@ -443,6 +487,7 @@ app_main()
       ret = nvs_flash_init();
     }
   ESP_ERROR_CHECK(ret);
+  loopp::core::BootTimeline::instance().mark("nvs");
 
   ESP_LOGI(tag, "Version: %s", current_version);
   ESP_LOGI(tag, "HEAP: startup");